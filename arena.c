@@ -0,0 +1,115 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "arena.h"
+
+/* Alignment of every allocation: enough for the doubles and pointers in
+ * nodes and tables */
+#define ARENA_ALIGN 8
+
+/* A block's memory follows its header */
+struct arena_block{
+	struct arena_block *next;
+	size_t size;
+};
+
+/* A thread's released blocks, for its next arena */
+struct arena_spare{
+	struct arena_block *blocks;
+	size_t size;
+};
+
+static pthread_key_t spare_key;
+static pthread_once_t spare_once = PTHREAD_ONCE_INIT;
+
+static void free_blocks(struct arena_block *block){
+	struct arena_block *next;
+
+	for(; block != NULL; block = next){
+		next = block->next;
+		free(block);
+	}
+}
+
+/* Give the spare blocks back when their thread exits */
+static void spare_destroy(void *arg){
+	struct arena_spare *spare = (struct arena_spare *) arg;
+
+	free_blocks(spare->blocks);
+	free(spare);
+}
+
+static void spare_init(void){
+	pthread_key_create(&spare_key, spare_destroy);
+}
+
+static struct arena_spare *thread_spare(void){
+	struct arena_spare *spare;
+
+	pthread_once(&spare_once, spare_init);
+	if((spare = (struct arena_spare *) pthread_getspecific(spare_key)) == NULL){
+		spare = (struct arena_spare *) calloc(1, sizeof *spare);
+		pthread_setspecific(spare_key, spare);
+	}
+	return spare;
+}
+
+/* Start a new block with room for at least size bytes, reusing a spare
+ * one if it is big enough */
+static void new_block(struct arena *a, size_t size){
+	struct arena_spare *spare = thread_spare();
+	struct arena_block *block;
+
+	if(size < ARENA_BLOCK_SIZE)
+		size = ARENA_BLOCK_SIZE;
+
+	if((block = spare->blocks) != NULL && block->size >= size){
+		spare->blocks = block->next;
+		spare->size -= block->size;
+	}
+	else{
+		block = (struct arena_block *) malloc(sizeof(struct arena_block) + size);
+		block->size = size;
+	}
+
+	block->next = a->blocks;
+	a->blocks = block;
+	if(a->oldest == NULL)
+		a->oldest = block;
+	a->size += block->size;
+	a->pos = (char *) (block + 1);
+	a->left = block->size;
+}
+
+void *arena_alloc(struct arena *a, size_t size){
+	void *p;
+
+	size = (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+	if(a->left < size)
+		new_block(a, size);
+
+	p = a->pos;
+	a->pos += size;
+	a->left -= size;
+	a->used += size;
+	return p;
+}
+
+void arena_release(struct arena *a){
+	struct arena_spare *spare;
+
+	if(a->blocks != NULL){
+		spare = thread_spare();
+		if(spare->size + a->size <= ARENA_SPARE_MAX){
+			/* Hand the whole chain over in one go */
+			a->oldest->next = spare->blocks;
+			spare->blocks = a->blocks;
+			spare->size += a->size;
+		}
+		else
+			free_blocks(a->blocks);
+	}
+
+	memset(a, 0, sizeof *a);
+}
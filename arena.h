@@ -0,0 +1,39 @@
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <stddef.h>
+
+/*
+ * Bump allocator for what a compile builds and drops together: the
+ * interned names and the symbol tables. Allocating moves a pointer
+ * through a block; nothing is freed on its own, the whole arena is
+ * released at once when the compile is done.
+ *
+ * Released blocks are kept, up to ARENA_SPARE_MAX bytes per thread, for
+ * the next arena on the same thread, so a thread that compiles request
+ * after request stops calling malloc() once it has warmed up.
+ */
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_SPARE_MAX (4 * 1024 * 1024)
+
+struct arena_block;
+
+struct arena{
+	struct arena_block *blocks;	/* newest first */
+	struct arena_block *oldest;
+	size_t size;			/* of all the blocks */
+	size_t used;			/* bytes handed out */
+	char *pos;
+	size_t left;
+};
+
+/* size bytes, suitably aligned for any table, and not cleared.
+ * Valid until arena_release(). */
+void *arena_alloc(struct arena *a, size_t size);
+
+/* Release everything allocated from a, leaving it empty and ready for
+ * the next compile. Takes constant time unless the thread's spare
+ * blocks are full. */
+void arena_release(struct arena *a);
+
+#endif /* _ARENA_H */
@@ -7,68 +7,141 @@
 #include "ast.h"
 #include "symbol.h"
 #include "common.h"
+#include "session.h"
 #include "parser.tab.h"
 
 #define DEBUG_PRINT_TREE 0
 
-node *ast = NULL;
+/* Double an array's capacity */
+static void *ast_grow(void *array, unsigned int *max, size_t size) {
+  *max = *max ? 2 * *max : 256;
+  return realloc(array, *max * size);
+}
+
+/* Room for num more items, returning the index of the first */
+static unsigned int ast_add_items(struct ast_tree *tree, unsigned int num) {
+  unsigned int first = tree->num_items;
+
+  while (tree->num_items + num > tree->max_items)
+    tree->items = (node_t *) ast_grow(tree->items, &tree->max_items, sizeof(node_t));
+  tree->num_items += num;
+  return first;
+}
+
+/* Move the list started at mark from pending into items, which keeps
+ * each list in one run */
+static unsigned int ast_take(struct ast_tree *tree, unsigned int mark, unsigned int *num) {
+  unsigned int first;
+
+  *num = tree->num_pending - mark;
+  first = ast_add_items(tree, *num);
+  if (*num)
+    memcpy(tree->items + first, tree->pending + mark, *num * sizeof(node_t));
+  tree->num_pending = mark;
+  return first;
+}
+
+/* Number a symbol table entry */
+static unsigned int ast_add_symbol(struct ast_tree *tree, const struct st_entry *ste) {
+  if (tree->num_symbols == tree->max_symbols)
+    tree->symbols = (const struct st_entry **) ast_grow(tree->symbols, &tree->max_symbols, sizeof(struct st_entry *));
+  tree->symbols[tree->num_symbols] = ste;
+  return tree->num_symbols++;
+}
+
+unsigned int ast_mark(compile_session_t *cs) {
+  return cs->ast.num_pending;
+}
+
+void ast_push(compile_session_t *cs, node_t item) {
+  struct ast_tree *tree = &cs->ast;
+
+  if (tree->num_pending == tree->max_pending)
+    tree->pending = (node_t *) ast_grow(tree->pending, &tree->max_pending, sizeof(node_t));
+  tree->pending[tree->num_pending++] = item;
+}
 
-node *ast_allocate(node_kind kind, ...) {
+node_t ast_allocate(compile_session_t *cs, node_kind kind, ...) {
+  struct ast_tree *tree = &cs->ast;
+  struct ast_node *ast;
+  struct ast_scope *scope;
+  struct st_entry *ste;
+  unsigned int dclns, stmts, num;
+  node_t n;
   va_list args;
 
   // make the node
-  node *ast = (node *) malloc(sizeof(node));
+  if (tree->num_nodes + 1 >= tree->max_nodes) {
+    num = tree->max_nodes;
+    tree->nodes = (struct ast_node *) ast_grow(tree->nodes, &tree->max_nodes, sizeof(struct ast_node));
+    tree->types = (unsigned short *) ast_grow(tree->types, &num, sizeof(unsigned short));
+  }
+  if (tree->num_nodes == 0) {
+    /* Node 0 is AST_NIL */
+    memset(&tree->nodes[0], 0, sizeof tree->nodes[0]);
+    tree->types[0] = 0;
+    tree->num_nodes = 1;
+
+    /* Symbol 0 is none, the pre-defined variables come next */
+    ast_add_symbol(tree, NULL);
+    for (num = 0; num < NUM_BUILTIN_VARS; num++)
+      ast_add_symbol(tree, st_builtin(num));
+  }
+  n = tree->num_nodes++;
+  ast = &tree->nodes[n];
   memset(ast, 0, sizeof *ast);
+  tree->types[n] = 0;
+  cs->stats.nodes++;
   ast->kind = kind;
-  ast->st = st_curr;
 
   va_start(args, kind); 
 
   switch(kind) {
 
-  case DECLARATIONS_NODE:
-    ast->declarations.declarations = va_arg(args, node *);
-    ast->declarations.declaration = va_arg(args, node *);
-    break;
-
   case DECLARATION_NODE:
-    ast->declaration.var_name = strdup(va_arg(args, char *));
-    ast->declaration.init_val = va_arg(args, node *);
-    break;
-
-  case STATEMENTS_NODE:
-    ast->statements.statements = va_arg(args, node *);
-    ast->statements.statement = va_arg(args, node *);
+    ste = va_arg(args, struct st_entry *);
+    ste->sym = ast_add_symbol(tree, ste);
+    ast->declaration.sym = ste->sym;
+    ast->declaration.init_val = va_arg(args, node_t);
     break;
 
   /* Start statement nodes */
   case ASSIGNMENT_NODE:
-    ast->assign_stmt.var = va_arg(args, node *);
-    ast->assign_stmt.new_val = va_arg(args, node *);
+    ast->assign_stmt.var = va_arg(args, node_t);
+    ast->assign_stmt.new_val = va_arg(args, node_t);
     break;
  
   case IF_STATEMENT_NODE:
-    ast->if_stmt.expr = va_arg(args, node *);
-    ast->if_stmt.stmt = va_arg(args, node *);
-    ast->if_stmt.opt_stmt = va_arg(args, node *);  
+    ast->if_stmt.expr = va_arg(args, node_t);
+    ast->if_stmt.branches = ast_add_items(tree, 2);
+    tree->items[ast->if_stmt.branches] = va_arg(args, node_t);
+    tree->items[ast->if_stmt.branches + 1] = va_arg(args, node_t);
   break;
  
   case SCOPE_NODE:
-    ast->scope.declarations = va_arg(args, node *);
-    ast->scope.statements = va_arg(args, node *);
+    dclns = va_arg(args, unsigned int);
+    stmts = va_arg(args, unsigned int);
+    if (tree->num_scopes == tree->max_scopes)
+      tree->scopes = (struct ast_scope *) ast_grow(tree->scopes, &tree->max_scopes, sizeof(struct ast_scope));
+    ast->scope.index = tree->num_scopes++;
+    scope = &tree->scopes[ast->scope.index];
+    scope->st = cs->st_curr;
+    scope->num_dclns = stmts - dclns;
+    scope->first = ast_take(tree, dclns, &num);
+    scope->num_stmts = num - scope->num_dclns;
     break;
   /* End statement nodes */
 
   /* Start expression nodes */
   case UNARY_EXPRESSION_NODE:
-    ast->unary_expr.op = va_arg(args, int);
-    ast->unary_expr.expr = va_arg(args, node *);
+    ast->op = va_arg(args, int);
+    ast->unary_expr.expr = va_arg(args, node_t);
     break;
 
   case BINARY_EXPRESSION_NODE:
-    ast->binary_expr.op = va_arg(args, int);
-    ast->binary_expr.left = va_arg(args, node *);
-    ast->binary_expr.right = va_arg(args, node *);
+    ast->op = va_arg(args, int);
+    ast->binary_expr.left = va_arg(args, node_t);
+    ast->binary_expr.right = va_arg(args, node_t);
     break;
 
   case BOOL_NODE:
@@ -80,139 +153,178 @@ node *ast_allocate(node_kind kind, ...) {
     break;
 
   case FLOAT_NODE:
-    ast->float_lit.value = va_arg(args, double);
+    ast->float_lit.value = (float) va_arg(args, double);
     break;
 
   case VAR_NODE:
-    ast->var.name = strdup(va_arg(args, char *));
-    ast->var.ofs = va_arg(args, int);
+    ast->var.id = va_arg(args, ident_t);
+    ast->op = va_arg(args, int);
+    ast->var.sym = 0;
     break;
 
   case FUNCTION_NODE:
-	ast->function.func = (func_t)va_arg(args, int);
-	ast->function.args_opt = va_arg(args, node *);
-	break;
-
   case CONSTRUCTOR_NODE:
-	ast->constructor.type = (type_t)va_arg(args, int);
-	ast->constructor.args_opt = va_arg(args, node *);
+	/* func_t or type_t */
+	ast->op = va_arg(args, int);
+	ast->args.first = ast_take(tree, va_arg(args, unsigned int), &ast->args.num);
 	break;
   /* End expression nodes */
 
-  case ARGUMENTS_NODE:
-    ast->arguments.args = va_arg(args, node *);
-    ast->arguments.expr = va_arg(args, node *);
-    break;
-
   default:
-    fprintf(outputFile, "ast_allocate: Unsupported node kind.\n"); 
+    fprintf(cs->outputFile, "ast_allocate: Unsupported node kind.\n"); 
     break;
   }
 
   va_end(args);
 
-  return ast;
+  return n;
+}
+
+void ast_free(compile_session_t *cs) {
+	struct ast_tree *tree = &cs->ast;
+
+	free(tree->nodes);
+	free(tree->types);
+	free(tree->items);
+	free(tree->pending);
+	free(tree->scopes);
+	free(tree->symbols);
+	memset(tree, 0, sizeof *tree);
 }
 
-void ast_free(node *ast) {
+unsigned int ast_num_children(compile_session_t *cs, node_t n) {
+	struct ast_node *ast = AST_NODE(cs, n);
+
+	switch(ast->kind){
+	  case UNARY_EXPRESSION_NODE:
+	  case DECLARATION_NODE:
+		return 1;
+	  case BINARY_EXPRESSION_NODE:
+	  case ASSIGNMENT_NODE:
+		return 2;
+	  case IF_STATEMENT_NODE:
+		return 3;
+	  case FUNCTION_NODE:
+	  case CONSTRUCTOR_NODE:
+		return ast->args.num;
+	  case SCOPE_NODE:
+		return AST_SCOPE(cs, n)->num_dclns + AST_SCOPE(cs, n)->num_stmts;
+	  default:
+		return 0;
+	}
+}
+
+node_t ast_child(compile_session_t *cs, node_t n, unsigned int i) {
+	struct ast_node *ast = AST_NODE(cs, n);
+
 	switch(ast->kind){
-			case SCOPE_NODE:
-				if(ast->scope.declarations != NULL)
-					ast_free(ast->scope.declarations); 
-				if(ast->scope.statements != NULL)
-					ast_free(ast->scope.statements);
-				free(ast);
-				break;
-			case DECLARATIONS_NODE:
-				if(ast->declarations.declarations != NULL)
-					ast_free(ast->declarations.declarations); 
-				ast_free(ast->declarations.declaration);
-				free(ast);
-				break;
-			case STATEMENTS_NODE:
-				if(ast->statements.statements != NULL)
-					ast_free(ast->statements.statements);
-				ast_free(ast->statements.statement);
-				free(ast);
-				break;
-			case DECLARATION_NODE:
-				if(ast->declaration.init_val != NULL)
-					ast_free(ast->declaration.init_val);
-				free(ast);
-				break;
-			case ASSIGNMENT_NODE:
-				ast_free(ast->assign_stmt.var);
-				ast_free(ast->assign_stmt.new_val);
-				free(ast);
-				break;
-			case UNARY_EXPRESSION_NODE:
-				ast_free(ast->unary_expr.expr);
-				free(ast);
-				break;
-			case BINARY_EXPRESSION_NODE:
-				ast_free(ast->binary_expr.left);
-				ast_free(ast->binary_expr.right);
-				free(ast);
-				break;
-			case BOOL_NODE:
-				free(ast); //this works since there's no AST nodes, assuming free will free all non node members
-				break;
-			case INT_NODE:
-				free(ast);
-				break;
-			case FLOAT_NODE:
-				free(ast);
-				break;
-			case VAR_NODE:
-				free(ast); //double check this
-				break;
-			case FUNCTION_NODE:
-				if(ast->function.args_opt != NULL)				
-					ast_free(ast->function.args_opt);
-				free(ast);
-				break;
-			case CONSTRUCTOR_NODE:
-				if(ast->constructor.args_opt != NULL)
-					ast_free(ast->constructor.args_opt);
-				free(ast);
-				break;
-			case IF_STATEMENT_NODE:
-				ast_free(ast->if_stmt.expr);
-				ast_free(ast->if_stmt.stmt);
-				if(ast->if_stmt.opt_stmt != NULL)
-					ast_free(ast->if_stmt.opt_stmt);
-				free(ast);
-				break;
-			case ARGUMENTS_NODE:
-				if(ast->arguments.args != NULL)				
-					ast_free(ast->arguments.args);
-				ast_free(ast->arguments.expr);
-				free(ast);
-				break;
-			default:
-				fprintf(outputFile, "ast_free: Warning: Unexpected node kind.\n");
-				break;
+	  case UNARY_EXPRESSION_NODE:
+		return ast->unary_expr.expr;
+	  case BINARY_EXPRESSION_NODE:
+		return i == 0 ? ast->binary_expr.left : ast->binary_expr.right;
+	  case FUNCTION_NODE:
+	  case CONSTRUCTOR_NODE:
+		return AST_ITEM(cs, ast->args.first + i);
+	  case ASSIGNMENT_NODE:
+		return i == 0 ? ast->assign_stmt.var : ast->assign_stmt.new_val;
+	  case IF_STATEMENT_NODE:
+		return i == 0 ? ast->if_stmt.expr : AST_ITEM(cs, ast->if_stmt.branches + i - 1);
+	  case SCOPE_NODE:
+		return AST_ITEM(cs, AST_SCOPE(cs, n)->first + i);
+	  case DECLARATION_NODE:
+		return ast->declaration.init_val;
+	  default:
+		return AST_NIL;
+	}
+}
+
+void *ast_stack_push(struct ast_stack *stack, size_t size) {
+	void *top;
+
+	if (stack->len + size > stack->size) {
+		stack->size = stack->size ? 2 * stack->size : 4096;
+		while (stack->len + size > stack->size)
+			stack->size *= 2;
+		stack->base = (char *) realloc(stack->base, stack->size);
+	}
+	top = stack->base + stack->len;
+	stack->len += size;
+	return top;
+}
+
+void *ast_stack_pop(struct ast_stack *stack, size_t size) {
+	assert(stack->len >= size);
+	stack->len -= size;
+	return stack->base + stack->len;
+}
+
+void ast_stack_free(struct ast_stack *stack) {
+	free(stack->base);
+	memset(stack, 0, sizeof *stack);
+}
+
+/* A node on the path from the root, and the next child to visit */
+struct ast_frame {
+	node_t n;
+	unsigned int next;
+	unsigned int num;
+};
+
+void ast_walk(compile_session_t *cs, node_t root, const struct ast_visitor *visitor) {
+	struct ast_stack path = { NULL, 0, 0 };
+	struct ast_frame *frame;
+	node_t n, parent;
+	unsigned int i;
+
+	for (n = root; n != AST_NIL; ) {
+		/* Go down into n */
+		if (visitor->pre == NULL || visitor->pre(cs, n, visitor->arg)) {
+			frame = (struct ast_frame *) ast_stack_push(&path, sizeof *frame);
+			frame->n = n;
+			frame->next = 0;
+			frame->num = ast_num_children(cs, n);
+		}
+
+		/* Then on to the next child along the path, finishing the
+		 * nodes that have none left on the way up */
+		for (n = AST_NIL; n == AST_NIL && path.len > 0; ) {
+			frame = (struct ast_frame *) (path.base + path.len) - 1;
+			if (frame->next == frame->num) {
+				parent = frame->n;
+				ast_stack_pop(&path, sizeof *frame);
+				if (visitor->post)
+					visitor->post(cs, parent, visitor->arg);
+				continue;
+			}
+			i = frame->next++;
+			if (visitor->child == NULL || visitor->child(cs, frame->n, i, visitor->arg))
+				n = ast_child(cs, frame->n, i);
+		}
 	}
+
+	ast_stack_free(&path);
 }
 
-/* These two flags are used to print things properly */
-static int dclns_flag = 0;
-static int stmts_flag = 0;
+/* The types by index, the order of type_strings */
+const type_t type_values[NUM_TYPES] = {
+	INT, IVEC2, IVEC3, IVEC4,
+	FLOAT, VEC2, VEC3, VEC4,
+	BOOL, BVEC2, BVEC3, BVEC4,
+	ANY
+};
+
+/* The index of each type by its value modulo 21, which tells them all
+ * apart; the slots no type falls in say any */
+static const unsigned char type_indices[21] = {
+	12, 12, 4, 7, 12, 12, 11, 12, 0, 1, 2,
+	8, 3, 6, 12, 9, 12, 12, 5, 10, 12
+};
 
 int print_type_index(type_t type){
-	if(type == INT) return 0;
-	if(type == IVEC2) return 1;
-	if(type == IVEC3) return 2;
-	if(type == IVEC4) return 3;
-	if(type == FLOAT) return 4;
-        if(type == VEC2) return 5;
-        if(type == VEC3) return 6;
-        if(type == VEC4) return 7;
-        if(type == BOOL) return 8;
-        if(type == BVEC2) return 9;
-        if(type == BVEC3) return 10;
-        if(type == BVEC4) return 11;
-	return 12;
+	int index = type_indices[(unsigned int) type % 21];
+
+	/* Anything else prints as any */
+	return type_values[index] == type ? index : 12;
 }
 
 const char * type_strings[NUM_TYPES] = {
@@ -279,183 +391,116 @@ const char * func_strings[NUM_FUNCS + 1] = {
 	"garbage func"
 };
 
-// forward declare for ast_print_args
-static void ast_print_expr(node *);
-
-static void ast_print_args(node *ast){
-
-	assert(ast != NULL);
-	assert(ast->kind & ARGUMENTS_NODE);
-
-	if(ast->arguments.args != NULL)
-		ast_print_args(ast->arguments.args);
-	ast_print_expr(ast->arguments.expr);
-
-	return;
-}
-
-static void ast_print_expr(node *ast){
-
-	assert(ast != NULL);
-	assert(ast->kind & EXPRESSION_NODE);
+static int ast_print_pre(compile_session_t *cs, node_t n, void *arg){
+	struct ast_node *ast = AST_NODE(cs, n);
+	const struct st_entry *ste;
+	node_t var;
 
 	switch(ast->kind){
 	  case UNARY_EXPRESSION_NODE:
-		fprintf(outputFile, "UNARY\n");
-		fprintf(outputFile, "type: %s\n", type_strings[print_type_index(ast->unary_expr.type)]);
-		fprintf(outputFile, "op: %c\n", (char)ast->unary_expr.op);
-		ast_print_expr(ast->unary_expr.expr);
+		fprintf(cs->outputFile, "UNARY\n");
+		fprintf(cs->outputFile, "type: %s\n", type_strings[print_type_index(AST_TYPE(cs, n))]);
+		fprintf(cs->outputFile, "op: %c\n", (char)ast->op);
 		break;
 	  case BINARY_EXPRESSION_NODE:
-		fprintf(outputFile, "BINARY\n");
-		fprintf(outputFile, "type: %s\n", type_strings[print_type_index(ast->binary_expr.type)]);
-		fprintf(outputFile, "op: %s\n", bop_strings[print_bop_index(ast->binary_expr.op)]);
-		ast_print_expr(ast->binary_expr.left);
-		ast_print_expr(ast->binary_expr.right);
+		fprintf(cs->outputFile, "BINARY\n");
+		fprintf(cs->outputFile, "type: %s\n", type_strings[print_type_index(AST_TYPE(cs, n))]);
+		fprintf(cs->outputFile, "op: %s\n", bop_strings[print_bop_index(ast->op)]);
 		break;
 	  case BOOL_NODE:
-                fprintf(outputFile, "%s\n", ast->bool_lit.value ? "true" : "false");
+                fprintf(cs->outputFile, "%s\n", ast->bool_lit.value ? "true" : "false");
                 break;
 	  case INT_NODE:
-		fprintf(outputFile, "%d\n", ast->int_lit.value);
+		fprintf(cs->outputFile, "%d\n", ast->int_lit.value);
 		break;
 	  case FLOAT_NODE:
-                fprintf(outputFile, "%f\n", ast->float_lit.value);
+                fprintf(cs->outputFile, "%f\n", ast->float_lit.value);
                 break;
 	  case VAR_NODE:
-		if(ast->var.ofs == -1)
-			fprintf(outputFile, "%s\n", ast->var.name);
-		else fprintf(outputFile, "%s[%d]\n", ast->var.name, ast->var.ofs);
+		if(ast->op == -1)
+			fprintf(cs->outputFile, "%s\n", ident_name(cs, ast->var.id));
+		else fprintf(cs->outputFile, "%s[%d]\n", ident_name(cs, ast->var.id), ast->op);
 		break;
 	  case FUNCTION_NODE:
-		fprintf(outputFile, "CALL\n");
-		fprintf(outputFile, "function name: %s\n", func_strings[print_func_index(ast->function.func)]);
-		if(ast->function.args_opt != NULL)
-			ast_print_args(ast->function.args_opt);
+		fprintf(cs->outputFile, "CALL\n");
+		fprintf(cs->outputFile, "function name: %s\n", func_strings[print_func_index((func_t)ast->op)]);
 		break;
 	  case CONSTRUCTOR_NODE:
-		fprintf(outputFile, "CALL\n");
-		fprintf(outputFile, "constructor type: %s\n", type_strings[print_type_index(ast->constructor.type)]);
-		if(ast->constructor.args_opt != NULL)
-			ast_print_args(ast->constructor.args_opt);
-		break;
-	  default:
-		fprintf(outputFile, "ast_print_expr: Unsupported expression type.\n");
+		fprintf(cs->outputFile, "CALL\n");
+		fprintf(cs->outputFile, "constructor type: %s\n", type_strings[print_type_index((type_t)ast->op)]);
 		break;
-	}
-	
-	return;
-}
-
-/* forward declare for ast_print_stmt */
-static void ast_print_dclns(node *);
-static void ast_print_stmts(node *);
-
-static void ast_print_stmt(node *ast){
-	struct st_entry *ste;
-	
-	if(ast == NULL) return;
-	assert(ast->kind & STATEMENT_NODE);
-
-	switch(ast->kind){
           case ASSIGNMENT_NODE:
-                fprintf(outputFile, "ASSIGN\n");
-		ste = st_lookup(ast->st, ast->assign_stmt.var->var.name, GLOBAL);
+                fprintf(cs->outputFile, "ASSIGN\n");
+		var = ast->assign_stmt.var;
+		ste = AST_SYMBOL(cs, AST_NODE(cs, var)->var.sym);
 		if(ste == NULL){
 			/* Variable undeclared */
-			fprintf(outputFile, "type: any\n");
-		} else fprintf(outputFile, "type: %s\n", type_strings[print_type_index(ste->type)]);
-		fprintf(outputFile, "var_name: ");
-		if(ast->assign_stmt.var->var.ofs == -1)
-			fprintf(outputFile, "%s\n", ast->assign_stmt.var->var.name);
-		else fprintf(outputFile, "%s[%d]\n", ast->assign_stmt.var->var.name, ast->assign_stmt.var->var.ofs);
-		ast_print_expr(ast->assign_stmt.new_val);
+			fprintf(cs->outputFile, "type: any\n");
+		} else fprintf(cs->outputFile, "type: %s\n", type_strings[print_type_index(ste->type)]);
+		fprintf(cs->outputFile, "var_name: ");
+		if(AST_NODE(cs, var)->op == -1)
+			fprintf(cs->outputFile, "%s\n", ident_name(cs, AST_NODE(cs, var)->var.id));
+		else fprintf(cs->outputFile, "%s[%d]\n", ident_name(cs, AST_NODE(cs, var)->var.id), AST_NODE(cs, var)->op);
                 break;
 	  case IF_STATEMENT_NODE:
-		fprintf(outputFile, "IF\n");
-		ast_print_expr(ast->if_stmt.expr);
-		ast_print_stmt(ast->if_stmt.stmt);
-		if(ast->if_stmt.opt_stmt != NULL)
-			ast_print_stmt(ast->if_stmt.opt_stmt);
+		fprintf(cs->outputFile, "IF\n");
 		break;
 	  case SCOPE_NODE:
-		fprintf(outputFile, "SCOPE\n");
-		/* Reset print flags */
-		dclns_flag = 0;
-		stmts_flag = 0;
-		ast_print_dclns(ast->scope.declarations);
-		ast_print_stmts(ast->scope.statements);
-		fprintf(outputFile, "END SCOPE\n");
+		fprintf(cs->outputFile, "SCOPE\n");
+		fprintf(cs->outputFile, "DECLARATIONS\n");
+		break;
+	  case DECLARATION_NODE:
+		fprintf(cs->outputFile, "DECLARATION\n");
+		ste = AST_SYMBOL(cs, ast->declaration.sym);
+		fprintf(cs->outputFile, "var_name: %s\n", ste->var_name);
+		fprintf(cs->outputFile, "type_name: %s\n", type_strings[print_type_index(ste->type)]);
+		if(ast->declaration.init_val != AST_NIL)
+			fprintf(cs->outputFile, "init_val: \n");
+		break;
+	  default:
+		fprintf(cs->outputFile, "ast_print: Unsupported node kind.\n");
 		break;
-          default:
-                fprintf(outputFile, "ast_print_expr: Unsupported statement type.\n");
-                break;
-        }
-
-	return;
-}
-
-static void ast_print_dcln(node *ast){
-	struct st_entry *ste;	
-
-	assert(ast != NULL);
-	assert(ast->kind == DECLARATION_NODE);
-	fprintf(outputFile, "DECLARATION\n");
-	
-	fprintf(outputFile, "var_name: %s\n", ast->declaration.var_name);
-	ste = st_lookup(ast->st, ast->declaration.var_name, GLOBAL);
-	if(ste == NULL){
-		/* Variable undeclared - this should not happen */
-		fprintf(outputFile, "type_name: any (ERROR)\n"); 
-	} else fprintf(outputFile, "type_name: %s\n", type_strings[print_type_index(ste->type)]);
-	if(ast->declaration.init_val != NULL){
-		fprintf(outputFile, "init_val: \n");
-		ast_print_expr(ast->declaration.init_val);
 	}
 
-	return;
+	return 1;
 }
 
-static void ast_print_stmts(node *ast){
-	
-	if(stmts_flag == 0){
-		fprintf(outputFile, "STATEMENTS\n");
-		stmts_flag = 1;
-	}
-
-	if(ast == NULL) return;
-	assert(ast->kind == STATEMENTS_NODE);
+static int ast_print_child(compile_session_t *cs, node_t n, unsigned int i, void *arg){
+	struct ast_node *ast = AST_NODE(cs, n);
 
-	ast_print_stmts(ast->statements.statements);
-	ast_print_stmt(ast->statements.statement);
+	/* The assigned variable is already on the ASSIGN's var_name line */
+	if(ast->kind == ASSIGNMENT_NODE && i == 0)
+		return 0;
+	if(ast->kind == SCOPE_NODE && i == AST_SCOPE(cs, n)->num_dclns)
+		fprintf(cs->outputFile, "STATEMENTS\n");
 
-	return;
+	return 1;
 }
 
-static void ast_print_dclns(node *ast){
-	
-	if(dclns_flag == 0){
-		fprintf(outputFile, "DECLARATIONS\n");
-		dclns_flag = 1;
+static void ast_print_post(compile_session_t *cs, node_t n, void *arg){
+	struct ast_scope *scope;
+
+	if(AST_NODE(cs, n)->kind == SCOPE_NODE){
+		scope = AST_SCOPE(cs, n);
+		/* No statement to print the heading before */
+		if(scope->num_stmts == 0)
+			fprintf(cs->outputFile, "STATEMENTS\n");
+		fprintf(cs->outputFile, "END SCOPE\n");
 	}
-	
-	if(ast == NULL) return;
-	assert(ast->kind == DECLARATIONS_NODE);	
 
-	ast_print_dclns(ast->declarations.declarations);
-	ast_print_dcln(ast->declarations.declaration);
-	
 	return;
 }
 
-/* Print to stdout for now */
-void ast_print(node *ast) {
+/* Print to stdout for now. Variables are printed with the symbols
+ * semantic analysis resolved them to. */
+void ast_print(compile_session_t *cs, node_t ast) {
+	struct ast_visitor printer = { ast_print_pre, ast_print_child, ast_print_post, NULL };
 
-	assert(ast != NULL);
-	assert(ast->kind == SCOPE_NODE);
+	assert(ast != AST_NIL);
+	assert(AST_NODE(cs, ast)->kind == SCOPE_NODE);
 	
 	/* Expecting a scope, which is a statement */
-	ast_print_stmt(ast);
+	ast_walk(cs, ast, &printer);
 
 	return;
 }
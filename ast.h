@@ -1,4 +1,3 @@
-
 #ifndef AST_H_
 #define AST_H_ 1
 
@@ -17,137 +16,216 @@
 
 #define MAX_TYPE_LEN 10
 
-// forward declare
-struct node_;
-typedef struct node_ node;
-extern node *ast;
+/*
+ * Nodes are kept in one array per compile and refer to each other by
+ * their index in it, a node_t. Index 0 is never a node, AST_NIL stands
+ * for none (an empty statement, a missing else).
+ */
+typedef unsigned int node_t;
+
+#define AST_NIL 0
 
 typedef enum {
   UNKNOWN               = 0,
 
-  EXPRESSION_NODE       = (1 << 2),
-  UNARY_EXPRESSION_NODE = (1 << 2) | (1 << 3),
-  BINARY_EXPRESSION_NODE= (1 << 2) | (1 << 4),
-  BOOL_NODE		= (1 << 2) | (1 << 5),
-  INT_NODE              = (1 << 2) | (1 << 6), 
-  FLOAT_NODE            = (1 << 2) | (1 << 7),
-  IDENT_NODE            = (1 << 2) | (1 << 8),
-  VAR_NODE              = (1 << 2) | (1 << 9),
-  FUNCTION_NODE         = (1 << 2) | (1 << 10),
-  CONSTRUCTOR_NODE      = (1 << 2) | (1 << 11),
-
-  STATEMENT_NODE        = (1 << 1),
-  IF_STATEMENT_NODE     = (1 << 1) | (1 << 12),
-  ASSIGNMENT_NODE       = (1 << 1) | (1 << 13),
-  SCOPE_NODE		= (1 << 1) | (1 << 14),  
-
-  STATEMENTS_NODE	= (1 << 1) | (1 << 15),
-
-  DECLARATION_NODE      = (1 << 16),
-  DECLARATIONS_NODE	= (1 << 17),
-  
-  ARGUMENTS_NODE 	= (1 << 18)
+  /* Expression nodes, which all have a type */
+  UNARY_EXPRESSION_NODE,
+  BINARY_EXPRESSION_NODE,
+  BOOL_NODE,
+  INT_NODE,
+  FLOAT_NODE,
+  VAR_NODE,
+  FUNCTION_NODE,
+  CONSTRUCTOR_NODE,
+
+  /* Statement nodes */
+  IF_STATEMENT_NODE,
+  ASSIGNMENT_NODE,
+  SCOPE_NODE,
+
+  DECLARATION_NODE
 } node_kind;
 
-struct node_ {
-
-  // an example of tagging each node with a type
-  node_kind kind;
-  
-  /* A pointer to our symbol table */
-  symbol_table_t *st;
-
-  union {
-    struct {
-	node *declarations;
-	node *declaration;
-    } declarations;
+#define AST_IS_EXPR(kind) ((kind) >= UNARY_EXPRESSION_NODE && (kind) <= CONSTRUCTOR_NODE)
+#define AST_IS_STMT(kind) ((kind) >= IF_STATEMENT_NODE && (kind) <= SCOPE_NODE)
 
-    struct {
-        char *var_name;
-	node *init_val;
-    } declaration;
+/*
+ * A node is 12 bytes: its kind, one small operand, and two words whose
+ * meaning depends on the kind. Lists (the arguments of a call, the
+ * declarations and statements of a scope) are runs of node indices in
+ * the tree's items array. Expression types are kept apart, in the
+ * tree's types array.
+ */
+struct ast_node {
+  unsigned char kind;	/* node_kind */
 
-    struct {
-        node *statements;
-        node *statement;
-    } statements;
+  /* The operator of an expression, the function or type of a call, or
+   * the index into a variable (-1 for none) */
+  short op;
 
+  union {
     /* Statement nodes */
     struct {
-    	node *var;
-	node *new_val;
+    	node_t var;
+	node_t new_val;
     } assign_stmt;
 
     struct {
-        node *expr;
-        node *stmt;
-	node *opt_stmt;
+        node_t expr;
+        unsigned int branches;	/* items: the statement, then the else statement */
     } if_stmt;
 
     struct {
-        node *declarations;
-        node *statements;
+        unsigned int index;	/* in the tree's scopes */
     } scope;
     /* End statement nodes */
-  
-    /* Expression nodes - all these should have types  */
+
+    struct {
+	unsigned int sym;	/* the variable declared, see AST_SYMBOL() */
+	node_t init_val;
+    } declaration;
+
+    /* Expression nodes */
     struct {
-      	int op;
-      	node *expr;
-	type_t type;
+      	node_t expr;
     } unary_expr;
 
     struct {
-     	int op;
-      	node *left;
-      	node *right;
-	type_t type;
+      	node_t left;
+      	node_t right;
     } binary_expr;
 
     struct {
         int value;
-        type_t type;
     } bool_lit;
 
     struct {
         int value;
-	type_t type;
     } int_lit;
 
     struct {
-        double value;
-	type_t type;
+        float value;
     } float_lit;
 
     struct {
-        char *name;
-	int ofs;
-	type_t type;
+	ident_t id;
+	unsigned int sym;	/* 0 until semantic analysis resolves it */
     } var;
 
     struct {
-	func_t func;
-	node *args_opt;
-    } function;
-
-    struct {
-	type_t type;
-	node *args_opt;
-    } constructor;
+	unsigned int first;	/* in items */
+	unsigned int num;
+    } args;		/* of a function or constructor */
     /* End expression nodes */
+  };
+};
 
-    struct {
-	node *args;
-	node *expr;
-    } arguments;
+/* A scope's symbol table, and its declarations followed by its
+ * statements in items */
+struct ast_scope {
+  symbol_table_t *st;
+  unsigned int first;
+  unsigned int num_dclns;
+  unsigned int num_stmts;
+};
 
-    // etc.
-  };
+/*
+ * The AST of a compile: the nodes, their types, the lists and scopes.
+ * pending holds the lists the parser is still adding to; each is moved
+ * into items once it is complete. symbols are the symbol table entries
+ * the variables and declarations refer to by number: 0 for none, then
+ * the pre-defined variables, then the declared ones.
+ */
+struct ast_tree {
+  struct ast_node *nodes;
+  unsigned short *types;	/* type_t of each expression node */
+  unsigned int num_nodes;
+  unsigned int max_nodes;
+
+  node_t *items;
+  unsigned int num_items;
+  unsigned int max_items;
+
+  node_t *pending;
+  unsigned int num_pending;
+  unsigned int max_pending;
+
+  struct ast_scope *scopes;
+  unsigned int num_scopes;
+  unsigned int max_scopes;
+
+  const struct st_entry **symbols;
+  unsigned int num_symbols;
+  unsigned int max_symbols;
+
+  node_t root;
+};
+
+#define AST_NODE(cs, n)		(&(cs)->ast.nodes[n])
+#define AST_TYPE(cs, n)		((type_t) (cs)->ast.types[n])
+#define AST_SET_TYPE(cs, n, t)	((cs)->ast.types[n] = (unsigned short) (t))
+#define AST_ITEM(cs, i)		((cs)->ast.items[i])
+#define AST_SCOPE(cs, n)	(&(cs)->ast.scopes[AST_NODE(cs, n)->scope.index])
+#define AST_SYMBOL(cs, sym)	((cs)->ast.symbols[sym])
+
+/*
+ * Add a node to the session's tree. Lists are passed as the mark taken
+ * with ast_mark() where they started, and are complete by then. A
+ * declaration takes the entry st_insert() made for it, and numbers it.
+ */
+node_t ast_allocate(compile_session_t *cs, node_kind type, ...);
+
+/* The start of a new list, to be filled with ast_push() */
+unsigned int ast_mark(compile_session_t *cs);
+void ast_push(compile_session_t *cs, node_t item);
+
+/* Release the session's tree */
+void ast_free(compile_session_t *cs);
+
+/*
+ * The children of a node, in the order the passes visit them: an
+ * expression's operands or arguments, an assignment's variable then its
+ * value, an if's condition, statement and else statement, a scope's
+ * declarations then its statements, a declaration's initial value.
+ * A child may be AST_NIL (a missing else or initial value).
+ */
+unsigned int ast_num_children(compile_session_t *cs, node_t n);
+node_t ast_child(compile_session_t *cs, node_t n, unsigned int i);
+
+/*
+ * A stack of fixed size entries on the heap, for the walker's frames and
+ * for the values a pass hands from children up to their parent.
+ */
+struct ast_stack {
+  char *base;
+  size_t len;
+  size_t size;
 };
 
-node *ast_allocate(node_kind type, ...);
-void ast_free(node *ast);
-void ast_print(node * ast);
+/* A new entry on top, not cleared */
+void *ast_stack_push(struct ast_stack *stack, size_t size);
+/* The top entry, which stays valid until the next push */
+void *ast_stack_pop(struct ast_stack *stack, size_t size);
+void ast_stack_free(struct ast_stack *stack);
+
+/*
+ * The hooks of a pass over the tree, any of which may be NULL. pre is
+ * called on the way down and returns 0 to leave out the node's children
+ * and post. child is called before each child of n, AST_NIL ones
+ * included, and returns 0 to leave that child out. post is called once
+ * all the children are done.
+ */
+struct ast_visitor {
+  int (*pre)(compile_session_t *cs, node_t n, void *arg);
+  int (*child)(compile_session_t *cs, node_t n, unsigned int i, void *arg);
+  void (*post)(compile_session_t *cs, node_t n, void *arg);
+  void *arg;
+};
+
+/* Visit the tree under root depth first. The path from the root is kept
+ * on the heap, so any depth of nesting can be walked. */
+void ast_walk(compile_session_t *cs, node_t root, const struct ast_visitor *visitor);
+
+void ast_print(compile_session_t *cs, node_t ast);
 
 #endif /* AST_H_ */
@@ -0,0 +1,204 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * batch.c
+ *
+ * Batch compilation of many source files across a pool of threads.
+ * Each job gets a fresh compile session that shares only the control
+ * flags of the invoking session.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "batch.h"
+#include "session.h"
+#include "cache.h"
+
+#define LOG_SUFFIX ".log"
+#define ARB_SUFFIX ".arb"
+
+/* Job status, one per source */
+enum {
+  JOB_OK = 0,
+  JOB_FAILED,
+  JOB_UNREADABLE
+};
+
+struct batch_ctx {
+  compile_session_t *opts;
+  batch_t *b;
+  int next;      /* next job to hand out */
+  int *status;
+};
+
+void batch_add_source(batch_t *b, const char *fileName) {
+  if (b->numSources == b->maxSources) {
+    b->maxSources = b->maxSources ? 2 * b->maxSources : 16;
+    b->sources = (char **) realloc(b->sources, b->maxSources * sizeof(char *));
+  }
+  b->sources[b->numSources++] = strdup(fileName);
+  if (b->numSources > 1)
+    b->useBatch = TRUE;
+}
+
+int batch_read_manifest(compile_session_t *cs, batch_t *b, const char *fileName) {
+  char line[MAX_TEXT];
+  char *start, *end;
+  FILE *manifest;
+
+  if ((manifest = fopen(fileName, "r")) == NULL) {
+    fprintf(cs->errorFile, "Unable to open manifest %s\n", fileName);
+    return 1;
+  }
+
+  while (fgets(line, MAX_TEXT, manifest)) {
+    start = line;
+    while (isspace((unsigned char) *start))
+      start++;
+    end = start + strlen(start);
+    while (end > start && isspace((unsigned char) end[-1]))
+      end--;
+    *end = '\0';
+
+    if (*start == '\0' || *start == '#')
+      continue;
+    batch_add_source(b, start);
+  }
+
+  fclose(manifest);
+  b->useBatch = TRUE;
+  return 0;
+}
+
+void batch_free(batch_t *b) {
+  int i;
+
+  for (i = 0; i < b->numSources; i++)
+    free(b->sources[i]);
+  free(b->sources);
+  memset(b, 0, sizeof *b);
+}
+
+static char *with_suffix(const char *fileName, const char *suffix) {
+  size_t len = strlen(fileName);
+  char *name = (char *) malloc(len + strlen(suffix) + 1);
+
+  memcpy(name, fileName, len);
+  strcpy(name + len, suffix);
+  return name;
+}
+
+/* Compile one source in its own session */
+static int batch_job(compile_session_t *opts, const char *source) {
+  compile_session_t job;
+  struct stat st;
+  char *logName, *arbName;
+  FILE *log;
+  int status;
+
+  session_init(&job);
+  session_copy_options(&job, opts);
+
+  if ((job.inputFile = fopen(source, "r")) == NULL)
+    return JOB_UNREADABLE;
+
+  logName = with_suffix(source, LOG_SUFFIX);
+  arbName = with_suffix(source, ARB_SUFFIX);
+
+  /* Everything but the ARB program goes to the job's log */
+  if ((log = fopen(logName, "w")) == NULL)
+    log = DEFAULT_ERROR_FILE;
+  job.outputFile = job.errorFile = job.dumpFile = job.traceFile = log;
+  job.assemblyFileName = arbName;
+
+  /* Don't leave the output of an earlier run behind if this one fails
+   * to parse */
+  unlink(arbName);
+
+  status = cache_compile(&job) ? JOB_FAILED : JOB_OK;
+
+  fclose(job.inputFile);
+  session_free_source(&job);
+  session_free_program(&job);
+  if (log != DEFAULT_ERROR_FILE) {
+    fclose(log);
+    if (stat(logName, &st) == 0 && st.st_size == 0)
+      unlink(logName);
+  }
+
+  free(logName);
+  free(arbName);
+  return status;
+}
+
+static void *batch_worker(void *arg) {
+  struct batch_ctx *ctx = (struct batch_ctx *) arg;
+  int i;
+
+  while ((i = __sync_fetch_and_add(&ctx->next, 1)) < ctx->b->numSources)
+    ctx->status[i] = batch_job(ctx->opts, ctx->b->sources[i]);
+
+  return NULL;
+}
+
+int batch_run(compile_session_t *cs, batch_t *b) {
+  struct batch_ctx ctx;
+  struct timespec start, end;
+  pthread_t *threads;
+  int numThreads, i, failed;
+  double secs;
+
+  numThreads = b->numThreads;
+  if (numThreads <= 0)
+    numThreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if (numThreads > b->numSources)
+    numThreads = b->numSources;
+  if (numThreads < 1)
+    numThreads = 1;
+
+  ctx.opts = cs;
+  ctx.b = b;
+  ctx.next = 0;
+  ctx.status = (int *) calloc(b->numSources + 1, sizeof(int));
+  threads = (pthread_t *) malloc(numThreads * sizeof(pthread_t));
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (i = 0; i < numThreads; i++)
+    pthread_create(&threads[i], NULL, batch_worker, &ctx);
+  for (i = 0; i < numThreads; i++)
+    pthread_join(threads[i], NULL);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+  /* Aggregate summary */
+  failed = 0;
+  for (i = 0; i < b->numSources; i++) {
+    switch (ctx.status[i]) {
+      case JOB_FAILED:
+        fprintf(cs->outputFile, "FAILED: %s (see %s%s)\n", b->sources[i], b->sources[i], LOG_SUFFIX);
+        failed++;
+        break;
+      case JOB_UNREADABLE:
+        fprintf(cs->outputFile, "FAILED: %s (unable to open file)\n", b->sources[i]);
+        failed++;
+        break;
+      default:
+        break;
+    }
+  }
+  fprintf(cs->outputFile, "Batch: %d files, %d succeeded, %d failed, %d threads, %.3f s\n",
+          b->numSources, b->numSources - failed, failed, numThreads, secs);
+
+  free(threads);
+  free(ctx.status);
+  return failed;
+}
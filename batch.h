@@ -0,0 +1,41 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * batch.h
+ *
+ * Batch compilation: many source files compiled by a pool of threads in
+ * one invocation, each with its own compile session.
+ **********************************************************************/
+
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include "common.h"
+
+typedef struct batch {
+  char **sources;   /* source files, one job each */
+  int numSources;
+  int maxSources;
+  int numThreads;   /* 0 means one per online CPU */
+  int useBatch;     /* set by a manifest or more than one source file */
+} batch_t;
+
+/* Add one source file to the batch */
+void batch_add_source(batch_t *b, const char *fileName);
+
+/* Add every source listed in a manifest, one per line ('#' comments).
+ * Returns 0 on success. */
+int batch_read_manifest(compile_session_t *cs, batch_t *b, const char *fileName);
+
+/*
+ * Compile every source of the batch. Job i reads sources[i] and writes
+ * its ARB program to sources[i].arb and its diagnostics (and any dumps
+ * or traces) to sources[i].log; empty logs are removed. The options of
+ * cs apply to every job and the summary is written to cs->outputFile.
+ * Returns the number of jobs that failed.
+ */
+int batch_run(compile_session_t *cs, batch_t *b);
+
+void batch_free(batch_t *b);
+
+#endif /* _BATCH_H_ */
@@ -0,0 +1,436 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * cache.c
+ *
+ * Content-addressed compile cache, see cache.h.
+ *
+ * An entry is the decimal length of the normalized source on a line of
+ * its own, the normalized source, then the ARB program. The normalized
+ * source is compared on every hit, so a hash collision is just a miss.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+#include "session.h"
+
+#define STATS_FILE "stats"
+#define TMP_PREFIX "tmp."
+#define KEY_LEN    16
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME  0x100000001b3ULL
+
+/* Counters kept in the stats file */
+enum {
+  STAT_HITS = 0,
+  STAT_MISSES,
+  STAT_STORES,
+  STAT_EVICTIONS,
+  NUM_STATS
+};
+
+static const char *stat_names[NUM_STATS] = {
+  "hits",
+  "misses",
+  "stores",
+  "evictions"
+};
+
+struct cache_file {
+  char *name;
+  off_t size;
+  long long mtime;   /* ns */
+};
+
+static unsigned long long fnv1a(unsigned long long h, const void *data, size_t len) {
+  const unsigned char *p = (const unsigned char *) data;
+
+  while (len--) {
+    h ^= *p++;
+    h *= FNV_PRIME;
+  }
+  return h;
+}
+
+/* Read the rest of a stream into a malloc'd buffer */
+static char *read_all(FILE *f, size_t *len) {
+  size_t cap = 4096, n;
+  char *buf = (char *) malloc(cap);
+
+  *len = 0;
+  while ((n = fread(buf + *len, 1, cap - *len, f)) > 0) {
+    *len += n;
+    if (*len == cap) {
+      cap *= 2;
+      buf = (char *) realloc(buf, cap);
+    }
+  }
+  return buf;
+}
+
+/*
+ * Copy src to dst with comments removed and every run of white space
+ * (comments included) turned into one blank, neither of which changes
+ * the tokens the scanner sees. Only the white space the scanner takes
+ * (blanks, tabs, \n and \r\n) is folded: other control characters
+ * are lexical errors, so they are kept and such a source never shares
+ * a key with a clean one. dst must hold len bytes. Returns the
+ * normalized length, or -1 for an unterminated comment, which is an
+ * error the compiler has to report.
+ */
+static long normalize(const char *src, size_t len, char *dst) {
+  const char *end = src + len;
+  char *out = dst;
+  int blank = TRUE;   /* drop leading white space */
+
+  while (src < end) {
+    if (src + 1 < end && src[0] == '/' && src[1] == '*') {
+      for (src += 2; src + 1 < end && !(src[0] == '*' && src[1] == '/'); src++)
+        ;
+      if (src + 1 >= end)
+        return -1;
+      src += 2;
+      if (!blank)
+        *out++ = ' ';
+      blank = TRUE;
+    } else if (*src == ' ' || *src == '\t' || *src == '\n' ||
+               (src + 1 < end && src[0] == '\r' && src[1] == '\n')) {
+      if (!blank)
+        *out++ = ' ';
+      blank = TRUE;
+      src += *src == '\r' ? 2 : 1;
+    } else {
+      *out++ = *src++;
+      blank = FALSE;
+    }
+  }
+  if (out > dst && out[-1] == ' ')
+    out--;
+  return out - dst;
+}
+
+static void cache_key(compile_session_t *cs, const char *norm, size_t len, char *key) {
+  unsigned long long h = FNV_OFFSET;
+  int flags[8];
+
+  h = fnv1a(h, CACHE_VERSION, sizeof CACHE_VERSION);
+
+  flags[0] = cs->suppressExecution;
+  flags[1] = cs->traceScanner;
+  flags[2] = cs->traceParser;
+  flags[3] = cs->traceExecution;
+  flags[4] = cs->dumpSource;
+  flags[5] = cs->dumpAST;
+  flags[6] = cs->dumpSymbols;
+  flags[7] = cs->dumpInstructions;
+  h = fnv1a(h, flags, sizeof flags);
+
+  h = fnv1a(h, norm, len);
+  snprintf(key, KEY_LEN + 1, "%016llx", h);
+}
+
+static char *cache_path(const char *dir, const char *name) {
+  size_t len = strlen(dir);
+  char *path = (char *) malloc(len + strlen(name) + 2);
+
+  memcpy(path, dir, len);
+  path[len] = '/';
+  strcpy(path + len + 1, name);
+  return path;
+}
+
+/* Add the given amounts to the counters in the stats file, and read them
+ * back into totals if that is non-NULL */
+static void update_stats(const char *dir, const long *delta, long *totals) {
+  long counts[NUM_STATS];
+  char buf[256], name[32], *p;
+  long value;
+  int fd, i, n, len;
+  char *path = cache_path(dir, STATS_FILE);
+
+  memset(counts, 0, sizeof counts);
+
+  if ((fd = open(path, delta ? O_RDWR | O_CREAT : O_RDONLY, 0644)) >= 0) {
+    flock(fd, delta ? LOCK_EX : LOCK_SH);
+
+    if ((len = pread(fd, buf, sizeof buf - 1, 0)) > 0) {
+      buf[len] = '\0';
+      for (p = buf; sscanf(p, "%31s %ld%n", name, &value, &n) == 2; p += n)
+        for (i = 0; i < NUM_STATS; i++)
+          if (strcmp(name, stat_names[i]) == 0)
+            counts[i] = value;
+    }
+
+    if (delta) {
+      len = 0;
+      for (i = 0; i < NUM_STATS; i++) {
+        counts[i] += delta[i];
+        len += snprintf(buf + len, sizeof buf - len, "%s %ld\n", stat_names[i], counts[i]);
+      }
+      if (pwrite(fd, buf, len, 0) == len)
+        ftruncate(fd, len);
+    }
+
+    flock(fd, LOCK_UN);
+    close(fd);
+  }
+
+  if (totals)
+    memcpy(totals, counts, sizeof counts);
+  free(path);
+}
+
+static void count(const char *dir, int stat, long n) {
+  long delta[NUM_STATS];
+
+  memset(delta, 0, sizeof delta);
+  delta[stat] = n;
+  update_stats(dir, delta, NULL);
+}
+
+static int is_entry(const char *name) {
+  return strlen(name) == KEY_LEN && strspn(name, "0123456789abcdef") == KEY_LEN;
+}
+
+static int cmp_mtime(const void *a, const void *b) {
+  const struct cache_file *x = (const struct cache_file *) a;
+  const struct cache_file *y = (const struct cache_file *) b;
+  return (x->mtime > y->mtime) - (x->mtime < y->mtime);
+}
+
+/* List the entries of the cache, returning their number and total size */
+static int list_entries(const char *dir, struct cache_file **files, off_t *total) {
+  struct dirent *de;
+  struct stat st;
+  DIR *d;
+  char *path;
+  int num = 0, max = 0;
+
+  *files = NULL;
+  *total = 0;
+  if ((d = opendir(dir)) == NULL)
+    return 0;
+
+  while ((de = readdir(d)) != NULL) {
+    if (!is_entry(de->d_name))
+      continue;
+    path = cache_path(dir, de->d_name);
+    if (stat(path, &st) == 0) {
+      if (num == max) {
+        max = max ? 2 * max : 64;
+        *files = (struct cache_file *) realloc(*files, max * sizeof(struct cache_file));
+      }
+      (*files)[num].name = path;
+      (*files)[num].size = st.st_size;
+      (*files)[num].mtime = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+      *total += st.st_size;
+      num++;
+    } else
+      free(path);
+  }
+
+  closedir(d);
+  return num;
+}
+
+/* Remove the least recently used entries until the cache fits in limit */
+static void evict(const char *dir, long limit) {
+  struct cache_file *files;
+  off_t total;
+  int num, i;
+  long evicted = 0;
+
+  num = list_entries(dir, &files, &total);
+  if (total > limit) {
+    qsort(files, num, sizeof(struct cache_file), cmp_mtime);
+    for (i = 0; i < num && total > limit; i++) {
+      if (unlink(files[i].name) == 0) {
+        total -= files[i].size;
+        evicted++;
+      }
+    }
+  }
+
+  for (i = 0; i < num; i++)
+    free(files[i].name);
+  free(files);
+
+  if (evicted)
+    count(dir, STAT_EVICTIONS, evicted);
+}
+
+/* Look up an entry. Returns its ARB program, or NULL on a miss. */
+static char *lookup(const char *dir, const char *key, const char *norm, size_t normLen,
+                    size_t *arbLen) {
+  char *path = cache_path(dir, key);
+  char *entry, *p, *arb = NULL;
+  size_t len;
+  FILE *f;
+
+  if ((f = fopen(path, "rb")) == NULL) {
+    free(path);
+    return NULL;
+  }
+  entry = read_all(f, &len);
+  fclose(f);
+
+  if ((p = (char *) memchr(entry, '\n', len)) != NULL &&
+      strtoul(entry, NULL, 10) == normLen &&
+      (size_t) (entry + len - (p + 1)) >= normLen &&
+      memcmp(p + 1, norm, normLen) == 0) {
+    p += 1 + normLen;
+    *arbLen = entry + len - p;
+    arb = (char *) malloc(*arbLen + 1);
+    memcpy(arb, p, *arbLen);
+
+    /* Mark as recently used */
+    utimensat(AT_FDCWD, path, NULL, 0);
+  }
+
+  free(entry);
+  free(path);
+  return arb;
+}
+
+/* Atomically add an entry, then trim the cache to its size limit */
+static void store(compile_session_t *cs, const char *key, const char *norm, size_t normLen,
+                  const char *arb, size_t arbLen) {
+  char *tmpPath = cache_path(cs->cacheDir, TMP_PREFIX "XXXXXX");
+  char *path = cache_path(cs->cacheDir, key);
+  FILE *f;
+  int fd, ok;
+
+  if ((fd = mkstemp(tmpPath)) >= 0) {
+    fchmod(fd, 0644);
+    f = fdopen(fd, "wb");
+    fprintf(f, "%lu\n", (unsigned long) normLen);
+    fwrite(norm, 1, normLen, f);
+    fwrite(arb, 1, arbLen, f);
+    ok = !ferror(f);
+    ok = (fclose(f) == 0) && ok;
+
+    if (ok && rename(tmpPath, path) == 0) {
+      count(cs->cacheDir, STAT_STORES, 1);
+      evict(cs->cacheDir, cs->cacheMaxSize > 0 ? cs->cacheMaxSize : CACHE_DEFAULT_SIZE);
+    } else
+      unlink(tmpPath);
+  }
+
+  free(tmpPath);
+  free(path);
+}
+
+/* Make a cached ARB program the session's generated one, and write it
+ * where the session wants it */
+static void emit(compile_session_t *cs, char *arb, size_t len) {
+  session_free_program(cs);
+  arb[len] = '\0';
+  cs->code.text = arb;
+  cs->code.len = len;
+  cs->code.size = len + 1;
+  session_write_program(cs);
+}
+
+int cache_init(compile_session_t *cs) {
+  struct stat st;
+
+  if (mkdir(cs->cacheDir, 0755) < 0 && (stat(cs->cacheDir, &st) < 0 || !S_ISDIR(st.st_mode))) {
+    fprintf(cs->errorFile, "Unable to use cache directory %s\n", cs->cacheDir);
+    cs->cacheDir = NULL;
+    return 1;
+  }
+  return 0;
+}
+
+int cache_compile(compile_session_t *cs) {
+  compile_session_t job;
+  char key[KEY_LEN + 1];
+  char *norm, *arb, *out = NULL, *err = NULL;
+  size_t arbLen = 0, outLen = 0, errLen = 0;
+  FILE *outFile, *errFile;
+  long normLen;
+  int status;
+
+  if (cs->cacheDir == NULL || cs->dumpSource || cs->dumpAST || cs->dumpSymbols ||
+      cs->dumpInstructions || cs->traceScanner || cs->traceParser || cs->traceStats)
+    return session_compile(cs);
+
+  if (cs->source == NULL && session_read_source(cs))
+    return 1;
+  norm = (char *) malloc(cs->sourceLen + 1);
+  normLen = normalize(cs->source, cs->sourceLen, norm);
+
+  if (normLen >= 0) {
+    cache_key(cs, norm, normLen, key);
+    if ((arb = lookup(cs->cacheDir, key, norm, normLen, &arbLen)) != NULL) {
+      count(cs->cacheDir, STAT_HITS, 1);
+      emit(cs, arb, arbLen);
+      free(norm);
+      cs->errorOccurred = FALSE;
+      return 0;
+    }
+    count(cs->cacheDir, STAT_MISSES, 1);
+  }
+
+  /* Miss: compile the same source, keeping the program and capturing the
+   * messages to pass on, and to store if the compile was clean */
+  job = *cs;
+  job.outputFile = outFile = open_memstream(&out, &outLen);
+  job.errorFile = errFile = open_memstream(&err, &errLen);
+  job.assemblyFile = NULL;
+  job.assemblyFileName = NULL;
+
+  status = session_compile(&job);
+  cs->errorOccurred = job.errorOccurred;
+  cs->code = job.code;
+
+  fclose(outFile);
+  fclose(errFile);
+
+  fwrite(out, 1, outLen, cs->outputFile);
+  fwrite(err, 1, errLen, cs->errorFile);
+
+  /* Nothing is generated when the source doesn't parse, and then the
+   * assembly file is left alone too */
+  arb = cs->code.text;
+  arbLen = cs->code.len;
+  if (arbLen > 0)
+    session_write_program(cs);
+
+  if (normLen >= 0 && status == 0 && outLen == 0 && errLen == 0 && arbLen > 0)
+    store(cs, key, norm, normLen, arb, arbLen);
+
+  free(out);
+  free(err);
+  free(norm);
+  return status;
+}
+
+void cache_print_stats(const char *cacheDir, FILE *out) {
+  struct cache_file *files;
+  long counts[NUM_STATS];
+  off_t total;
+  int num, i;
+  long lookups;
+
+  update_stats(cacheDir, NULL, counts);
+  num = list_entries(cacheDir, &files, &total);
+  for (i = 0; i < num; i++)
+    free(files[i].name);
+  free(files);
+
+  lookups = counts[STAT_HITS] + counts[STAT_MISSES];
+  fprintf(out, "Cache %s: %ld hits, %ld misses (%.1f%% hit rate), %ld stores, %ld evictions, %d entries, %ld bytes\n",
+          cacheDir, counts[STAT_HITS], counts[STAT_MISSES],
+          lookups ? 100.0 * counts[STAT_HITS] / lookups : 0.0,
+          counts[STAT_STORES], counts[STAT_EVICTIONS], num, (long) total);
+}
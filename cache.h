@@ -0,0 +1,45 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * cache.h
+ *
+ * Content-addressed compile cache. The ARB program of every clean
+ * compile (no errors and no other output) is stored in a cache
+ * directory under a hash of the normalized source, the compiler
+ * version and the options. A later compile of the same program, even
+ * with different comments or whitespace, reuses it without parsing.
+ *
+ * The cache directory holds one file per entry, named by its key, and
+ * a "stats" file with the hit/miss counters. Entries are written to a
+ * temporary file and renamed into place, so concurrent compilers never
+ * see a partial entry. Once the entries take up more than the size
+ * limit, the least recently used (oldest mtime; a hit touches the
+ * entry) are removed.
+ **********************************************************************/
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+#include <stdio.h>
+
+#include "common.h"
+
+/* Bump whenever a change to the compiler changes its ARB output, so
+ * entries from older compilers are never reused */
+#define CACHE_VERSION       "compiler467 cache 1"
+#define CACHE_DEFAULT_SIZE  (64L << 20)
+
+/* Create the session's cache directory if needed. On failure the cache
+ * is turned off for the session. */
+int cache_init(compile_session_t *cs);
+
+/*
+ * Compile the session's input like session_compile(), going through the
+ * cache in cs->cacheDir. Compiles that dump or trace always run in full.
+ */
+int cache_compile(compile_session_t *cs);
+
+/* Print the cache's hit/miss statistics and size to out */
+void cache_print_stats(const char *cacheDir, FILE *out);
+
+#endif /* _CACHE_H_ */
@@ -0,0 +1,60 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * cc467.c
+ *
+ * libcompiler467 entry points. The scanner works on a copy of the
+ * source, the diagnostics are collected with open_memstream() and both
+ * they and the generated program are handed to the caller as they are.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cc467.h"
+#include "session.h"
+
+int cc467_compile(const char *src, size_t len, const cc467_options *options, cc467_result *result) {
+  compile_session_t job;
+  FILE *diagFile;
+  int status;
+
+  memset(result, 0, sizeof *result);
+
+  session_init(&job);
+  if (options) {
+    job.dumpSource   = options->dumpSource;
+    job.dumpAST      = options->dumpAST;
+    job.traceScanner = options->traceScanner;
+    job.traceParser  = options->traceParser;
+  }
+
+  if ((diagFile = open_memstream(&result->diagnostics, &result->diagnostics_len)) == NULL)
+    return -1;
+
+  job.outputFile = job.errorFile = job.dumpFile = job.traceFile = diagFile;
+  job.assemblyFile = NULL;
+  job.assemblyFileName = NULL;
+
+  /* The scanner needs a writable copy ending in two NULs */
+  session_set_source(&job, src, len);
+  status = session_compile(&job);
+  session_free_source(&job);
+
+  fclose(diagFile);
+
+  /* The generated program is handed over as it is */
+  if (job.code.text == NULL)
+    job.code.text = strdup("");
+  result->arb = job.code.text;
+  result->arb_len = job.code.len;
+
+  return status ? 1 : 0;
+}
+
+void cc467_result_free(cc467_result *result) {
+  free(result->arb);
+  free(result->diagnostics);
+  memset(result, 0, sizeof *result);
+}
@@ -0,0 +1,65 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * cc467.h
+ *
+ * libcompiler467: the public C interface to the compiler, for programs
+ * that compile shaders at run time. A compile runs entirely in memory;
+ * it reads no files and writes no files.
+ *
+ *   cc467_result res;
+ *
+ *   if (cc467_compile(src, strlen(src), NULL, &res) == 0)
+ *     load_program(res.arb, res.arb_len);
+ *   else
+ *     fputs(res.diagnostics, stderr);
+ *   cc467_result_free(&res);
+ *
+ * cc467_compile() may be called from several threads at once.
+ **********************************************************************/
+
+#ifndef _CC467_H_
+#define _CC467_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Compile options, the -D and -T flags of the command line. The dumps
+ * and traces are returned with the diagnostics. */
+typedef struct cc467_options {
+  int dumpSource;
+  int dumpAST;
+  int traceScanner;
+  int traceParser;
+} cc467_options;
+
+/*
+ * Output of a compile. arb and diagnostics are NUL terminated, malloc'd
+ * and owned by the caller; release them with cc467_result_free().
+ */
+typedef struct cc467_result {
+  char   *arb;             /* the ARB fragment program */
+  size_t  arb_len;
+  char   *diagnostics;     /* error messages, dumps and traces */
+  size_t  diagnostics_len;
+} cc467_result;
+
+/*
+ * Compile the len bytes of source at src. A NULL options means the
+ * defaults (no dumps or traces). Returns 0 if the program compiled
+ * without errors, 1 if there were compile errors and -1 if the compile
+ * could not be run at all (result is then left empty).
+ */
+int cc467_compile(const char *src, size_t len, const cc467_options *options, cc467_result *result);
+
+/* Free the buffers of a result filled in by cc467_compile() */
+void cc467_result_free(cc467_result *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CC467_H_ */
@@ -0,0 +1,290 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * client.c
+ *
+ * cc467client: sends source files to a running "compiler467 --serve".
+ *
+ *   cc467client [-S socket] [-Dsa] [-Tnp] file...
+ *       Compile each file; the ARB program goes to stdout and the
+ *       diagnostics to stderr.
+ *
+ *   cc467client [-S socket] -L count [-C connections] file...
+ *       Load test: send count requests, cycling through the files, over
+ *       the given number of concurrent connections, then report the
+ *       throughput and latency percentiles.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "server.h"
+
+struct source {
+  char *name;
+  char *text;
+  size_t len;
+};
+
+struct load_ctx {
+  const char *socketPath;
+  struct source *sources;
+  int numSources;
+  uint32_t options;
+  int numRequests;
+  int next;         /* next request to send */
+  int errors;
+  double *latency;  /* per request, in seconds */
+};
+
+static int client_connect(const char *socketPath) {
+  struct sockaddr_un addr;
+  int fd;
+
+  memset(&addr, 0, sizeof addr);
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, socketPath, sizeof addr.sun_path - 1);
+
+  if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+    return -1;
+  if (connect(fd, (struct sockaddr *) &addr, sizeof addr) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int read_source(const char *fileName, struct source *src) {
+  FILE *f;
+  long len;
+
+  if ((f = fopen(fileName, "rb")) == NULL)
+    return -1;
+  fseek(f, 0, SEEK_END);
+  len = ftell(f);
+  rewind(f);
+
+  src->name = (char *) fileName;
+  src->text = (char *) malloc(len + 1);
+  src->len = fread(src->text, 1, len, f);
+  fclose(f);
+  return 0;
+}
+
+/*
+ * Send one request and wait for the reply. The payloads are returned in
+ * *arb and *diag (malloc'd), or dropped if those are NULL.
+ * Returns the reply status, or -1 if the connection failed.
+ */
+static int client_compile(int fd, uint32_t options, const struct source *src,
+                          char **arb, char **diag) {
+  struct server_request request;
+  struct server_reply reply;
+  char *buf;
+
+  request.magic = SERVER_MAGIC;
+  request.options = options;
+  request.source_len = (uint32_t) src->len;
+
+  if (server_write_full(fd, &request, sizeof request) ||
+      server_write_full(fd, src->text, src->len) ||
+      server_read_full(fd, &reply, sizeof reply) ||
+      reply.magic != SERVER_MAGIC)
+    return -1;
+
+  buf = (char *) malloc(reply.arb_len + reply.diag_len + 2);
+  if (server_read_full(fd, buf, reply.arb_len + reply.diag_len)) {
+    free(buf);
+    return -1;
+  }
+
+  if (arb) {
+    *arb = (char *) malloc(reply.arb_len + 1);
+    memcpy(*arb, buf, reply.arb_len);
+    (*arb)[reply.arb_len] = '\0';
+  }
+  if (diag) {
+    *diag = (char *) malloc(reply.diag_len + 1);
+    memcpy(*diag, buf + reply.arb_len, reply.diag_len);
+    (*diag)[reply.diag_len] = '\0';
+  }
+  free(buf);
+  return (int) reply.status;
+}
+
+static double now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *load_worker(void *arg) {
+  struct load_ctx *ctx = (struct load_ctx *) arg;
+  double start;
+  int fd, i;
+
+  if ((fd = client_connect(ctx->socketPath)) < 0) {
+    __sync_fetch_and_add(&ctx->errors, 1);
+    return NULL;
+  }
+
+  while ((i = __sync_fetch_and_add(&ctx->next, 1)) < ctx->numRequests) {
+    start = now();
+    if (client_compile(fd, ctx->options, &ctx->sources[i % ctx->numSources], NULL, NULL) < 0) {
+      __sync_fetch_and_add(&ctx->errors, 1);
+      ctx->latency[i] = -1;
+      break;
+    }
+    ctx->latency[i] = now() - start;
+  }
+
+  close(fd);
+  return NULL;
+}
+
+static int cmp_double(const void *a, const void *b) {
+  double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int n, double p) {
+  int i = (int) (p / 100.0 * n + 0.5) - 1;
+
+  if (i < 0)
+    i = 0;
+  if (i >= n)
+    i = n - 1;
+  return sorted[i];
+}
+
+static int load_test(struct load_ctx *ctx, int numConns) {
+  pthread_t *threads;
+  double start, secs;
+  int i, done;
+
+  ctx->latency = (double *) malloc(ctx->numRequests * sizeof(double));
+  for (i = 0; i < ctx->numRequests; i++)
+    ctx->latency[i] = -1;
+  threads = (pthread_t *) malloc(numConns * sizeof(pthread_t));
+
+  start = now();
+  for (i = 0; i < numConns; i++)
+    pthread_create(&threads[i], NULL, load_worker, ctx);
+  for (i = 0; i < numConns; i++)
+    pthread_join(threads[i], NULL);
+  secs = now() - start;
+
+  /* Keep only the requests that completed */
+  done = 0;
+  for (i = 0; i < ctx->numRequests; i++)
+    if (ctx->latency[i] >= 0)
+      ctx->latency[done++] = ctx->latency[i];
+  qsort(ctx->latency, done, sizeof(double), cmp_double);
+
+  printf("Load: %d requests, %d connections, %d errors, %.3f s\n",
+         done, numConns, ctx->errors, secs);
+  if (done > 0) {
+    printf("Throughput: %.1f requests/s\n", done / secs);
+    printf("Latency (us): p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+           percentile(ctx->latency, done, 50) * 1e6,
+           percentile(ctx->latency, done, 90) * 1e6,
+           percentile(ctx->latency, done, 99) * 1e6,
+           ctx->latency[done - 1] * 1e6);
+  }
+
+  free(threads);
+  free(ctx->latency);
+  return ctx->errors != 0 || done == 0;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "usage: %s [-S socket] [-Dsa] [-Tnp] [-L count [-C connections]] file...\n", prog);
+  exit(2);
+}
+
+int main(int argc, char *argv[]) {
+  struct load_ctx ctx;
+  const char *socketPath = SERVER_DEFAULT_SOCKET;
+  char *arb, *diag;
+  const char *p;
+  int numConns = 1, i, j, fd, status, failed;
+
+  memset(&ctx, 0, sizeof ctx);
+
+  for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+    switch (argv[i][1]) {
+      case 'S':
+        if (++i >= argc) usage(argv[0]);
+        socketPath = argv[i];
+        break;
+      case 'L':
+        if (++i >= argc) usage(argv[0]);
+        ctx.numRequests = atoi(argv[i]);
+        break;
+      case 'C':
+        if (++i >= argc) usage(argv[0]);
+        numConns = atoi(argv[i]);
+        break;
+      case 'D':
+        for (p = argv[i] + 2; *p; p++) {
+          if (*p == 's') ctx.options |= SERVE_DUMP_SOURCE;
+          else if (*p == 'a') ctx.options |= SERVE_DUMP_AST;
+          else usage(argv[0]);
+        }
+        break;
+      case 'T':
+        for (p = argv[i] + 2; *p; p++) {
+          if (*p == 'n') ctx.options |= SERVE_TRACE_SCANNER;
+          else if (*p == 'p') ctx.options |= SERVE_TRACE_PARSER;
+          else usage(argv[0]);
+        }
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  if (i >= argc || numConns < 1)
+    usage(argv[0]);
+
+  ctx.socketPath = socketPath;
+  ctx.numSources = argc - i;
+  ctx.sources = (struct source *) calloc(ctx.numSources, sizeof(struct source));
+  for (j = 0; j < ctx.numSources; j++) {
+    if (read_source(argv[i + j], &ctx.sources[j])) {
+      fprintf(stderr, "Unable to open %s\n", argv[i + j]);
+      return 1;
+    }
+  }
+
+  if (ctx.numRequests > 0)
+    return load_test(&ctx, numConns);
+
+  if ((fd = client_connect(socketPath)) < 0) {
+    fprintf(stderr, "Unable to connect to %s\n", socketPath);
+    return 1;
+  }
+
+  failed = 0;
+  for (j = 0; j < ctx.numSources; j++) {
+    status = client_compile(fd, ctx.options, &ctx.sources[j], &arb, &diag);
+    if (status < 0) {
+      fprintf(stderr, "Lost connection to %s\n", socketPath);
+      return 1;
+    }
+    fputs(arb, stdout);
+    fputs(diag, stderr);
+    if (status != SERVE_OK)
+      failed++;
+    free(arb);
+    free(diag);
+  }
+
+  close(fd);
+  return failed != 0;
+}
@@ -1,563 +1,880 @@
 #include "codegen.h"
 #include "common.h"
 #include "symbol.h"
+#include "session.h"
+#include "literal.h"
+#include "ir.h"
+#include "intern.h"
+#include "arena.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
-#define MAX_BUF_LEN (MAX_IDENTIFIER + 4)
-
-#define NUM_MAPPED_REGS 13
-static const char *mapped_vars[NUM_MAPPED_REGS] = {
-	"gl_FragColor",
-	"gl_FragDepth",
-	"gl_FragCoord",
-	"gl_TexCoord",
-	"gl_Color",
-	"gl_Secondary",
-	"gl_FogFragCoord",
-	"gl_Light_Half",
-	"gl_Light_Ambient",
-	"gl_Material_Shininess",
-	"env1",
-	"env2",
-	"env3"
-};
-
-static const char *mapped_regs[NUM_MAPPED_REGS] = {
-        "result.color",
-        "result.depth",
-        "fragment.position",
-        "fragment.texcoord",
-        "fragment.color",
-        "fragment.color.secondary",
-        "fragment.fogcoord",
-        "state.light[0].half",
-        "state.lightmodel.ambient",
-        "state.material.shininess",
-        "program.env[1]",
-        "program.env[2]",
-        "program.env[3]"
-};
-
 static const char *zero_reg = "zero_reg";
 static const char *true_reg = "true_reg";
 static const char *false_reg = "false_reg";
 
-static void var_to_assembly(char *assembly, char *varname, int index){
-	int i;
+static const char components[] = "xyzw";
 
-	for(i = 0; i < NUM_MAPPED_REGS; i++){
-		if(!strcmp(varname, mapped_vars[i]))
-			break;
-	}
+/* Longest operand text: a name and a swizzle, or a literal vector */
+#define SRC_TEXT_LEN (4 * LITERAL_FLOAT_LEN + 8)
+
+/* Make room for len more bytes and a NUL at the end of the code buffer */
+static char *code_reserve(compile_session_t *cs, size_t len){
+	struct code_buffer *code = &cs->code;
 
-	if(i == NUM_MAPPED_REGS){
-		/* Not one of the mapped vars, just use varname */
-		strncpy(assembly, varname, MAX_BUF_LEN);
-	} else {
-		/* One of the mapped vars, use the mapped reg */
-		strncpy(assembly, mapped_regs[i], MAX_BUF_LEN);
+	if(code->len + len + 1 > code->size){
+		code->size = code->size ? 2 * code->size : 4096;
+		while(code->len + len + 1 > code->size)
+			code->size *= 2;
+		code->text = (char *) realloc(code->text, code->size);
 	}
 
-	/* Deal with offset, if there is one */
-	if(index != -1){
-		strcat(assembly, ".");
-		switch(index){
-			case 0:
-				strcat(assembly, "x");
-				break;
-			case 1:
-				strcat(assembly, "y");
-				break;
-			case 2:
-				strcat(assembly, "z");
-				break;
-			default:
-				strcat(assembly, "w");
-				break;
-		}
+	return code->text + code->len;
+}
+
+static void code_append(compile_session_t *cs, const char *text, size_t len){
+	memcpy(code_reserve(cs, len), text, len);
+	cs->code.len += len;
+	cs->code.text[cs->code.len] = '\0';
+}
+
+static void emit_text(compile_session_t *cs, const char *text){
+	code_append(cs, text, strlen(text));
+}
+
+/* Write one ARB instruction: op dest[mask], src0[, src1[, src2]]; */
+static void emit_op(compile_session_t *cs, enum ir_op op, const char *dest, int mask,
+		    char srcs[][SRC_TEXT_LEN]){
+	int i;
+
+	cs->stats.instructions++;
+	emit_text(cs, ir_op_names[op]);
+	code_append(cs, "\t", 1);
+	emit_text(cs, dest);
+	if(mask != IR_MASK_ALL){
+		code_append(cs, ".", 1);
+		for(i = 0; i < 4; i++)
+			if(mask & (1 << i))
+				code_append(cs, &components[i], 1);
+	}
+	for(i = 0; i < ir_op_srcs[op]; i++){
+		code_append(cs, ", ", 2);
+		emit_text(cs, srcs[i]);
 	}
+	code_append(cs, ";\n", 2);
+}
 
-	return;
+static void emit_temp(compile_session_t *cs, const char *name){
+	code_append(cs, "TEMP\t", 5);
+	emit_text(cs, name);
+	code_append(cs, ";\n", 2);
+}
+
+static void emit_param(compile_session_t *cs, const char *name, const char *value){
+	code_append(cs, "PARAM\t", 6);
+	emit_text(cs, name);
+	code_append(cs, " = ", 3);
+	emit_text(cs, value);
+	code_append(cs, ";\n", 2);
+}
+
+/* Write the decimal digits of v backwards from end, returning the first */
+static char *format_digits(char *end, unsigned long long v){
+	do{
+		*--end = '0' + v % 10;
+		v /= 10;
+	} while(v);
+
+	return end;
+}
+
+/* Same text as %d */
+static int format_int(char *buf, int value){
+	char digits[24];
+	char *end = digits + sizeof digits;
+	char *p = format_digits(end, value < 0 ? -(long long) value : value);
+	int len = 0;
+
+	if(value < 0)
+		buf[len++] = '-';
+	memcpy(buf + len, p, end - p);
+	len += end - p;
+	buf[len] = '\0';
+	return len;
 }
 
-#define MAX_TEMP_REGS 20
+/* A literal's text: a whole number of an integer type as %d, anything
+ * else with a decimal point */
+static int format_literal(char *buf, type_t type, float value){
+	if((type & INT) && type != ANY && value >= -2147483648.0f && value < 2147483648.0f
+	   && value == (float) (int) value)
+		return format_int(buf, (int) value);
+	return literal_format_float(buf, value);
+}
+
+/* A constant's text: a scalar when its components all have the same bits,
+ * {x, y, z, w} up to the last one it has otherwise; -0.0 is not 0.0 */
+static void format_const(char *buf, const struct ir_instr *in){
+	int i, len;
+
+	for(i = 1; i < 4 && (!memcmp(&in->value[i], &in->value[0], sizeof(float)) || !(in->mask & (1 << i))); i++)
+		;
+	if(i == 4){
+		format_literal(buf, (type_t) in->type, in->value[0]);
+		return;
+	}
+	len = 0;
+	for(i = 0; i < 4 && (in->mask & (1 << i)); i++){
+		memcpy(buf + len, i ? ", " : "{", 2);
+		len += i ? 2 : 1;
+		len += format_literal(buf + len, (type_t) in->type, in->value[i]);
+	}
+	memcpy(buf + len, "}", 2);
+}
+
+/*
+ * The temporaries, tempVar0, tempVar1, ..., of one program. The table
+ * grows whenever all of them are in use, so there are as many as the
+ * most values live at once, however deep expressions and ifs nest.
+ */
+#define TEMP_NAME_LEN 24
 
 struct trt_entry{
-	char regname[MAX_BUF_LEN];
+	char regname[TEMP_NAME_LEN];
 	bool curr_used;
-	bool ever_used;
 };
 
 struct tempreg_table{
-	struct trt_entry entries[MAX_TEMP_REGS];
+	struct trt_entry *entries;
+	int num_entries;	/* declared so far */
+	int max_entries;
 };
 
-static struct tempreg_table trt;
-
-static void free_tempreg(char *source){
-	int i;
-
-	if(strstr(source, "tempVar")){
-		sscanf(source + 7 /* tempVar* */, "%d", &i);
-		trt.entries[i].curr_used = FALSE;
-	}
-
-	return;
+static void free_tempreg(compile_session_t *cs, struct tempreg_table *trt, int reg){
+	if(reg < 0)
+		return;
+	if(trt->entries[reg].curr_used)
+		cs->stats.liveTemps--;
+	trt->entries[reg].curr_used = FALSE;
 }
 
-static void get_tempreg(char *dest){
+/* The lowest free temporary, declared the first time it is used */
+static int get_tempreg(compile_session_t *cs, struct tempreg_table *trt){
 	int i;
 
-	for(i = 0; i < MAX_TEMP_REGS; i++){
-		if(trt.entries[i].curr_used == FALSE)
+	cs->stats.temps++;
+
+	for(i = 0; i < trt->num_entries; i++){
+		if(trt->entries[i].curr_used == FALSE)
 			break;
 	}
 
-	if(i == MAX_TEMP_REGS){
-		fprintf(errorFile, "get_tempreg: Error: out of regs!\n");
-		return;
-	}
-	else{
-		if(trt.entries[i].ever_used == FALSE){
-			fprintf(assemblyFile, "TEMP\t%s;\n", trt.entries[i].regname);
-			trt.entries[i].ever_used = TRUE;
+	if(i == trt->num_entries){
+		if(trt->num_entries == trt->max_entries){
+			trt->max_entries = trt->max_entries ? 2 * trt->max_entries : 16;
+			trt->entries = (struct trt_entry *) realloc(trt->entries, trt->max_entries * sizeof(struct trt_entry));
 		}
-		strncpy(dest, trt.entries[i].regname, MAX_BUF_LEN);
-		trt.entries[i].curr_used = TRUE;
+		sprintf(trt->entries[i].regname, "tempVar%d", i);
+		emit_temp(cs, trt->entries[i].regname);
+		trt->num_entries++;
 	}
-	
-	return;
+	trt->entries[i].curr_used = TRUE;
+	if(++cs->stats.liveTemps > cs->stats.peakTemps)
+		cs->stats.peakTemps = cs->stats.liveTemps;
+
+	return i;
 }
 
-static void init_tempregs(){
+/*
+ * The IR is built as the tree is walked. Each expression leaves its
+ * value on the results stack, where its parent takes it from. The ifs
+ * being built are on a stack of their own, with the condition masks
+ * their branches' assignments select on.
+ *
+ * Variables are followed by register, with the value each holds at the
+ * point reached. They are told apart by their declaration's symbol, so
+ * one declared again in an inner scope gets a register of its own.
+ * Pre-defined variables have their bindings; the others are named after
+ * themselves, with a number after the name of each declaration that
+ * shadows another.
+ */
+struct gen_var{
+	unsigned int home;	/* 0 until the register is first used */
+	ir_value_t value;	/* what it holds now, IR_NONE if not known yet */
+};
+
+struct gen_if{
+	ir_value_t mask[2];	/* for the statement, then the else */
+	int branch;		/* the one being built */
+};
+
+struct gen_walk{
+	struct ir_program *ir;
+	struct ast_stack results;	/* struct ir_src each */
+	struct ast_stack ifs;		/* struct gen_if each */
+	struct gen_var *vars;		/* by symbol, then by ident for undeclared names */
+	unsigned int num_symbols;
+	unsigned int *num_named;	/* by ident, declarations given registers */
+	struct ir_src zero, truth, falsity;	/* zero_reg, true_reg, false_reg */
+};
+
+static const struct ir_src no_src = { IR_NONE, IR_IDENTITY };
+
+static struct ir_src gen_src(ir_value_t value, int swizzle){
+	struct ir_src src;
+
+	src.value = value;
+	src.swizzle = (unsigned char) swizzle;
+	return src;
+}
+
+/* Add an instruction reading the first of a, b and c its op takes */
+static ir_value_t gen_op(struct gen_walk *g, enum ir_op op, type_t type,
+			 struct ir_src a, struct ir_src b, struct ir_src c){
+	ir_value_t v = ir_add(g->ir, op, type, 0);
+	struct ir_instr *in = IR_INSTR(g->ir, v);
+	struct ir_src srcs[3] = { a, b, c };
 	int i;
 
-	for(i = 0; i < MAX_TEMP_REGS; i++){
-		sprintf(trt.entries[i].regname, "tempVar%d", i);
-		trt.entries[i].curr_used = FALSE;
-		trt.entries[i].ever_used = FALSE;
-	}
+	for(i = 0; i < ir_op_srcs[op]; i++)
+		in->src[i] = srcs[i];
+	return v;
 }
 
-static void init_utilregs(){
-        fprintf(assemblyFile, "PARAM\t%s = 0.0;\n", zero_reg);
-        fprintf(assemblyFile, "PARAM\t%s = 1.0;\n", true_reg);
-        fprintf(assemblyFile, "PARAM\t%s = -1.0;\n", false_reg);
+static ir_value_t gen_const(struct gen_walk *g, type_t type, float value, unsigned int home){
+	ir_value_t v = ir_add(g->ir, IR_CONST, type, home);
+	int i;
+
+	for(i = 0; i < 4; i++)
+		IR_INSTR(g->ir, v)->value[i] = value;
+	return v;
 }
 
-/* Foward declaration for genCode_args */
-static void genCode_expr(node *ast, char *result);
+static void gen_push_result(struct gen_walk *g, struct ir_src result){
+	*(struct ir_src *) ast_stack_push(&g->results, sizeof result) = result;
+}
 
-static void genCode_args(node *ast, int *arg_count, char *arg0, char *arg1, char *arg2, char *arg3){
-	
-	if(ast->arguments.args != NULL){
-		genCode_args(ast->arguments.args, arg_count, arg0, arg1, arg2, arg3);
-	}
+static struct ir_src gen_pop_result(struct gen_walk *g){
+	return *(struct ir_src *) ast_stack_pop(&g->results, sizeof(struct ir_src));
+}
 
-	switch(*arg_count){
-		case 0:
-			genCode_expr(ast->arguments.expr, arg0);
-			break;
-		case 1:
-			genCode_expr(ast->arguments.expr, arg1);
-			break;
-		case 2:
-			genCode_expr(ast->arguments.expr, arg2);
-			break;
-		case 3:
-			genCode_expr(ast->arguments.expr, arg3);
-			break;
-		default:
-			break;
+/* The innermost if being built, NULL outside of any */
+static struct gen_if *gen_top_if(struct gen_walk *g){
+	if(g->ifs.len == 0)
+		return NULL;
+	return (struct gen_if *) (g->ifs.base + g->ifs.len) - 1;
+}
+
+/* The register name of a declared variable: its own for the first
+ * declaration of the name, name_1, name_2, ... for later ones, skipping
+ * any the program uses itself */
+static const char *gen_var_name(compile_session_t *cs, struct gen_walk *g, const struct st_entry *ste){
+	unsigned int n = g->num_named[ste->id]++;
+	size_t len;
+	char *name;
+
+	if(n == 0)
+		return ste->binding;
+
+	len = strlen(ste->binding);
+	name = (char *) arena_alloc(&cs->arena, len + 12);
+	do{
+		sprintf(name, "%s_%u", ste->binding, n++);
+	}while(ident_find(cs, name, strlen(name)) >= 0);
+	g->num_named[ste->id] = n;
+	return name;
+}
+
+/* The register of a variable; ste is NULL for an undeclared one */
+static struct gen_var *gen_var(compile_session_t *cs, struct gen_walk *g, ident_t id, const struct st_entry *ste){
+	struct gen_var *var;
+	enum ir_home_kind kind;
+	const char *name;
+
+	if(ste != NULL)
+		var = &g->vars[ste->sym];
+	else
+		var = &g->vars[g->num_symbols + id];
+
+	if(var->home == 0){
+		/* gl_FragCoord is of the result class, but only read */
+		if(ste == NULL){
+			kind = IR_HOME_INPUT;
+			name = ident_name(cs, id);
+		}else if(ste->var_class != NOT_BUILTIN){
+			kind = strncmp(ste->binding, "result.", 7) ? IR_HOME_INPUT : IR_HOME_OUTPUT;
+			name = ste->binding;
+		}else{
+			kind = ste->is_cnst ? IR_HOME_PARAM : IR_HOME_TEMP;
+			name = gen_var_name(cs, g, ste);
+		}
+		var->home = ir_add_home(g->ir, name, kind);
 	}
-	
-	(*arg_count)++;
 
-	return;
+	return var;
+}
+
+/* What a variable holds now, which is its input if it hasn't been written */
+static ir_value_t gen_var_value(struct gen_walk *g, struct gen_var *var, type_t type){
+	if(var->value == IR_NONE)
+		var->value = ir_add(g->ir, IR_INPUT, type, var->home);
+	return var->value;
+}
+
+/* The component a variable is indexed at, -1 for none. An index past
+ * the last component has been reported by semantic analysis, and
+ * nothing is built for it. */
+static int gen_index(struct ast_node *var){
+	return var->op;
+}
+
+static struct ir_src gen_read(compile_session_t *cs, struct gen_walk *g, struct ast_node *ast){
+	const struct st_entry *ste = AST_SYMBOL(cs, ast->var.sym);
+	struct gen_var *var = gen_var(cs, g, ast->var.id, ste);
+	int index = gen_index(ast);
+
+	if(index > 3)
+		return no_src;
+	return gen_src(gen_var_value(g, var, ste != NULL ? ste->type : ANY),
+		       index == -1 ? IR_IDENTITY : IR_REPLICATE(index));
+}
+
+/* A comparison's 1 or 0 in d made 1 (true) or -1 (false) */
+static ir_value_t gen_bool(struct gen_walk *g, type_t type, ir_value_t d){
+	d = gen_op(g, IR_SUB, type, g->zero, gen_src(d, IR_IDENTITY), no_src);
+	/* d == -1 (true) or 0 (false) */
+	return gen_op(g, IR_CMP, type, gen_src(d, IR_IDENTITY), g->truth, g->falsity);
+}
+
+/* Take the arguments of a call into args, the missing ones as no_src.
+ * All of them are taken off the results stack; 0 is returned, and the
+ * call isn't built, if the built-in doesn't take that many (semantic
+ * analysis reports it first) */
+static int gen_args(compile_session_t *cs, struct gen_walk *g, struct ast_node *ast, struct ir_src args[4]){
+	struct ir_src arg;
+	unsigned int i, arity;
+
+	if(ast->kind == FUNCTION_NODE)
+		arity = ast->op == DP3 ? 2 : 1;
+	else
+		arity = print_type_index((type_t) ast->op) % 4 + 1;
+
+	for(i = ast->args.num; i > 0; i--){
+		arg = gen_pop_result(g);
+		if(i <= 4)
+			args[i - 1] = arg;
+	}
+	for(i = ast->args.num; i < 4; i++)
+		args[i] = no_src;
+
+	if(ast->args.num == arity)
+		return 1;
+	if(!cs->errorOccurred)
+		fprintf(cs->errorFile, "gen_args: Error: %s takes %u arguments, and has %u.\n",
+			ast->kind == FUNCTION_NODE ? func_strings[print_func_index((func_t) ast->op)]
+						   : type_strings[print_type_index((type_t) ast->op)],
+			arity, ast->args.num);
+	cs->errorOccurred = TRUE;
+	return 0;
 }
 
-static void genCode_expr(node *ast, char *result){
-	char buf1[MAX_BUF_LEN], buf2[MAX_BUF_LEN], buf3[MAX_BUF_LEN], buf4[MAX_BUF_LEN];
-	char dest[MAX_BUF_LEN], value[MAX_BUF_LEN];
-	int arg_count;
+static struct ir_src gen_expr(compile_session_t *cs, node_t n, struct gen_walk *g){
+	struct ast_node *ast = AST_NODE(cs, n);
+	type_t type = AST_TYPE(cs, n);
+	ir_value_t first = g->ir->num_instrs, d = IR_NONE, c;
+	struct ir_src a, b, args[4];
+	const char *note = NULL;
+	unsigned int i;
 
 	switch(ast->kind){
 		case UNARY_EXPRESSION_NODE:
-			genCode_expr(ast->unary_expr.expr, buf1);
-                       	get_tempreg(dest);
+			a = gen_pop_result(g);
 
-			switch(ast->unary_expr.op){
+			switch(ast->op){
 				case '!':
-					fprintf(assemblyFile, "# unary !:\n");
-					fprintf(assemblyFile, "CMP\t%s, %s, %s, %s;\n", dest, buf1, true_reg, false_reg);
+					note = "# unary !:\n";
+					d = gen_op(g, IR_CMP, type, a, g->truth, g->falsity);
 					break;
 				case '-':
-					fprintf(assemblyFile, "# unary -:\n");
-					fprintf(assemblyFile, "SUB\t%s, %s, %s;\n", dest, zero_reg, buf1);
+					note = "# unary -:\n";
+					d = gen_op(g, IR_SUB, type, g->zero, a, no_src);
 					break;
 				default:
-					strncpy(dest, "genCode_expr: Error: Unimplemented.", MAX_BUF_LEN);
 					break;
 			}
-		
-			free_tempreg(buf1);
-                       	strncpy(result, dest, MAX_BUF_LEN);
-
 			break;
 		case BINARY_EXPRESSION_NODE:
-			genCode_expr(ast->binary_expr.left, buf1);
-			genCode_expr(ast->binary_expr.right, buf2);
-			get_tempreg(dest);
+			b = gen_pop_result(g);
+			a = gen_pop_result(g);
 
-			switch(ast->binary_expr.op){
+			switch(ast->op){
 				case _AND:
-					fprintf(assemblyFile, "# binary AND:\n");
-					fprintf(assemblyFile, "ADD\t%s, %s, %s;\n", dest, buf1, buf2);
-					/* If both true, dest == 2. Else dest == 0 or -2 */
-					fprintf(assemblyFile, "SGE\t%s, %s, %s;\n", dest, dest, true_reg);
-					/* dest == 1 (true) or 0 (false) */
-					fprintf(assemblyFile, "SUB\t%s, %s, %s;\n", dest, zero_reg, dest);
-					/* dest == -1 (true) or 0 (false) */
-					fprintf(assemblyFile, "CMP\t%s, %s, %s, %s;\n", dest, dest, true_reg, false_reg);
-					/* dest == 1 or -1, finally, which is what we want. */
+					note = "# binary AND:\n";
+					d = gen_op(g, IR_ADD, type, a, b, no_src);
+					/* If both true, d == 2. Else d == 0 or -2 */
+					d = gen_op(g, IR_SGE, type, gen_src(d, IR_IDENTITY), g->truth, no_src);
+					d = gen_bool(g, type, d);
 					break;
 				case _OR:
-					fprintf(assemblyFile, "# binary OR:\n");
-					fprintf(assemblyFile, "ADD\t%s, %s, %s;\n", dest, buf1, buf2);
-                                        /* If either true, dest >= 0. Else dest -2 */
-                                        fprintf(assemblyFile, "SGE\t%s, %s, %s;\n", dest, dest, zero_reg);
-                                        /* dest == 1 (true) or 0 (false) */
-                                        fprintf(assemblyFile, "SUB\t%s, %s, %s;\n", dest, zero_reg, dest);
-                                        /* dest == -1 (true) or 0 (false) */
-                                        fprintf(assemblyFile, "CMP\t%s, %s, %s, %s;\n", dest, dest, true_reg, false_reg);
-                                        /* dest == 1 (true) or -1 (false) */
-                                        break;
+					note = "# binary OR:\n";
+					d = gen_op(g, IR_ADD, type, a, b, no_src);
+					/* If either true, d >= 0. Else d == -2 */
+					d = gen_op(g, IR_SGE, type, gen_src(d, IR_IDENTITY), g->zero, no_src);
+					d = gen_bool(g, type, d);
+					break;
 				case _EQ:
-					fprintf(assemblyFile, "# binary EQ:\n");
-					fprintf(assemblyFile, "SUB\t%s, %s, %s;\n", dest, buf1, buf2);
-					/* dest == 0 if buf1 == buf2 */
-					fprintf(assemblyFile, "ABS\t%s, %s;\n", dest, dest);
-					/* dest > 0 if buf1 != buf2 */
-					fprintf(assemblyFile, "SUB\t%s, %s, %s;\n", dest, zero_reg, dest);
-					/* dest < 0 if buf1 != buf2 */
-					fprintf(assemblyFile, "CMP\t%s, %s, %s, %s;\n", dest, dest, false_reg, true_reg);
-					/* dest == 1 (true) or -1 (false) */
-                                        break;
+					note = "# binary EQ:\n";
+					d = gen_op(g, IR_SUB, type, a, b, no_src);
+					/* d == 0 if a == b */
+					d = gen_op(g, IR_ABS, type, gen_src(d, IR_IDENTITY), no_src, no_src);
+					/* d > 0 if a != b */
+					d = gen_op(g, IR_SUB, type, g->zero, gen_src(d, IR_IDENTITY), no_src);
+					/* d < 0 if a != b */
+					d = gen_op(g, IR_CMP, type, gen_src(d, IR_IDENTITY), g->falsity, g->truth);
+					break;
 				case _NEQ:
-					fprintf(assemblyFile, "# binary NEQ:\n");
-                                        fprintf(assemblyFile, "SUB\t%s, %s, %s;\n", dest, buf1, buf2);
-                                        /* dest == 0 if buf1 == buf2 */
-                                        fprintf(assemblyFile, "ABS\t%s, %s;\n", dest, dest);
-                                        /* dest > 0 if buf1 != buf2 */
-                                        fprintf(assemblyFile, "SUB\t%s, %s, %s;\n", dest, zero_reg, dest);
-                                        /* dest < 0 if buf1 != buf2 */
-                                        fprintf(assemblyFile, "CMP\t%s, %s, %s, %s;\n", dest, dest, true_reg, false_reg);
-                                        /* dest == 1 (true) or -1 (false) */
-                                        break;
+					note = "# binary NEQ:\n";
+					d = gen_op(g, IR_SUB, type, a, b, no_src);
+					d = gen_op(g, IR_ABS, type, gen_src(d, IR_IDENTITY), no_src, no_src);
+					/* d > 0 if a != b */
+					d = gen_bool(g, type, d);
+					break;
 				case '<':
-					fprintf(assemblyFile, "# binary <:\n");
-					fprintf(assemblyFile, "SLT\t%s, %s, %s;\n", dest, buf1, buf2);
-                                        /* dest == 1 if buf1 < buf2, otherwise dest == 0 */
-                                        fprintf(assemblyFile, "SUB\t%s, %s, %s;\n", dest, zero_reg, dest);
-                                        /* dest == -1 (true) or 0 (false) */
-                                        fprintf(assemblyFile, "CMP\t%s, %s, %s, %s;\n", dest, dest, true_reg, false_reg);
-                                        /* dest == 1 (true) or -1 (false) */
-                                        break;
+					note = "# binary <:\n";
+					d = gen_bool(g, type, gen_op(g, IR_SLT, type, a, b, no_src));
+					break;
 				case _LEQ:
-					fprintf(assemblyFile, "# binary LEQ:\n");
-                                        fprintf(assemblyFile, "SGE\t%s, %s, %s;\n", dest, buf2, buf1);
-                                        /* dest == 1 (true) or 0 (false) */
-                                        fprintf(assemblyFile, "SUB\t%s, %s, %s;\n", dest, zero_reg, dest);
-                                        /* dest == -1 (true) or 0 (false) */
-                                        fprintf(assemblyFile, "CMP\t%s, %s, %s, %s;\n", dest, dest, true_reg, false_reg);
-                                        /* dest == 1 (true) or -1 (false) */
+					note = "# binary LEQ:\n";
+					d = gen_bool(g, type, gen_op(g, IR_SGE, type, b, a, no_src));
 					break;
 				case '>':
-					fprintf(assemblyFile, "# binary >:\n");
-					fprintf(assemblyFile, "SLT\t%s, %s, %s;\n", dest, buf2, buf1);
-                                        /* dest == 1 if buf1 > buf2, otherwise dest == 0 */
-                                        fprintf(assemblyFile, "SUB\t%s, %s, %s;\n", dest, zero_reg, dest);
-                                        /* dest == -1 (true) or 0 (false) */
-                                        fprintf(assemblyFile, "CMP\t%s, %s, %s, %s;\n", dest, dest, true_reg, false_reg);
-                                        /* dest == 1 (true) or -1 (false) */
+					note = "# binary >:\n";
+					d = gen_bool(g, type, gen_op(g, IR_SLT, type, b, a, no_src));
 					break;
 				case _GEQ:
-					fprintf(assemblyFile, "# binary GEQ:\n");
-                                        fprintf(assemblyFile, "SGE\t%s, %s, %s;\n", dest, buf1, buf2);
-                                        /* dest == 1 (true) or 0 (false) */
-                                        fprintf(assemblyFile, "SUB\t%s, %s, %s;\n", dest, zero_reg, dest);
-                                        /* dest == -1 (true) or 0 (false) */
-                                        fprintf(assemblyFile, "CMP\t%s, %s, %s, %s;\n", dest, dest, true_reg, false_reg);
-                                        /* dest == 1 (true) or -1 (false) */
+					note = "# binary GEQ:\n";
+					d = gen_bool(g, type, gen_op(g, IR_SGE, type, a, b, no_src));
 					break;
 				case '+':
-					fprintf(assemblyFile, "# binary +:\n");
-                                        fprintf(assemblyFile, "ADD\t%s, %s, %s;\n", dest, buf1, buf2);
+					note = "# binary +:\n";
+					d = gen_op(g, IR_ADD, type, a, b, no_src);
 					break;
 				case '-':
-					fprintf(assemblyFile, "# binary -:\n");
-                                        fprintf(assemblyFile, "SUB\t%s, %s, %s;\n", dest, buf1, buf2);
+					note = "# binary -:\n";
+					d = gen_op(g, IR_SUB, type, a, b, no_src);
 					break;
 				case '*':
-					fprintf(assemblyFile, "# binary *:\n");
-                                        fprintf(assemblyFile, "MUL\t%s, %s, %s;\n", dest, buf1, buf2);
+					note = "# binary *:\n";
+					d = gen_op(g, IR_MUL, type, a, b, no_src);
 					break;
 				case '/':
-					fprintf(assemblyFile, "# binary /:\n");
-                                        fprintf(assemblyFile, "RCP\t%s, %s;\n", dest, buf2);
-					fprintf(assemblyFile, "MUL\t%s, %s, %s;\n", dest, buf1, dest);
+					note = "# binary /:\n";
+					d = gen_op(g, IR_RCP, type, b, no_src, no_src);
+					d = gen_op(g, IR_MUL, type, a, gen_src(d, IR_IDENTITY), no_src);
 					break;
 				case '^':
-					fprintf(assemblyFile, "# binary ^:\n");
-                                        fprintf(assemblyFile, "POW\t%s, %s, %s;\n", dest, buf1, buf2);
+					note = "# binary ^:\n";
+					d = gen_op(g, IR_POW, type, a, b, no_src);
 					break;
 				default:
-					strncpy(dest, "genCode_expr: Error: Unimplemented.", MAX_BUF_LEN);
-                                        break;
+					break;
 			}
-
-			free_tempreg(buf1);
-      	                free_tempreg(buf2);
-
-                    	strncpy(result, dest, MAX_BUF_LEN);
-
 			break;
 		case BOOL_NODE:
-			get_tempreg(dest);
-			if(ast->bool_lit.value == TRUE){
-				fprintf(assemblyFile, "MOV\t%s, %s;\n", dest, true_reg);
-			}
-			else{
-				fprintf(assemblyFile, "MOV\t%s, %s;\n", dest, false_reg);
-			}
-			strncpy(result, dest, MAX_BUF_LEN);
+			d = gen_op(g, IR_MOV, type, ast->bool_lit.value == TRUE ? g->truth : g->falsity, no_src, no_src);
 			break;
 		case INT_NODE:
-			get_tempreg(dest);
-			sprintf(value, "%d", ast->int_lit.value);
-			fprintf(assemblyFile, "MOV\t%s, %s;\n", dest, value);
-			strncpy(result, dest, MAX_BUF_LEN);
+			c = gen_const(g, type, (float) ast->int_lit.value, 0);
+			d = gen_op(g, IR_MOV, type, gen_src(c, IR_IDENTITY), no_src, no_src);
 			break;
 		case FLOAT_NODE:
-			get_tempreg(dest);
-                        sprintf(value, "%f", ast->float_lit.value);
-                        fprintf(assemblyFile, "MOV\t%s, %s;\n", dest, value);
-                        strncpy(result, dest, MAX_BUF_LEN);
-                        break;
-		case VAR_NODE:
-			var_to_assembly(result, ast->var.name, ast->var.ofs);
+			c = gen_const(g, type, ast->float_lit.value, 0);
+			d = gen_op(g, IR_MOV, type, gen_src(c, IR_IDENTITY), no_src, no_src);
 			break;
+		case VAR_NODE:
+			return gen_read(cs, g, ast);
 		case FUNCTION_NODE:
-			fprintf(assemblyFile, "# function call:\n");
-			arg_count = 0;
-			genCode_args(ast->function.args_opt, &arg_count, buf1, buf2, buf3, buf4);
-			get_tempreg(dest);
-			
-			if(ast->function.func == DP3){
-				fprintf(assemblyFile, "DP3\t%s, %s, %s;\n", dest, buf1, buf2);
-				free_tempreg(buf1);
-                        	free_tempreg(buf2);
-			}
-			else if(ast->function.func == LIT){
-				fprintf(assemblyFile, "LIT\t%s, %s;\n", dest, buf1);
-				free_tempreg(buf1);
-			}
-			else{ /* RSQ */
-				fprintf(assemblyFile, "RSQ\t%s, %s;\n", dest, buf1);
-				free_tempreg(buf1);
-			}
+			note = "# function call:\n";
+			if(!gen_args(cs, g, ast, args))
+				break;
 
-			strncpy(result, dest, MAX_BUF_LEN);
+			if(ast->op == DP3)
+				d = gen_op(g, IR_DP3, type, args[0], args[1], no_src);
+			else if(ast->op == LIT)
+				d = gen_op(g, IR_LIT, type, args[0], no_src, no_src);
+			else /* RSQ */
+				d = gen_op(g, IR_RSQ, type, args[0], no_src, no_src);
 			break;
 		case CONSTRUCTOR_NODE:
-			fprintf(assemblyFile, "# constructor call:\n");
-			arg_count = 0;
-			genCode_args(ast->constructor.args_opt, &arg_count, buf1, buf2, buf3, buf4);
-                        get_tempreg(dest);
-
-			fprintf(assemblyFile, "MOV\t%s%s, %s;\n", dest, ".x", buf1);
-			free_tempreg(buf1);
-			if(arg_count > 1){ 
-				fprintf(assemblyFile, "MOV\t%s%s, %s;\n", dest, ".y", buf2);
-				free_tempreg(buf2);
-			}
-			if(arg_count > 2){
-				fprintf(assemblyFile, "MOV\t%s%s, %s;\n", dest, ".z", buf3);
-				free_tempreg(buf3);
-			}
-			if(arg_count > 3){
-				fprintf(assemblyFile, "MOV\t%s%s, %s;\n", dest, ".w", buf4);
-				free_tempreg(buf4);
-			}
+			note = "# constructor call:\n";
+			if(!gen_args(cs, g, ast, args))
+				break;
 
-			strncpy(result, dest, MAX_BUF_LEN);
+			/* One component an argument, each write keeping the
+			 * ones before it */
+			for(i = 0; i < ast->args.num; i++){
+				c = gen_op(g, IR_MOV, type, args[i], no_src, no_src);
+				IR_INSTR(g->ir, c)->mask = 1 << i;
+				IR_INSTR(g->ir, c)->prev = d;
+				d = c;
+			}
 			break;
 		default:
-			strncpy(result, "genCode_expr: Error: Unimplemented.", MAX_BUF_LEN);
 			break;
 	}
 
+	if(note != NULL && first < g->ir->num_instrs)
+		IR_INSTR(g->ir, first)->note = note;
+
+	return d != IR_NONE ? gen_src(d, IR_IDENTITY) : no_src;
+}
+
+/* Start the branches of an if, once its condition is built */
+static void gen_if(struct gen_walk *g){
+	struct gen_if *branches, *outer;
+	struct ir_src cond;
+	int i;
+
+	/*
+	 * Each branch's assignments select on a mask, negative where the
+	 * branch is not taken: the condition for the statement, its
+	 * negation for the else. Inside another if, both are also false
+	 * where the branch of the outer if is not taken.
+	 *
+	 *      if(EXPR1){ LEVEL1
+	 *              if(EXPR2){ LEVEL2
+	 *
+	 *              }
+	 *              else{ LEVEL2
+	 *
+	 *              }
+	 *      }
+	 *      else{ LEVEL2
+	 *
+	 *      }
+	 */
+	cond = gen_pop_result(g);
+
+	branches = (struct gen_if *) ast_stack_push(&g->ifs, sizeof *branches);
+	branches->branch = 0;
+	outer = g->ifs.len > sizeof *branches ? branches - 1 : NULL;
+
+	branches->mask[0] = gen_op(g, IR_MOV, BOOL, cond, no_src, no_src);
+	IR_INSTR(g->ir, branches->mask[0])->note = "# if/else statement:\n";
+	branches->mask[1] = gen_op(g, IR_CMP, BOOL, gen_src(branches->mask[0], IR_IDENTITY), g->truth, g->falsity);
+
+	if(outer){
+		for(i = 0; i < 2; i++)
+			branches->mask[i] = gen_op(g, IR_CMP, BOOL, gen_src(outer->mask[outer->branch], IR_IDENTITY),
+						   g->falsity, gen_src(branches->mask[i], IR_IDENTITY));
+	}
+
 	return;
 }
 
-/* Forward declarations for genCode_stmt */
-static void genCode_dclns(node *ast);
-static void genCode_stmts(node *ast, bool cond, char *condvar);
+/* Assign value to a variable, or to one of its components. Inside an if
+ * the variable keeps what it had where the branch isn't taken. */
+static void gen_assign(compile_session_t *cs, struct gen_walk *g, struct ast_node *ast, struct ir_src value){
+	const struct st_entry *ste = AST_SYMBOL(cs, ast->var.sym);
+	struct gen_var *var = gen_var(cs, g, ast->var.id, ste);
+	struct gen_if *cond = gen_top_if(g);
+	type_t type = ste != NULL ? ste->type : ANY;
+	int index = gen_index(ast);
+	ir_value_t old = IR_NONE, v;
+	struct ir_instr *in;
+
+	if(index > 3)
+		return;
+	if(cond || index != -1)
+		old = gen_var_value(g, var, type);
+
+	if(cond)
+		v = gen_op(g, IR_CMP, type, gen_src(cond->mask[cond->branch], IR_IDENTITY),
+			   gen_src(old, index == -1 ? IR_IDENTITY : IR_REPLICATE(index)), value);
+	else
+		v = gen_op(g, IR_MOV, type, value, no_src, no_src);
 
-static void genCode_stmt(node *ast, bool cond, char *condvar){
-	char buf1[MAX_BUF_LEN], buf2[MAX_BUF_LEN];
-	char new_condvar1[MAX_BUF_LEN], new_condvar2[MAX_BUF_LEN];	
+	in = IR_INSTR(g->ir, v);
+	in->home = var->home;
+	if(index != -1){
+		in->mask = 1 << index;
+		in->prev = old;
+	}
+	var->value = v;
 
-	if(ast == NULL) return;
+	return;
+}
+
+/* Build a declaration up to its initial value, returning whether that
+ * is still to be built */
+static int gen_dcln(compile_session_t *cs, node_t n, struct gen_walk *g){
+	struct ast_node *ast = AST_NODE(cs, n);
+	struct ast_node *init = AST_NODE(cs, ast->declaration.init_val);
+	const struct st_entry *ste = AST_SYMBOL(cs, ast->declaration.sym);
+	struct gen_var *var = gen_var(cs, g, ste->id, ste);
+	struct ir_src src;
+	ir_value_t v;
+
+	/* The initial value of a constant is either a literal or a uniform
+	 * variable; any other (already reported) is built as a variable's */
+	if(ste->is_cnst && init->kind == VAR_NODE){
+		src = gen_read(cs, g, init);
+		v = ir_add(g->ir, IR_PARAM, ste->type, var->home);
+		IR_INSTR(g->ir, v)->src[0] = src;
+		var->value = v;
+		return 0;
+	}
+	if(ste->is_cnst && (init->kind == BOOL_NODE || init->kind == INT_NODE || init->kind == FLOAT_NODE)){
+		if(init->kind == BOOL_NODE)
+			var->value = gen_const(g, AST_TYPE(cs, ast->declaration.init_val),
+					       init->bool_lit.value == TRUE ? 1.0 : -1.0, var->home);
+		else if(init->kind == INT_NODE)
+			var->value = gen_const(g, AST_TYPE(cs, ast->declaration.init_val),
+					       (float) init->int_lit.value, var->home);
+		else
+			var->value = gen_const(g, AST_TYPE(cs, ast->declaration.init_val),
+					       init->float_lit.value, var->home);
+		return 0;
+	}
+
+	ir_add(g->ir, IR_DECL, ste->type, var->home);
+	return ast->declaration.init_val != AST_NIL;
+}
+
+static int genCode_pre(compile_session_t *cs, node_t n, void *arg){
+	if(AST_NODE(cs, n)->kind == DECLARATION_NODE)
+		return gen_dcln(cs, n, (struct gen_walk *) arg);
+
+	return 1;
+}
+
+static int genCode_child(compile_session_t *cs, node_t n, unsigned int i, void *arg){
+	struct gen_walk *g = (struct gen_walk *) arg;
+	struct ast_node *ast = AST_NODE(cs, n);
 
 	switch(ast->kind){
 		case ASSIGNMENT_NODE:
-			genCode_expr(ast->assign_stmt.var, buf1);
-			genCode_expr(ast->assign_stmt.new_val, buf2);
-			
-			if(cond){ 
-				fprintf(assemblyFile, "CMP\t%s, %s, %s, %s;\n", buf1, condvar, buf1, buf2);
-			}
-			else{
-				fprintf(assemblyFile, "MOV\t%s, %s;\n", buf1, buf2);
-			}
-			
-			free_tempreg(buf2);
-			
-			break;
+			/* The variable is written, not read */
+			return i != 0;
 		case IF_STATEMENT_NODE:
-			/*
-			 * Inputs for if/else logic:
- 			 *      cond: We're in a conditional (if/else) statement.
-			 *      condvar: Register to use in our CMP instruction.
-			 *
-			 *      if(EXPR1){ LEVEL1
-			 *              if(EXPR2){ LEVEL2
-			 *
-			 *              }
-			 *              else{ LEVEL2
-			 *              
-			 *              }
-			 *      }
-			 *      else{ LEVEL2
-			 *
-			 *      }
-			 *
-			 * 1. If not already conditional (ie. we are LEVEL1):
-			 *	-Get 2 temporary registers (new_condvar1 and new_condvar2) 
-			 *	-Store EXPR1 in new_condvar1, !EXPR1 in new_condvar2
-			 *	-pass new_condvar1 to first statement
-			 *	-pass new_condvar2 to second statement
-			 * 2. If already conditional (ie. we are LEVELN, N > 1):
-			 *	-Get 2 temporary registers (new_condvar1, new_condvar2)
-			 *	-if condvar > 0 (ie. we are in a true branch) procede as in 1.
-			 *	-else (we are in a false branch) new_condvar1 = -1 and new_condvar2 = -1.
-			 */
-			genCode_expr(ast->if_stmt.expr, buf1);
-		
-			fprintf(assemblyFile, "# if/else statement:\n");
-	
-			get_tempreg(new_condvar1);
-			fprintf(assemblyFile, "MOV\t%s, %s;\n", new_condvar1, buf1);			
-			free_tempreg(buf1);
-
-			get_tempreg(new_condvar2);
-			fprintf(assemblyFile, "CMP\t%s, %s, %s, %s;\n", new_condvar2, new_condvar1, true_reg, false_reg);
-
-			if(cond){
-				fprintf(assemblyFile, "CMP\t%s, %s, %s, %s;\n", new_condvar1, condvar, false_reg, new_condvar1);
-				fprintf(assemblyFile, "CMP\t%s, %s, %s, %s;\n", new_condvar2, condvar, false_reg, new_condvar2);
-			}
+			if(i == 1)
+				gen_if(g);
+			else if(i == 2)
+				gen_top_if(g)->branch = 1;
+			break;
+		default:
+			break;
+	}
+
+	return 1;
+}
+
+static void genCode_post(compile_session_t *cs, node_t n, void *arg){
+	struct gen_walk *g = (struct gen_walk *) arg;
+	struct ast_node *ast = AST_NODE(cs, n);
+	const struct st_entry *ste;
+	ir_value_t v;
 
-			genCode_stmt(ast->if_stmt.stmt, TRUE, new_condvar1);
-			if(ast->if_stmt.opt_stmt != NULL)
-				genCode_stmt(ast->if_stmt.opt_stmt, TRUE, new_condvar2);
-		
-			free_tempreg(new_condvar1);
-			free_tempreg(new_condvar2);
-			
+	switch(ast->kind){
+		case ASSIGNMENT_NODE:
+			gen_assign(cs, g, AST_NODE(cs, ast->assign_stmt.var), gen_pop_result(g));
+			break;
+		case IF_STATEMENT_NODE:
+			ast_stack_pop(&g->ifs, sizeof(struct gen_if));
 			break;
 		case SCOPE_NODE:
-			genCode_dclns(ast->scope.declarations);
-			genCode_stmts(ast->scope.statements, cond, condvar);
+			break;
+		case DECLARATION_NODE:
+			/* The initial value, assigned whatever the ifs around */
+			ste = AST_SYMBOL(cs, ast->declaration.sym);
+			v = gen_op(g, IR_MOV, ste->type, gen_pop_result(g), no_src, no_src);
+			IR_INSTR(g->ir, v)->home = gen_var(cs, g, ste->id, ste)->home;
+			gen_var(cs, g, ste->id, ste)->value = v;
 			break;
 		default:
+			gen_push_result(g, gen_expr(cs, n, g));
 			break;
 	}
 
 	return;
 }
 
-static void genCode_stmts(node *ast, bool cond, char *condvar){
-	
-	if(ast == NULL) return;
+/* Build the IR of the tree under root, after the constants every
+ * program has */
+static void gen_program(compile_session_t *cs, node_t root, struct ir_program *ir){
+	struct gen_walk g;
+	struct ast_visitor builder = { genCode_pre, genCode_child, genCode_post, &g };
 
-	genCode_stmts(ast->statements.statements, cond, condvar);
-	genCode_stmt(ast->statements.statement, cond, condvar);
-	
-	return;
+	memset(&g, 0, sizeof g);
+	g.ir = ir;
+	g.num_symbols = cs->ast.num_symbols;
+	g.vars = (struct gen_var *) calloc(g.num_symbols + NUM_BUILTIN_VARS + cs->idents.num_names, sizeof(struct gen_var));
+	g.num_named = (unsigned int *) calloc(NUM_BUILTIN_VARS + cs->idents.num_names, sizeof(unsigned int));
+
+	g.zero = gen_src(gen_const(&g, FLOAT, 0.0, ir_add_home(ir, zero_reg, IR_HOME_PARAM)), IR_IDENTITY);
+	g.truth = gen_src(gen_const(&g, BOOL, 1.0, ir_add_home(ir, true_reg, IR_HOME_PARAM)), IR_IDENTITY);
+	g.falsity = gen_src(gen_const(&g, BOOL, -1.0, ir_add_home(ir, false_reg, IR_HOME_PARAM)), IR_IDENTITY);
+
+	ast_walk(cs, root, &builder);
+
+	ast_stack_free(&g.results);
+	ast_stack_free(&g.ifs);
+	free(g.vars);
+	free(g.num_named);
 }
 
-static void genCode_dcln(node *ast){
-	char buf[MAX_BUF_LEN];	
-	struct st_entry *ste;
+/*
+ * The ARB is written from the IR in order. Values without a home are
+ * given temporaries as they are defined, and hand them back after they
+ * are last read; a value writing only some components takes over the
+ * one of its prev.
+ */
+struct gen_emit{
+	struct ir_program *ir;
+	unsigned int *last;		/* see ir_last_uses() */
+	int *regs;			/* temporary of each value, -1 for none */
+	unsigned char *declared;	/* of each home, whether its TEMP is out */
+	struct tempreg_table trt;
+};
 
-	ste = st_lookup(ast->st, ast->declaration.var_name, LOCAL);
+/* The register holding a value, "" if it has none */
+static const char *emit_reg(compile_session_t *cs, struct gen_emit *e, ir_value_t v){
+	struct ir_instr *in = IR_INSTR(e->ir, v);
+
+	if(v == IR_NONE)
+		return "";
+	if(in->home)
+		return IR_HOME(e->ir, in->home)->name;
+	if(e->regs[v] < 0)
+		return "";
+	return e->trt.entries[e->regs[v]].regname;
+}
 
-	if(ste->is_cnst){
-		/* init_val is either a literal or a uniform variable */
-		if(ast->declaration.init_val->kind == VAR_NODE){
-			genCode_expr(ast->declaration.init_val, buf);
-			fprintf(assemblyFile, "PARAM\t%s = %s;\n", ast->declaration.var_name, buf);
-			/* No need to free_tempreg(buf), since buf won't be a tempreg */
-		}
-		else{ /* it's a literal */
-			if(ast->declaration.init_val->kind == BOOL_NODE){
-				if(ast->declaration.init_val->bool_lit.value == TRUE)
-					sprintf(buf, "%f", 1.0);
-				else sprintf(buf, "%f", -1.0);
-			}
-			else if(ast->declaration.init_val->kind == INT_NODE){
-				sprintf(buf, "%d", ast->declaration.init_val->int_lit.value);
-			}
-			else /* FLOAT_NODE */ 
-				sprintf(buf, "%f", ast->declaration.init_val->float_lit.value);
+/* A source operand: a literal in line, or a register and its swizzle */
+static void emit_src(compile_session_t *cs, struct gen_emit *e, const struct ir_src *src, char *buf){
+	struct ir_instr *in = IR_INSTR(e->ir, src->value);
+	size_t len;
+	int i;
 
-			fprintf(assemblyFile, "PARAM\t%s = %s;\n", ast->declaration.var_name, buf);
-		}
+	if(src->value != IR_NONE && in->op == IR_CONST && !in->home){
+		format_const(buf, in);
+		return;
 	}
-	else{ /* not const */
-		fprintf(assemblyFile, "TEMP\t%s;\n", ast->declaration.var_name);
-		if(ast->declaration.init_val != NULL){
-			genCode_expr(ast->declaration.init_val, buf);
-                	fprintf(assemblyFile, "MOV\t%s, %s;\n", ast->declaration.var_name, buf);
-                	free_tempreg(buf);
-		}
+
+	len = strlen(emit_reg(cs, e, src->value));
+	memcpy(buf, emit_reg(cs, e, src->value), len);
+	if(src->swizzle == IR_REPLICATE(IR_COMPONENT(src->swizzle, 0))){
+		buf[len++] = '.';
+		buf[len++] = components[IR_COMPONENT(src->swizzle, 0)];
+	} else if(src->swizzle != IR_IDENTITY){
+		buf[len++] = '.';
+		for(i = 0; i < 4; i++)
+			buf[len++] = components[IR_COMPONENT(src->swizzle, i)];
 	}
+	buf[len] = '\0';
+}
 
-	return;
+static void emit_instr(compile_session_t *cs, struct gen_emit *e, unsigned int p, ir_value_t v){
+	struct ir_instr *in = IR_INSTR(e->ir, v);
+	char srcs[3][SRC_TEXT_LEN];
+	ir_value_t s;
+	int i;
+
+	for(i = 0; i < ir_op_srcs[in->op]; i++)
+		emit_src(cs, e, &in->src[i], srcs[i]);
+
+	/* Sources read for the last time give their temporaries back
+	 * first, so the result can have one of them */
+	for(i = 0; i < ir_op_srcs[in->op]; i++){
+		s = in->src[i].value;
+		if(s != IR_NONE && s != in->prev && e->last[s] == p + 1)
+			free_tempreg(cs, &e->trt, e->regs[s]);
+	}
+
+	if(in->home == 0)
+		e->regs[v] = in->prev != IR_NONE ? e->regs[in->prev] : get_tempreg(cs, &e->trt);
+
+	if(in->note)
+		emit_text(cs, in->note);
+	emit_op(cs, (enum ir_op) in->op, emit_reg(cs, e, v), in->mask, srcs);
+
+	if(e->last[v] == 0)
+		free_tempreg(cs, &e->trt, e->regs[v]);
 }
 
-static void genCode_dclns(node *ast){
-	
-	if(ast == NULL) return;
+static void emit_program(compile_session_t *cs, struct ir_program *ir){
+	struct gen_emit e;
+	struct ir_instr *in;
+	char buf[SRC_TEXT_LEN];
+	unsigned int p;
+	ir_value_t v;
+
+	e.ir = ir;
+	e.last = ir_last_uses(ir);
+	e.regs = (int *) malloc(ir->num_instrs * sizeof(int));
+	e.declared = (unsigned char *) calloc(ir->num_homes, 1);
+	for(v = 0; v < ir->num_instrs; v++)
+		e.regs[v] = -1;
+	memset(&e.trt, 0, sizeof e.trt);
+
+	cs->code.len = 0;
+	emit_text(cs, "!!ARBfp1.0\n");
+
+	for(p = 0; p < ir->num_order; p++){
+		v = ir->order[p];
+		in = IR_INSTR(ir, v);
+
+		switch(in->op){
+			case IR_CONST:
+				if(in->home){
+					format_const(buf, in);
+					emit_param(cs, IR_HOME(ir, in->home)->name, buf);
+				}
+				break;
+			case IR_PARAM:
+				emit_src(cs, &e, &in->src[0], buf);
+				emit_param(cs, IR_HOME(ir, in->home)->name, buf);
+				break;
+			case IR_DECL:
+				if(!e.declared[in->home])
+					emit_temp(cs, IR_HOME(ir, in->home)->name);
+				e.declared[in->home] = 1;
+				break;
+			case IR_INPUT:
+				break;
+			default:
+				emit_instr(cs, &e, p, v);
+				break;
+		}
+	}
 
-	genCode_dclns(ast->declarations.declarations);
-	genCode_dcln(ast->declarations.declaration);
+	emit_text(cs, "END");
 
-	return;
+	free(e.last);
+	free(e.regs);
+	free(e.declared);
+	free(e.trt.entries);
 }
 
 /* No need for any assertions, we've already checked all that in our semantic analysis */
-void genCode(node *ast){
-
-	init_tempregs();
-	fprintf(assemblyFile, "!!ARBfp1.0\n");
-	init_utilregs();	
-	genCode_stmt(ast, FALSE, NULL);
-	fprintf(assemblyFile, "END");
+void genCode(compile_session_t *cs, node_t ast){
+	struct ir_program ir;
+
+	memset(&ir, 0, sizeof ir);
+	ir_reset(&ir);
+
+	gen_program(cs, ast, &ir);
+	ir_fold_constants(&ir);
+	ir_forward_copies(&ir);
+	ir_eliminate_dead_code(&ir);
+	ir_pool_constants(cs, &ir);
+	if(cs->dumpInstructions)
+		ir_dump(&ir, cs->dumpFile);
+	ir_verify(cs, &ir);
+	emit_program(cs, &ir);
+
+	ir_free(&ir);
 
 	return;
 }
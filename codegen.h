@@ -3,7 +3,16 @@
 
 #include "ast.h"
 
-/* Code generation function */
-void genCode(node *ast);
+/* The generated ARB program, grown as instructions are emitted and
+ * written out in one go. text is NUL terminated. */
+struct code_buffer{
+	char *text;
+	size_t len;
+	size_t size;
+};
+
+/* Code generation function. The program is left in the session's code
+ * buffer. */
+void genCode(compile_session_t *cs, node_t ast);
 
 #endif /* _CODEGEN_H_ */
@@ -27,31 +27,12 @@
 #define NUM_TYPES      13
 #define NUM_FUNCS	3
 #define NUM_OPS		13
-/********************************************************************** 
- * External declarations for variables declared in globalvars.c.
+/**********************************************************************
+ * All per-compile state (files, control flags, scanner/parser/AST and
+ * code generator state) lives in a compile session, see session.h.
  **********************************************************************/
-extern FILE * inputFile;
-extern FILE * outputFile;
-extern FILE * errorFile;
-extern FILE * dumpFile;
-extern FILE * traceFile;
-extern FILE * runInputFile;
-extern FILE * assemblyFile;
-
-extern int errorOccurred;
-extern int suppressExecution;
-
-extern int traceScanner;
-extern int traceParser;
-extern int traceExecution;
-
-extern int dumpSource;
-extern int dumpAST;
-extern int dumpSymbols;
-extern int dumpInstructions;
-
+typedef struct compile_session compile_session_t;
 typedef struct symbol_table symbol_table_t;
-extern symbol_table_t *st_curr;
 
 typedef enum {
   INT		= (1 << 3), 
@@ -69,9 +50,12 @@ typedef enum {
   ANY		= (1 << 11) | (1 << 7) | (1 << 3)
 } type_t;
 
+/* Types are also numbered densely, 0 to NUM_TYPES - 1, in the order of
+ * type_strings: int, ivec2 to 4, float, vec2 to 4, bool, bvec2 to 4, any */
 int print_type_index(type_t type);
 
 extern const char *type_strings[NUM_TYPES];
+extern const type_t type_values[NUM_TYPES];
 
 enum {
   _AND = 0,
@@ -12,36 +12,46 @@
 
 /***********************************************************************
  * The compiler has the following parts:
- * global variables     globalvars.c common.h languageDef.h
- * scanner module       scanner.c
+ * compile session      session.c    session.h    common.h
+ * phase statistics     stats.c      stats.h
+ * scanner module       handlex.c    (or scanner.l, make LEXER=flex)
  * parser module        parser.c     parser.tab.h
  * abstract syntax tree ast.c        ast.h
  * symbol table         symbol.c     symbol.h
+ * arena allocator      arena.c      arena.h
+ * float literals       literal.c    literal.h
  * semantics analysis   semantic.c   semantic.h
  * code generator       codegen.c    codegen.h
+ * batch compilation    batch.c      batch.h
+ * compile server       server.c     server.h
+ * library interface    cc467.c      cc467.h
+ * compile cache        cache.c      cache.h
+ * machine interpreter  machine.c    machine.h
  **********************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
 #include "common.h"
+#include "session.h"
 
 /* Phases 3,4: Uncomment following includes as needed */
 #include "ast.h"
 #include "symbol.h"
 #include "codegen.h"
+#include "batch.h"
+#include "server.h"
+#include "cache.h"
+#include "machine.h"
 
-/***********************************************************************
- * Default values for various files. Note assumption that default files
- * are not closed at the end of compilation.
- **********************************************************************/
-#define DEFAULT_INPUT_FILE     stdin
-#define DEFAULT_OUTPUT_FILE    stdout
-#define DEFAULT_ERROR_FILE     stderr
-#define DEFAULT_DUMP_FILE      stdout
-#define DEFAULT_TRACE_FILE     stdout
-#define DEFAULT_RUN_INPUT_FILE stdin
-#define DEFAULT_ASSEMBLY_FILE  stdout
+/* Options of the driver itself, rather than of a compile session */
+typedef struct {
+  batch_t batch;
+  const char *servePath;  /* --serve */
+  int cacheStats;         /* --cache-stats */
+} driver_opts_t;
 
-void  getOpts   (int numargs, char **argstr);
-FILE *fileOpen  (char *fileName, char *fileMode, FILE *defaultFile);
-void  sourceDump(void);
+void  getOpts   (compile_session_t *cs, driver_opts_t *opts, int numargs, char **argstr);
+int   runProgram(compile_session_t *cs);
 
 /* Phase 1: Scanner Interface. For phase 2 and after these declarations
  * are removed */
@@ -51,14 +61,21 @@ extern char *yytext;
 extern int   yyline;
  */
 
-/* Phase 2: Parser Interface. Merely uncomment the following line */
-extern int yyparse(void);
+/* Phase 2: Parser Interface. The parser is run by session_compile() */
 
 /***********************************************************************
  * Main program for the Compiler
  **********************************************************************/
 int main (int argc, char *argv[]) {
-  getOpts (argc, argv); /* Set up and apply command line options */
+  compile_session_t session;
+  compile_session_t *cs = &session;
+  driver_opts_t opts;
+  batch_t *batch = &opts.batch;
+  int failed;
+
+  session_init(cs);
+  memset(&opts, 0, sizeof opts);
+  getOpts (cs, &opts, argc, argv); /* Set up and apply command line options */
 
 /***********************************************************************
  * Compiler Initialization.
@@ -67,62 +84,70 @@ int main (int argc, char *argv[]) {
  * calls to initialization routines in the applicable modules are placed
  * here.
  **********************************************************************/
-  errorOccurred = FALSE;
+  cs->errorOccurred = FALSE;
+
+  if (cs->cacheDir)
+    cache_init(cs);
+
+  /* Only asked for the cache statistics */
+  if (opts.cacheStats && batch->numSources == 0) {
+    if (cs->cacheDir)
+      cache_print_stats(cs->cacheDir, cs->outputFile);
+    session_close(cs);
+    return 0;
+  }
+
+/***********************************************************************
+ * Server mode: compile requests from cc467client until killed
+ **********************************************************************/
+  if (opts.servePath) {
+    batch_free(batch);
+    failed = server_run(cs, opts.servePath);
+    session_close(cs);
+    return failed ? 1 : 0;
+  }
+
+/***********************************************************************
+ * Batch mode: every source file is a separate job with its own output
+ **********************************************************************/
+  if (batch->useBatch) {
+    failed = batch_run(cs, batch);
+    batch_free(batch);
+    if (opts.cacheStats && cs->cacheDir)
+      cache_print_stats(cs->cacheDir, cs->outputFile);
+    session_close(cs);
+    return failed ? 1 : 0;
+  }
+
+  if (batch->numSources == 1)
+    cs->inputFile = fileOpen(cs, batch->sources[0], "r", DEFAULT_INPUT_FILE);
+  batch_free(batch);
 
 /***********************************************************************
  * Start the Compilation
+ *
+ * Phase 1: Scanner, Phase 2: Parser, Phase 3: semantic checks and AST
+ * dump, Phase 4: code generation into "frag.txt". See session_compile().
+ * With a compile cache, an unchanged program skips all of these.
  **********************************************************************/
-  if (dumpSource)
-    sourceDump();
+  cache_compile(cs);
 
-/* Phase 1: Scanner. In phase 2 and after the following code should be
- * removed */
-/*
-  while (yylex())
-    if (errorOccurred)
-      break;
- */
+  if (opts.cacheStats && cs->cacheDir)
+    cache_print_stats(cs->cacheDir, cs->outputFile);
 
-/* Phase 2: Parser -- should allocate an AST, storing the reference in the
- * global variable "ast", and build the AST there. */
-  
-  if(1 == yyparse()) {
-    return 0; // parse failed
-  }
+/***********************************************************************
+ * Run the compiled program on the machine interpreter, unless -X or
+ * the program didn't compile
+ **********************************************************************/
+  if (!cs->suppressExecution && !cs->errorOccurred && cs->code.len > 0)
+    runProgram(cs);
 
-/* Phase 3: Call the AST dumping routine if requested */
-  if (dumpAST)
-    ast_print(ast);
-/* Phase 4: Add code to call the code generation routine */
-/* TODO: call your code generation routine here */
-  assemblyFile = fileOpen("frag.txt", "w", DEFAULT_ASSEMBLY_FILE);
-//  if (errorOccurred)
-  //  fprintf(outputFile,"Failed to compile\n");
-  //else{ 
-    genCode(ast);
- // }
 /***********************************************************************
  * Post Compilation Cleanup
  **********************************************************************/
 
-/* Make calls to any cleanup or finalization routines here. */
-  ast_free(ast);
-
   /* Clean up files if necessary */
-  if (inputFile != DEFAULT_INPUT_FILE)
-    fclose (inputFile);
-  if (errorFile != DEFAULT_ERROR_FILE)
-    fclose (errorFile);
-  if (dumpFile != DEFAULT_DUMP_FILE)
-    fclose (dumpFile);
-  if (traceFile != DEFAULT_TRACE_FILE)
-    fclose (traceFile);
-  if (outputFile != DEFAULT_OUTPUT_FILE)
-    fclose (outputFile);
-  if (runInputFile != DEFAULT_RUN_INPUT_FILE)
-    fclose (runInputFile);
-  if (assemblyFile != DEFAULT_ASSEMBLY_FILE)
-    fclose (assemblyFile);
+  session_close(cs);
 
   return 0;
 }
@@ -131,34 +156,35 @@ int main (int argc, char *argv[]) {
 Internal Subroutines.
 ***********************************************************************/
 
+/***********************************************************************
+Load the program just generated and run it over the run input. Returns
+the number of fragments run, or -1 if the program can't be loaded.
+***********************************************************************/
+int runProgram (compile_session_t *cs) {
+  machine_t *m;
+  long fragments;
+
+  m = machine_load (cs, cs->code.text, cs->code.len);
+  if (m == NULL)
+    return -1;
+  fragments = machine_run (cs, m);
+  machine_free (m);
+  return (int) fragments;
+}
+
 /***********************************************************************
 Subroutines for reading command line input and initializing IO files.
 ***********************************************************************/
-void getOpts (int numargs, char **argstr) {
+void getOpts (compile_session_t *cs, driver_opts_t *opts, int numargs, char **argstr) {
+  batch_t *batch = &opts->batch;
   char *optarg;
+  char *end;
   char *subarg;
   int   i;
   char  optch;
 
-  /* Initialize global variables to default values */
-  inputFile         = DEFAULT_INPUT_FILE;
-  outputFile        = DEFAULT_OUTPUT_FILE;
-  errorFile         = DEFAULT_ERROR_FILE;
-  dumpFile          = DEFAULT_DUMP_FILE;
-  traceFile         = DEFAULT_TRACE_FILE;
-  runInputFile      = DEFAULT_RUN_INPUT_FILE;
-
-  /* Initialize control flags */
-  suppressExecution = FALSE;
-
-  traceScanner      = FALSE;
-  traceParser       = FALSE;
-  traceExecution    = FALSE;
-
-  dumpSource        = FALSE;
-  dumpAST           = FALSE;
-  dumpSymbols       = FALSE;
-  dumpInstructions  = FALSE;
+  /* Files and control flags start out at the defaults set by
+   * session_init() */
 
   /* Process command line input */
   for (i=1; i<numargs; i++) {
@@ -170,23 +196,25 @@ void getOpts (int numargs, char **argstr) {
           optch = *(subarg++);
           while (optch) {
             switch (optch) {
-              case 'a': dumpAST          = TRUE; break;
-              case 's': dumpSource       = TRUE; break;
-              case 'x': dumpInstructions = TRUE; break;
-              case 'y': dumpSymbols      = TRUE; break;
-              default: fprintf(errorFile, "Invalid dump option %c ignored\n", optch); break ;
+              case 'a': cs->dumpAST          = TRUE; break;
+              case 's': cs->dumpSource       = TRUE; break;
+              case 'x': cs->dumpInstructions = TRUE; break;
+              case 'y': cs->dumpSymbols      = TRUE; break;
+              default: fprintf(cs->errorFile, "Invalid dump option %c ignored\n", optch); break ;
             }
             optch = *(subarg++);
           }
           break;
-        case 'T': /* Trace options -Tnpx */
+        case 'T': /* Trace options -Tnpxsj */
           optch = *(subarg++);
           while (optch) {
             switch (optch) {
-              case 'n': traceScanner   = TRUE; break;
-              case 'p': traceParser    = TRUE; break;
-              case 'x': traceExecution = TRUE; break;
-              default: fprintf(errorFile, "Invalid trace option %c ignored\n", optch); break;
+              case 'n': cs->traceScanner   = TRUE; break;
+              case 'p': cs->traceParser    = TRUE; break;
+              case 'x': cs->traceExecution = TRUE; break;
+              case 's': cs->traceStats    |= STATS_TEXT; break;
+              case 'j': cs->traceStats    |= STATS_JSON; break;
+              default: fprintf(cs->errorFile, "Invalid trace option %c ignored\n", optch); break;
             }
             optch = *(subarg++);
           }
@@ -195,77 +223,82 @@ void getOpts (int numargs, char **argstr) {
           printf("Blaaaaa\n");
           if (optarg[2] == 0) {
             i += 1;
-            outputFile = fileOpen (argstr[i], "w", DEFAULT_OUTPUT_FILE);
+            cs->outputFile = fileOpen (cs, argstr[i], "w", DEFAULT_OUTPUT_FILE);
           printf("%s\n",argstr[i]);
           } else
-            outputFile = fileOpen (&optarg[2], "w", DEFAULT_OUTPUT_FILE);
+            cs->outputFile = fileOpen (cs, &optarg[2], "w", DEFAULT_OUTPUT_FILE);
           printf("%s\n",&optarg[2]);
           break;
         case 'E': /* Alternative error message file */
           if (optarg[2] == 0) {
             i += 1;
-            errorFile = fileOpen (argstr[i], "w", DEFAULT_OUTPUT_FILE);
+            cs->errorFile = fileOpen (cs, argstr[i], "w", DEFAULT_OUTPUT_FILE);
           } else
-            errorFile = fileOpen (&optarg[2], "w", DEFAULT_ERROR_FILE);
+            cs->errorFile = fileOpen (cs, &optarg[2], "w", DEFAULT_ERROR_FILE);
           break;
         case 'R': /* Alternative sink for traces */
           if (optarg[2] == 0) {
             i += 1;
-            traceFile = fileOpen (argstr[i], "w", DEFAULT_TRACE_FILE);
+            cs->traceFile = fileOpen (cs, argstr[i], "w", DEFAULT_TRACE_FILE);
           } else
-            traceFile = fileOpen (&optarg[2], "w", DEFAULT_TRACE_FILE);
+            cs->traceFile = fileOpen (cs, &optarg[2], "w", DEFAULT_TRACE_FILE);
           break;
         case 'U': /* Alternative sink for dumps */
           if (optarg[2] == 0) {
             i += 1;
-            dumpFile = fileOpen (argstr[i], "w", DEFAULT_DUMP_FILE);
+            cs->dumpFile = fileOpen (cs, argstr[i], "w", DEFAULT_DUMP_FILE);
           } else
-            dumpFile = fileOpen (&optarg[2], "w", DEFAULT_DUMP_FILE);
+            cs->dumpFile = fileOpen (cs, &optarg[2], "w", DEFAULT_DUMP_FILE);
           break;
         case 'I': /* Alternative input during execution */
           if (optarg[2] == 0) {
             i += 1;
-            runInputFile = fileOpen (argstr[i], "r", DEFAULT_RUN_INPUT_FILE);
+            cs->runInputFile = fileOpen (cs, argstr[i], "r", DEFAULT_RUN_INPUT_FILE);
           } else
-            runInputFile = fileOpen (&optarg[2], "r", DEFAULT_RUN_INPUT_FILE);
+            cs->runInputFile = fileOpen (cs, &optarg[2], "r", DEFAULT_RUN_INPUT_FILE);
           break;
         case 'X': /* supress execution flag */
-          suppressExecution = TRUE;
+          cs->suppressExecution = TRUE;
+          break;
+        case 'M': /* Manifest of source files for batch mode */
+          if (optarg[2] == 0) {
+            i += 1;
+            batch_read_manifest (cs, batch, argstr[i]);
+          } else
+            batch_read_manifest (cs, batch, &optarg[2]);
+          break;
+        case 'J': /* Number of batch compilation threads */
+          if (optarg[2] == 0) {
+            i += 1;
+            batch->numThreads = atoi (argstr[i]);
+          } else
+            batch->numThreads = atoi (&optarg[2]);
+          break;
+        case '-': /* Long options */
+          if (strcmp(optarg, "--serve") == 0)
+            opts->servePath = SERVER_DEFAULT_SOCKET;
+          else if (strncmp(optarg, "--serve=", 8) == 0)
+            opts->servePath = &optarg[8];
+          else if (strncmp(optarg, "--cache=", 8) == 0)
+            cs->cacheDir = &optarg[8];
+          else if (strncmp(optarg, "--cache-size=", 13) == 0) {
+            cs->cacheMaxSize = strtol(&optarg[13], &end, 10);
+            switch (*end) {
+              case 'G': case 'g': cs->cacheMaxSize <<= 10; /* fall through */
+              case 'M': case 'm': cs->cacheMaxSize <<= 10; /* fall through */
+              case 'K': case 'k': cs->cacheMaxSize <<= 10; break;
+              default: break;
+            }
+          } else if (strcmp(optarg, "--cache-stats") == 0)
+            opts->cacheStats = TRUE;
+          else
+            fprintf(cs->errorFile, "Unknown option %s (ignored)\n", optarg);
           break;
         default: /* Anything else */
           fprintf(stderr,"Unknown option character %c (ignored)\n", optch);
           break;
       }
     } else /* Source file */
-      inputFile = fileOpen(optarg , "r", DEFAULT_INPUT_FILE);
+      batch_add_source (batch, optarg);
   }
 }
-
-/***********************************************************************
- * Utility for opening files 
- **********************************************************************/
-FILE *fileOpen (char *fileName, char *fileMode, FILE *defaultFile) {
-  FILE * fTemp;
-
-  if ((fTemp = fopen (fileName, fileMode)) != NULL)
-    return fTemp;
-  else {
-    fprintf (errorFile, "Unable to open file %s\n", fileName);
-    return defaultFile;
-  }
-}
-
-/***********************************************************************
- * Dump source file, with line numbers.
- **********************************************************************/
-void sourceDump (void) {
-  char srcbuf[MAX_TEXT];
-  int i = 0;
-
-  while (fgets(srcbuf, MAX_TEXT, inputFile)) {
-    i += 1;
-    fprintf(dumpFile, "%3d: %s", i, srcbuf);
-  }
-  rewind(inputFile);
-}
-
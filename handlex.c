@@ -0,0 +1,484 @@
+/**********************************************************************
+ *
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ *  Hand-written scanner for CSC467 course project, built by default
+ *  in place of the flex scanner in scanner.l (make LEXER=flex builds
+ *  that one). It returns the same tokens and values and reports
+ *  the same errors; blanks, comments and identifiers are scanned a
+ *  vector at a time with SSE2, or AVX2 when built with -mavx2.
+ **********************************************************************/
+
+#include <stdlib.h>
+#include <limits.h>
+#include <errno.h>
+#include <string.h>
+
+#include "common.h"
+#include "session.h"
+#include "stats.h"
+#include "literal.h"
+#include "ast.h"
+#include "parser.tab.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+typedef __m256i vec_t;
+#define VEC_WIDTH     32
+#define VEC_ALL       0xffffffffu
+#define vec_load(p)   _mm256_loadu_si256((const __m256i *) (p))
+#define vec_splat(c)  _mm256_set1_epi8(c)
+#define vec_eq(a, b)  _mm256_cmpeq_epi8(a, b)
+#define vec_gt(a, b)  _mm256_cmpgt_epi8(a, b)
+#define vec_and(a, b) _mm256_and_si256(a, b)
+#define vec_or(a, b)  _mm256_or_si256(a, b)
+#define vec_mask(v)   ((unsigned) _mm256_movemask_epi8(v))
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+typedef __m128i vec_t;
+#define VEC_WIDTH     16
+#define VEC_ALL       0xffffu
+#define vec_load(p)   _mm_loadu_si128((const __m128i *) (p))
+#define vec_splat(c)  _mm_set1_epi8(c)
+#define vec_eq(a, b)  _mm_cmpeq_epi8(a, b)
+#define vec_gt(a, b)  _mm_cmpgt_epi8(a, b)
+#define vec_and(a, b) _mm_and_si128(a, b)
+#define vec_or(a, b)  _mm_or_si128(a, b)
+#define vec_mask(v)   ((unsigned) _mm_movemask_epi8(v))
+#endif
+
+#define yTRACE(x)    { if (cs->traceScanner) fprintf(cs->traceFile, "TOKEN %3d : %s\n", x, yytext); }
+#define yERROR(x)    { fprintf(cs->errorFile, "\nLEXICAL ERROR, LINE %d: %s\n", cs->yyline, x); sourceQuote(cs, cs->yyline); cs->errorOccurred = TRUE; }
+#define yOUT(x)      { yTRACE(x); return x; }
+
+/* Constants used later */
+enum {
+  MAX_INT_LIT = (1 << 21) - 1,
+  MIN_INT_LIT = -MAX_INT_LIT,
+  MAX_IDENT_LEN = 32,
+  SHORT_RUN = 8         /* characters scanned before using vectors */
+};
+
+/* Scanner state, one per session (cs->scanner). As with flex, the
+ * character after the current token is held and replaced with a NUL, so
+ * the token text (and a diagnostic's source quote) ends there; it is put
+ * back on the next call. */
+struct scanner {
+  char    *pos, *limit;
+  char    *text;
+  int      leng;
+  char    *hold_pos;
+  char     hold_char;
+  YYSTYPE *lval;        /* value of the token being scanned */
+};
+
+/* The state of the session in scope, under flex's names */
+#define yyg        ((struct scanner *) cs->scanner)
+#define yypos      (yyg->pos)
+#define yylimit    (yyg->limit)
+#define yytext     (yyg->text)
+#define yyleng     (yyg->leng)
+#define yylval     (*yyg->lval)
+
+/* Keywords, by perfect hash of their length and first and last
+ * characters (see keyword_hash) */
+struct keyword {
+  const char *text;
+  int len;
+  int token;
+  int value;            /* as_vec or as_func, -1 for none */
+};
+
+#define KEYWORD_SLOTS 32
+
+static const struct keyword keywords[KEYWORD_SLOTS] = {
+  /*  0 */ { "bool", 4, BOOL_T, -1 },
+  /*  1 */ { "true", 4, TRUE_C, -1 },
+  /*  2 */ { NULL, 0, 0, -1 },
+  /*  3 */ { "float", 5, FLOAT_T, -1 },
+  /*  4 */ { "dp3", 3, FUNC, 0 },
+  /*  5 */ { "lit", 3, FUNC, 1 },
+  /*  6 */ { NULL, 0, 0, -1 },
+  /*  7 */ { "const", 5, CONST, -1 },
+  /*  8 */ { NULL, 0, 0, -1 },
+  /*  9 */ { "int", 3, INT_T, -1 },
+  /* 10 */ { NULL, 0, 0, -1 },
+  /* 11 */ { NULL, 0, 0, -1 },
+  /* 12 */ { NULL, 0, 0, -1 },
+  /* 13 */ { NULL, 0, 0, -1 },
+  /* 14 */ { NULL, 0, 0, -1 },
+  /* 15 */ { NULL, 0, 0, -1 },
+  /* 16 */ { "if", 2, IF, -1 },
+  /* 17 */ { "bvec2", 5, BVEC_T, 1 },
+  /* 18 */ { "bvec3", 5, BVEC_T, 2 },
+  /* 19 */ { "bvec4", 5, BVEC_T, 3 },
+  /* 20 */ { "false", 5, FALSE_C, -1 },
+  /* 21 */ { "else", 4, ELSE, -1 },
+  /* 22 */ { "vec2", 4, VEC_T, 1 },
+  /* 23 */ { "vec3", 4, VEC_T, 2 },
+  /* 24 */ { "vec4", 4, VEC_T, 3 },
+  /* 25 */ { NULL, 0, 0, -1 },
+  /* 26 */ { "rsq", 3, FUNC, 2 },
+  /* 27 */ { NULL, 0, 0, -1 },
+  /* 28 */ { NULL, 0, 0, -1 },
+  /* 29 */ { "ivec2", 5, IVEC_T, 1 },
+  /* 30 */ { "ivec3", 5, IVEC_T, 2 },
+  /* 31 */ { "ivec4", 5, IVEC_T, 3 }
+};
+
+static unsigned keyword_hash(const char *text, int len) {
+  return (11 * len + 20 * (unsigned char) text[0] + (unsigned char) text[len - 1]) % KEYWORD_SLOTS;
+}
+
+/* The keyword spelt by the len characters at text, or NULL */
+static const struct keyword *find_keyword(const char *text, int len) {
+  const struct keyword *kw;
+
+  if (len < 2 || len > 5)
+    return NULL;
+  kw = &keywords[keyword_hash(text, len)];
+  if (kw->len != len || memcmp(kw->text, text, len))
+    return NULL;
+  return kw;
+}
+
+static int is_digit(int c) {
+  return c >= '0' && c <= '9';
+}
+
+static int is_alpha(int c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+#ifdef VEC_WIDTH
+/* Bit i set where p[i] is a letter, digit or underscore */
+static unsigned ident_mask(const char *p) {
+  vec_t v = vec_load(p);
+  vec_t lower = vec_or(v, vec_splat(0x20));
+  vec_t alpha = vec_and(vec_gt(lower, vec_splat('a' - 1)), vec_gt(vec_splat('z' + 1), lower));
+  vec_t digit = vec_and(vec_gt(v, vec_splat('0' - 1)), vec_gt(vec_splat('9' + 1), v));
+
+  return vec_mask(vec_or(vec_or(alpha, digit), vec_eq(v, vec_splat('_'))));
+}
+#endif
+
+/* Skip blanks and newlines, counting the lines. Most runs are short, so
+ * the first few characters are looked at one by one; the NULs past the
+ * end stop the scan. */
+static char *skip_space(compile_session_t *cs, char *p) {
+  int n;
+#ifdef VEC_WIDTH
+  unsigned space, newline;
+  vec_t v;
+#endif
+
+  for (n = 0; n < SHORT_RUN; n++, p++) {
+    if (*p == '\n')
+      cs->yyline++;
+    else if (*p != ' ' && *p != '\t')
+      return p;
+  }
+
+#ifdef VEC_WIDTH
+  while (yylimit - p >= VEC_WIDTH) {
+    v = vec_load(p);
+    newline = vec_mask(vec_eq(v, vec_splat('\n')));
+    space = newline | vec_mask(vec_or(vec_eq(v, vec_splat(' ')), vec_eq(v, vec_splat('\t'))));
+    if (space != VEC_ALL) {
+      n = __builtin_ctz(~space & VEC_ALL);
+      cs->yyline += __builtin_popcount(newline & ((1u << n) - 1));
+      return p + n;
+    }
+    cs->yyline += __builtin_popcount(newline);
+    p += VEC_WIDTH;
+  }
+#endif
+  for (; p < yylimit; p++) {
+    if (*p == '\n')
+      cs->yyline++;
+    else if (*p != ' ' && *p != '\t')
+      break;
+  }
+  return p;
+}
+
+/* Eat a C-style comment, p being just past the opening slash-star.
+ * Returns the end of the comment, or NULL if it is never closed. */
+static char *skip_comment(compile_session_t *cs, char *p) {
+  int lines = 0;
+#ifdef VEC_WIDTH
+  unsigned close, newline, n;
+  vec_t v;
+
+  while (yylimit - p > VEC_WIDTH) {
+    v = vec_load(p);
+    close = vec_mask(vec_and(vec_eq(v, vec_splat('*')), vec_eq(vec_load(p + 1), vec_splat('/'))));
+    newline = vec_mask(vec_eq(v, vec_splat('\n')));
+    if (close) {
+      n = __builtin_ctz(close);
+      cs->yyline += lines + __builtin_popcount(newline & ((1u << n) - 1));
+      return p + n + 2;
+    }
+    lines += __builtin_popcount(newline);
+    p += VEC_WIDTH;
+  }
+#endif
+  for (; p < yylimit; p++) {
+    if (p[0] == '*' && p[1] == '/') {
+      cs->yyline += lines;
+      return p + 2;
+    }
+    if (*p == '\n')
+      lines++;
+  }
+  return NULL;
+}
+
+/* The end of the identifier characters from p on, again looking at
+ * the first few one by one */
+static char *skip_ident(compile_session_t *cs, char *p) {
+  int n;
+#ifdef VEC_WIDTH
+  unsigned ident;
+#endif
+
+  for (n = 0; n < SHORT_RUN; n++, p++)
+    if (!is_alpha(*p) && !is_digit(*p))
+      return p;
+
+#ifdef VEC_WIDTH
+  while (yylimit - p >= VEC_WIDTH) {
+    ident = ident_mask(p);
+    if (ident != VEC_ALL)
+      return p + __builtin_ctz(~ident & VEC_ALL);
+    p += VEC_WIDTH;
+  }
+#endif
+  while (p < yylimit && (is_alpha(*p) || is_digit(*p)))
+    p++;
+  return p;
+}
+
+static char *skip_digits(compile_session_t *cs, char *p) {
+  while (p < yylimit && is_digit(*p))
+    p++;
+  return p;
+}
+
+/* Make the len characters at p the current token */
+static void set_token(compile_session_t *cs, char *p, int len) {
+  yytext = p;
+  yyleng = len;
+  yypos = p + len;
+  yyg->hold_pos = yypos;
+  yyg->hold_char = *yypos;
+  *yypos = '\0';
+}
+
+/* Convert a string to an integer token. */
+static int ParseInt(compile_session_t *cs) {
+  long num;
+
+  errno = 0;
+  num = strtol(yytext, NULL, 10);
+  if(ERANGE == errno) {
+    if(LONG_MAX == num || LONG_MIN == num) {
+      yERROR("Integer literal is out of range (case 1).");
+      return 0;
+    }
+  }
+
+  if(MAX_INT_LIT < num || MIN_INT_LIT > num) {
+    yERROR("Integer literal is out of range (case 2).");
+    return 0;
+  }
+
+  yylval.as_int = (int) num;
+  return 1;
+}
+
+/* Convert a string to a float token. */
+static int ParseFloat(compile_session_t *cs) {
+  float num;
+
+  switch(literal_parse_float(yytext, &num)) {
+  case LITERAL_HUGE:
+    yERROR("Floating point literal is out of range (case 1).");
+    return 0;
+  case LITERAL_RANGE:
+    /* out of range; we consider overflow but not underflow */
+    yERROR("Floating point literal is out of range (case 2).");
+    return 0;
+  }
+
+  yylval.as_float = num;
+  return 1;
+}
+
+/* Scan a number starting with a digit, following flex's longest match
+ * over the number rules of scanner.l */
+static int scan_number(compile_session_t *cs, char *p) {
+  char *digits = skip_digits(cs, p), *q;
+
+  if (digits < yylimit && is_alpha(*digits)) {
+    for (q = digits; q < yylimit && is_alpha(*q); q++)
+      ;
+    set_token(cs, p, q - p);
+    yERROR("Integers and identifiers/keywords must be separated by whitespace.");
+    return 0;
+  }
+
+  if (p[0] == '0' && digits - p > 1) {
+    set_token(cs, p, digits - p);
+    yERROR("Octal numbers are not allowed.");
+    return 0;
+  }
+
+  if (digits < yylimit && *digits == '.') {
+    set_token(cs, p, skip_digits(cs, digits + 1) - p);
+    if (ParseFloat(cs)) { yOUT(FLOAT_C); }
+    return 0;
+  }
+
+  set_token(cs, p, digits - p);
+  if (p[0] == '0') {
+    yylval.as_int = 0;
+    yOUT(INT_C);
+  }
+  if (ParseInt(cs)) { yOUT(INT_C); }
+  return 0;
+}
+
+/* Scan an identifier or keyword */
+static int scan_word(compile_session_t *cs, char *p) {
+  const struct keyword *kw;
+
+  set_token(cs, p, skip_ident(cs, p + 1) - p);
+  if ((kw = find_keyword(yytext, yyleng)) != NULL) {
+    if (kw->token == FUNC)
+      yylval.as_func = kw->value;
+    else if (kw->value >= 0)
+      yylval.as_vec = kw->value;
+    yOUT(kw->token);
+  }
+
+  if (MAX_IDENT_LEN < yyleng) {
+    yERROR("Identifier is too long.");
+    return 0;
+  }
+
+  yylval.as_id = intern(cs, yytext, yyleng);
+  yOUT(ID);
+}
+
+static int scanner_lex(YYSTYPE *lval, compile_session_t *cs) {
+  char *p, *end;
+  int line;
+
+  yyg->lval = lval;
+  if (yyg->hold_pos) {
+    *yyg->hold_pos = yyg->hold_char;
+    yyg->hold_pos = NULL;
+  }
+
+  p = yypos;
+  for (;;) {
+    p = skip_space(cs, p);
+    if (p[0] == '\r' && p[1] == '\n') {
+      cs->yyline++;
+      p += 2;
+    } else if (p[0] == '/' && p[1] == '*') {
+      line = cs->yyline;
+      if ((end = skip_comment(cs, p + 2)) == NULL) {
+        fprintf(cs->errorFile, "\nLEXICAL ERROR, LINE %d: Unmatched /*\n", line);
+        cs->errorOccurred = TRUE;
+        yypos = yylimit;
+        return 0;
+      }
+      p = end;
+    } else {
+      break;
+    }
+  }
+
+  if (p >= yylimit) {
+    yypos = yylimit;
+    return 0;
+  }
+
+  if (is_alpha(*p))
+    return scan_word(cs, p);
+  if (is_digit(*p))
+    return scan_number(cs, p);
+
+  switch (*p) {
+  case '.':
+    if (!is_digit(p[1]))
+      break;
+    set_token(cs, p, skip_digits(cs, p + 1) - p);
+    if (ParseFloat(cs)) { yOUT(FLOAT_C); }
+    return 0;
+
+  case '&':
+  case '|':
+    if (p[1] != p[0])
+      break;
+    set_token(cs, p, 2);
+    yOUT(p[0] == '&' ? AND : OR);
+
+  case '!': case '<': case '>': case '=':
+    if (p[1] == '=') {
+      set_token(cs, p, 2);
+      switch (p[0]) {
+      case '!': yOUT(NEQ);
+      case '<': yOUT(LEQ);
+      case '>': yOUT(GEQ);
+      default:  yOUT(EQ);
+      }
+    }
+    /* fall through */
+  case '+': case '-': case '*': case '/': case '^':
+  case '(': case ')': case '[': case ']': case '{': case '}':
+  case ';': case ',':
+    set_token(cs, p, 1);
+    yOUT(yytext[0]);
+  }
+
+  set_token(cs, p, 1);
+  yERROR("Unknown token");
+  yypos = yylimit;
+  return 0;
+}
+
+/* The parser's view of the scanner: count the tokens and, when
+ * reporting stats, time the scanning. */
+int yylex(YYSTYPE *lval, compile_session_t *cs) {
+  double start;
+  int token;
+
+  if(!cs->traceStats) {
+    token = scanner_lex(lval, cs);
+  } else {
+    start = stats_now();
+    token = scanner_lex(lval, cs);
+    cs->stats.time[PHASE_SCAN] += stats_now() - start;
+  }
+  if(token)
+    cs->stats.tokens++;
+  return token;
+}
+
+/* Point the session's scanner at its source, which it scans in place. */
+void scanner_restart(compile_session_t *cs) {
+  if (cs->scanner == NULL)
+    cs->scanner = malloc(sizeof(struct scanner));
+  memset(yyg, 0, sizeof(struct scanner));
+  yypos = cs->source;
+  yylimit = cs->source + cs->sourceLen;
+}
+
+/* Release the session's scanner */
+void scanner_free(compile_session_t *cs) {
+  free(cs->scanner);
+  cs->scanner = NULL;
+}
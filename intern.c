@@ -0,0 +1,107 @@
+#include <string.h>
+#include <stdlib.h>
+
+#include "common.h"
+#include "intern.h"
+#include "symbol.h"
+#include "session.h"
+
+static unsigned hash_name(const char *name, size_t len){
+	unsigned h = 2166136261u;
+	size_t i;
+
+	for(i = 0; i < len; i++)
+		h = (h ^ (unsigned char) name[i]) * 16777619u;
+	return h;
+}
+
+static const char *store_name(compile_session_t *cs, const char *name, size_t len){
+	char *copy = (char *) arena_alloc(&cs->arena, len + 1);
+
+	memcpy(copy, name, len);
+	copy[len] = '\0';
+	return copy;
+}
+
+/* Outgrown slots and names arrays stay in the arena until it is
+ * released: together they are smaller than the ones replacing them */
+static void grow_slots(compile_session_t *cs, struct interner *in){
+	int i, j;
+
+	in->num_slots = in->num_slots ? 2 * in->num_slots : 256;
+	in->slots = (int *) arena_alloc(&cs->arena, in->num_slots * sizeof(int));
+	memset(in->slots, 0, in->num_slots * sizeof(int));
+
+	for(i = 0; i < in->num_names; i++){
+		j = hash_name(in->names[i], strlen(in->names[i])) & (in->num_slots - 1);
+		while(in->slots[j])
+			j = (j + 1) & (in->num_slots - 1);
+		in->slots[j] = NUM_BUILTIN_VARS + i + 1;
+	}
+}
+
+/* The ID of a name already interned, or -1 with *slot set to the empty
+ * slot it would go in */
+static ident_t probe_name(struct interner *in, const char *name, size_t len, int *slot){
+	const char *known;
+	int i, id;
+
+	i = hash_name(name, len) & (in->num_slots - 1);
+	while((id = in->slots[i]) != 0){
+		known = in->names[id - 1 - NUM_BUILTIN_VARS];
+		if(!strncmp(known, name, len) && known[len] == '\0')
+			return id - 1;
+		i = (i + 1) & (in->num_slots - 1);
+	}
+	*slot = i;
+	return -1;
+}
+
+ident_t intern(compile_session_t *cs, const char *name, size_t len){
+	struct interner *in = &cs->idents;
+	const char **names;
+	int i, id;
+
+	if((id = st_builtin_index(name, len)) >= 0)
+		return id;
+
+	if(2 * (in->num_names + 1) > in->num_slots)
+		grow_slots(cs, in);
+
+	if((id = probe_name(in, name, len, &i)) >= 0)
+		return id;
+
+	if(in->num_names == in->max_names){
+		in->max_names = in->max_names ? 2 * in->max_names : 64;
+		names = (const char **) arena_alloc(&cs->arena, in->max_names * sizeof(char *));
+		if(in->num_names)
+			memcpy(names, in->names, in->num_names * sizeof(char *));
+		in->names = names;
+	}
+
+	id = NUM_BUILTIN_VARS + in->num_names;
+	in->names[in->num_names++] = store_name(cs, name, len);
+	in->slots[i] = id + 1;
+	return id;
+}
+
+ident_t ident_find(compile_session_t *cs, const char *name, size_t len){
+	struct interner *in = &cs->idents;
+	int i, id;
+
+	if((id = st_builtin_index(name, len)) >= 0)
+		return id;
+	if(in->num_slots == 0)
+		return -1;
+	return probe_name(in, name, len, &i);
+}
+
+const char *ident_name(compile_session_t *cs, ident_t id){
+	if(id < NUM_BUILTIN_VARS)
+		return st_builtin(id)->var_name;
+	return cs->idents.names[id - NUM_BUILTIN_VARS];
+}
+
+void intern_reset(compile_session_t *cs){
+	memset(&cs->idents, 0, sizeof cs->idents);
+}
@@ -0,0 +1,41 @@
+#ifndef _INTERN_H
+#define _INTERN_H
+
+#include <stddef.h>
+
+#include "common.h"
+
+/*
+ * Identifiers are interned once per compile session: every spelling gets
+ * one stable integer ID and one stored copy of its name, so names are
+ * compared as integers from the scanner on. The pre-defined variables
+ * have the fixed IDs 0 .. NUM_BUILTIN_VARS-1, their index in the table
+ * of built-ins, in every session. The names and the tables that find
+ * them are kept in the session's arena.
+ */
+typedef int ident_t;
+
+struct interner{
+	const char **names;		/* name of ID NUM_BUILTIN_VARS + i */
+	int num_names;
+	int max_names;
+
+	int *slots;			/* hash table of ID + 1, 0 if empty */
+	int num_slots;
+};
+
+/* The ID of the len characters at name, interning them if they are new */
+ident_t intern(compile_session_t *cs, const char *name, size_t len);
+
+/* The ID of the len characters at name if they have been interned,
+ * -1 if not */
+ident_t ident_find(compile_session_t *cs, const char *name, size_t len);
+
+/* The NUL terminated name of id, valid until the arena is released */
+const char *ident_name(compile_session_t *cs, ident_t id);
+
+/* Forget every name interned in the session, before its arena is
+ * released */
+void intern_reset(compile_session_t *cs);
+
+#endif /* _INTERN_H */
@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "session.h"
+#include "literal.h"
+#include "ir.h"
+
+const char *ir_op_names[NUM_IR_OPS] = {
+	"const", "input", "param", "decl",
+	"ABS", "ADD", "CMP", "DP3", "LIT", "MOV", "MUL",
+	"POW", "RCP", "RSQ", "SGE", "SLT", "SUB"
+};
+
+const unsigned char ir_op_srcs[NUM_IR_OPS] = {
+	0, 0, 1, 0,
+	1, 2, 3, 2, 1, 1, 2,
+	2, 1, 1, 2, 2, 2
+};
+
+static const char components[] = "xyzw";
+
+/* Double an array's capacity */
+static void *ir_grow(void *array, unsigned int *max, size_t size){
+	*max = *max ? 2 * *max : 256;
+	return realloc(array, *max * size);
+}
+
+void ir_reset(struct ir_program *ir){
+	ir->num_instrs = 1;
+	ir->num_order = 0;
+	ir->num_homes = 1;
+	if(!ir->instrs){
+		ir->instrs = (struct ir_instr *) ir_grow(ir->instrs, &ir->max_instrs, sizeof(struct ir_instr));
+		ir->homes = (struct ir_home *) ir_grow(ir->homes, &ir->max_homes, sizeof(struct ir_home));
+	}
+	memset(&ir->instrs[IR_NONE], 0, sizeof(struct ir_instr));
+	memset(&ir->homes[0], 0, sizeof(struct ir_home));
+}
+
+void ir_free(struct ir_program *ir){
+	free(ir->instrs);
+	free(ir->order);
+	free(ir->homes);
+	memset(ir, 0, sizeof(*ir));
+}
+
+unsigned int ir_add_home(struct ir_program *ir, const char *name, enum ir_home_kind kind){
+	struct ir_home *home;
+
+	if(ir->num_homes == ir->max_homes)
+		ir->homes = (struct ir_home *) ir_grow(ir->homes, &ir->max_homes, sizeof(struct ir_home));
+	home = &ir->homes[ir->num_homes];
+	home->name = name;
+	home->kind = (unsigned char) kind;
+	return ir->num_homes++;
+}
+
+ir_value_t ir_new(struct ir_program *ir, enum ir_op op, type_t type, unsigned int home){
+	struct ir_instr *in;
+
+	if(ir->num_instrs == ir->max_instrs)
+		ir->instrs = (struct ir_instr *) ir_grow(ir->instrs, &ir->max_instrs, sizeof(struct ir_instr));
+
+	in = &ir->instrs[ir->num_instrs];
+	memset(in, 0, sizeof(*in));
+	in->op = (unsigned char) op;
+	in->mask = IR_MASK_ALL;
+	in->type = (unsigned short) type;
+	in->home = home;
+	return ir->num_instrs++;
+}
+
+ir_value_t ir_add(struct ir_program *ir, enum ir_op op, type_t type, unsigned int home){
+	if(ir->num_order == ir->max_order)
+		ir->order = (ir_value_t *) ir_grow(ir->order, &ir->max_order, sizeof(ir_value_t));
+	ir->order[ir->num_order] = ir_new(ir, op, type, home);
+	return ir->order[ir->num_order++];
+}
+
+int ir_src_mask(const struct ir_instr *in, int i){
+	switch(in->op){
+	case IR_PARAM:
+		return IR_MASK_ALL;
+	case IR_DP3:
+		return 0x7;
+	case IR_LIT:
+		return 0xb;
+	case IR_POW:
+	case IR_RCP:
+	case IR_RSQ:
+		return 0x1;
+	default:
+		/* Component by component */
+		return IR_IS_ARB(in->op) ? in->mask : 0;
+	}
+}
+
+unsigned int *ir_last_uses(const struct ir_program *ir){
+	unsigned int *last = (unsigned int *) calloc(ir->num_instrs, sizeof(unsigned int));
+	const struct ir_instr *in;
+	unsigned int p, i;
+
+	for(p = 0; p < ir->num_order; p++){
+		in = &ir->instrs[ir->order[p]];
+		if(in->op == IR_CONST)
+			continue;
+		for(i = 0; i < ir_op_srcs[in->op]; i++)
+			last[in->src[i].value] = p + 1;
+		last[in->prev] = p + 1;
+	}
+	last[IR_NONE] = 0;
+	return last;
+}
+
+/*
+ * Checking a program
+ */
+
+static void ir_error(compile_session_t *cs, int *errors, ir_value_t v, const char *problem, const char *what){
+	fprintf(cs->errorFile, "IR ERROR: %%%u: %s%s\n", v, problem, what ? what : "");
+	cs->errorOccurred = TRUE;
+	(*errors)++;
+}
+
+/* Whether value r may be read at position p: defined before it, and a
+ * value at all */
+static void ir_check_read(compile_session_t *cs, const struct ir_program *ir, const unsigned int *defined,
+		unsigned int p, ir_value_t v, ir_value_t r, int *errors){
+	if(r == IR_NONE){
+		if(!cs->errorOccurred)
+			ir_error(cs, errors, v, "missing source", NULL);
+	} else if(r >= ir->num_instrs || !defined[r] || defined[r] > p)
+		ir_error(cs, errors, v, "reads a value not defined before it", NULL);
+	else if(ir->instrs[r].op == IR_DECL)
+		ir_error(cs, errors, v, "reads a declaration", NULL);
+}
+
+int ir_verify(compile_session_t *cs, const struct ir_program *ir){
+	unsigned int *defined = (unsigned int *) calloc(ir->num_instrs, sizeof(unsigned int));
+	ir_value_t *occupant = (ir_value_t *) calloc(ir->num_homes, sizeof(ir_value_t));
+	unsigned char *written = (unsigned char *) calloc(ir->num_homes, 1);
+	unsigned int *last = ir_last_uses(ir);
+	const struct ir_instr *in;
+	ir_value_t v, o;
+	unsigned int p, i;
+	int errors = 0;
+
+	/* Values are numbered in order, so each is defined at most once */
+	for(p = 0; p < ir->num_order; p++){
+		v = ir->order[p];
+		if(v == IR_NONE || v >= ir->num_instrs || defined[v])
+			ir_error(cs, &errors, v, "not a value, or defined twice", NULL);
+		else
+			defined[v] = p + 1;
+	}
+	if(errors)
+		goto done;
+
+	for(p = 0; p < ir->num_order; p++){
+		v = ir->order[p];
+		in = &ir->instrs[v];
+
+		if(in->op >= NUM_IR_OPS){
+			ir_error(cs, &errors, v, "unknown op", NULL);
+			continue;
+		}
+		if(!in->mask || in->mask > IR_MASK_ALL)
+			ir_error(cs, &errors, v, "bad write mask", NULL);
+		if(print_type_index((type_t) in->type) == NUM_TYPES - 1 && in->type != ANY && in->type != 0)
+			ir_error(cs, &errors, v, "bad type", NULL);
+		if(in->home >= ir->num_homes)
+			ir_error(cs, &errors, v, "bad home", NULL);
+
+		if(in->op != IR_CONST){
+			for(i = 0; i < ir_op_srcs[in->op]; i++)
+				ir_check_read(cs, ir, defined, p, v, in->src[i].value, &errors);
+			for(; i < 3; i++)
+				if(in->src[i].value != IR_NONE)
+					ir_error(cs, &errors, v, "too many sources for ", ir_op_names[in->op]);
+		}
+
+		switch(in->op){
+		case IR_CONST:
+			break;
+		case IR_INPUT:
+			if(!in->home)
+				ir_error(cs, &errors, v, "input without a home", NULL);
+			else if(written[in->home])
+				ir_error(cs, &errors, v, "input of a register after it is written: ", ir->homes[in->home].name);
+			break;
+		case IR_PARAM:
+		case IR_DECL:
+			if(!in->home)
+				ir_error(cs, &errors, v, "declaration without a home", NULL);
+			break;
+		default:
+			if(in->prev == IR_NONE)
+				break;
+			ir_check_read(cs, ir, defined, p, v, in->prev, &errors);
+			if(in->mask == IR_MASK_ALL)
+				ir_error(cs, &errors, v, "writes all of its value but has a prev", NULL);
+			if(last[in->prev] != p + 1)
+				ir_error(cs, &errors, v, "prev read after it is taken over", NULL);
+			if(in->home != ir->instrs[in->prev].home)
+				ir_error(cs, &errors, v, "prev in another home", NULL);
+			else if(!in->home && ir->instrs[in->prev].op == IR_CONST)
+				ir_error(cs, &errors, v, "prev in no register", NULL);
+			break;
+		}
+
+		/* The value it replaces in its home must be dead by now */
+		if(!in->home || in->home >= ir->num_homes || in->op == IR_DECL)
+			continue;
+		o = occupant[in->home];
+		if(o != IR_NONE && o != in->prev && last[o] > p + 1)
+			ir_error(cs, &errors, v, "overwrites a live value in ", ir->homes[in->home].name);
+		occupant[in->home] = v;
+		if(in->op != IR_INPUT)
+			written[in->home] = 1;
+	}
+
+done:
+	free(defined);
+	free(occupant);
+	free(written);
+	free(last);
+	return errors;
+}
+
+/*
+ * Dumping a program
+ */
+
+static void ir_dump_src(const struct ir_program *ir, const struct ir_src *src, FILE *out){
+	int i;
+
+	fprintf(out, "%%%u", src->value);
+	if(src->swizzle == IR_IDENTITY)
+		return;
+	fputc('.', out);
+	for(i = 0; i < 4; i++)
+		fputc(components[IR_COMPONENT(src->swizzle, i)], out);
+}
+
+static void ir_dump_const(const struct ir_instr *in, FILE *out){
+	char text[LITERAL_FLOAT_LEN];
+	int i;
+
+	for(i = 1; i < 4 && (!memcmp(&in->value[i], &in->value[0], sizeof(float)) || !(in->mask & (1 << i))); i++)
+		;
+	if(i == 4){
+		literal_format_float(text, in->value[0]);
+		fputs(text, out);
+		return;
+	}
+	for(i = 0; i < 4 && (in->mask & (1 << i)); i++){
+		literal_format_float(text, in->value[i]);
+		fprintf(out, "%s%s", i ? ", " : "{", text);
+	}
+	fputc('}', out);
+}
+
+void ir_dump(const struct ir_program *ir, FILE *out){
+	const struct ir_instr *in;
+	ir_value_t v;
+	unsigned int p, i;
+
+	fprintf(out, "# IR: %u instructions, %u registers\n", ir->num_order, ir->num_homes - 1);
+	for(p = 0; p < ir->num_order; p++){
+		v = ir->order[p];
+		in = &ir->instrs[v];
+		if(in->note)
+			fputs(in->note, out);
+
+		if(in->op == IR_DECL){
+			fprintf(out, "\tdecl @%s\n", ir->homes[in->home].name);
+			continue;
+		}
+
+		fprintf(out, "%%%u\t%s", v, type_strings[print_type_index((type_t) in->type)]);
+		if(in->home)
+			fprintf(out, " @%s", ir->homes[in->home].name);
+		fprintf(out, " = %s", ir_op_names[in->op]);
+		if(in->mask != IR_MASK_ALL && in->op != IR_CONST){
+			fputc('.', out);
+			for(i = 0; i < 4; i++)
+				if(in->mask & (1 << i))
+					fputc(components[i], out);
+		}
+
+		if(in->op == IR_CONST){
+			fputc(' ', out);
+			ir_dump_const(in, out);
+		} else {
+			for(i = 0; i < ir_op_srcs[in->op]; i++){
+				fputs(i ? ", " : " ", out);
+				ir_dump_src(ir, &in->src[i], out);
+			}
+		}
+		if(in->prev)
+			fprintf(out, " | %%%u", in->prev);
+		fputc('\n', out);
+	}
+}
@@ -0,0 +1,180 @@
+#ifndef _IR_H_
+#define _IR_H_
+
+#include <stdio.h>
+#include "common.h"
+
+/*
+ * The program between the AST and the ARB text. ARB fragment programs
+ * have no branches, so it is one straight run of instructions: an if is
+ * converted into selects (CMP) on condition masks, which are values like
+ * any other. Every instruction defines one 4-wide value, once, so the
+ * program is in SSA form. Values are numbered as they are made; the
+ * order of the program is kept apart, so passes can move, add and drop
+ * instructions without renumbering.
+ *
+ * A value is read through a swizzle, and an instruction may write only
+ * some components of its value (its write mask). The components it
+ * doesn't write are those of its prev value, whose register it takes
+ * over.
+ *
+ * A value may have to live in a given register, its home: a pre-defined
+ * variable's binding, a declared variable or a PARAM. Values without a
+ * home are put in temporaries by the ARB emitter. A value in a home must
+ * be read for the last time by the time the next value in that home is
+ * defined, as they share the register; ir_verify() checks this.
+ */
+typedef unsigned int ir_value_t;
+
+#define IR_NONE 0
+
+enum ir_op {
+	/* Values no instruction computes */
+	IR_CONST,	/* a literal, declared PARAM home = literal if it has a home */
+	IR_INPUT,	/* what its home holds when the program starts */
+	IR_PARAM,	/* PARAM home = src[0], a binding of the program */
+	IR_DECL,	/* TEMP home, defining no value */
+
+	/* ARB instructions */
+	IR_ABS, IR_ADD, IR_CMP, IR_DP3, IR_LIT, IR_MOV, IR_MUL,
+	IR_POW, IR_RCP, IR_RSQ, IR_SGE, IR_SLT, IR_SUB,
+
+	NUM_IR_OPS
+};
+
+#define IR_IS_ARB(op) ((op) >= IR_ABS)
+
+/* Name and number of sources of each op, ARB opcodes in capitals */
+extern const char *ir_op_names[NUM_IR_OPS];
+extern const unsigned char ir_op_srcs[NUM_IR_OPS];
+
+enum ir_home_kind {
+	IR_HOME_INPUT,		/* fragment.*, state.*, program.*, or an undeclared name */
+	IR_HOME_OUTPUT,		/* result.*, what the program computes */
+	IR_HOME_TEMP,		/* a declared variable */
+	IR_HOME_PARAM		/* a const variable, or a constant of the emitter's */
+};
+
+struct ir_home {
+	const char *name;	/* in the ARB */
+	unsigned char kind;	/* enum ir_home_kind */
+};
+
+/* Swizzles have 2 bits a component, x first */
+#define IR_SWIZZLE(x, y, z, w)	((x) | (y) << 2 | (z) << 4 | (w) << 6)
+#define IR_IDENTITY		IR_SWIZZLE(0, 1, 2, 3)
+#define IR_REPLICATE(c)		IR_SWIZZLE(c, c, c, c)
+#define IR_COMPONENT(swizzle, i) (((swizzle) >> (2 * (i))) & 3)
+
+#define IR_MASK_ALL 0xf
+
+struct ir_src {
+	ir_value_t value;	/* IR_NONE for none */
+	unsigned char swizzle;
+};
+
+struct ir_instr {
+	unsigned char op;	/* enum ir_op */
+	unsigned char mask;	/* components written, bit 0 for x */
+	unsigned short type;	/* type_t of the value */
+	unsigned int home;	/* in the program's homes, 0 for none */
+	ir_value_t prev;	/* holds the components not written, if any */
+	union {
+		struct ir_src src[3];	/* the op's sources, IR_NONE after them */
+		float value[4];		/* of an IR_CONST, in the mask */
+	};
+	const char *note;	/* comment to go before it in the ARB, or NULL */
+};
+
+struct ir_program {
+	struct ir_instr *instrs;	/* by value, 0 is none */
+	unsigned int num_instrs;
+	unsigned int max_instrs;
+
+	ir_value_t *order;		/* the program */
+	unsigned int num_order;
+	unsigned int max_order;
+
+	struct ir_home *homes;		/* 0 is none */
+	unsigned int num_homes;
+	unsigned int max_homes;
+};
+
+#define IR_INSTR(ir, v)	(&(ir)->instrs[v])
+#define IR_HOME(ir, h)	(&(ir)->homes[h])
+
+/* Start an empty program, or empty one out keeping its arrays */
+void ir_reset(struct ir_program *ir);
+void ir_free(struct ir_program *ir);
+
+/* A new home for the register named */
+unsigned int ir_add_home(struct ir_program *ir, const char *name, enum ir_home_kind kind);
+
+/*
+ * Add an instruction at the end of the program, returning its value. It
+ * writes every component and has no sources, prev or note; set them
+ * through IR_INSTR().
+ */
+ir_value_t ir_add(struct ir_program *ir, enum ir_op op, type_t type, unsigned int home);
+
+/* The same, for an instruction a pass places in the order itself */
+ir_value_t ir_new(struct ir_program *ir, enum ir_op op, type_t type, unsigned int home);
+
+/* The components of its i'th source an instruction reads */
+int ir_src_mask(const struct ir_instr *in, int i);
+
+/*
+ * Where each value is read last: an array by value of the position in
+ * the order after that of the last instruction reading it (as a source
+ * or as prev), 0 for a value never read. Free it with free().
+ */
+unsigned int *ir_last_uses(const struct ir_program *ir);
+
+/*
+ * Check that the program is well formed: sources are defined before
+ * they are read, ops have their sources, prev and homes are used as
+ * described above. Problems are reported to the session's error file;
+ * returns how many there are. Missing sources are only allowed after
+ * errors, as the code of a wrong call has them.
+ */
+int ir_verify(compile_session_t *cs, const struct ir_program *ir);
+
+/* Write the program out as text, one instruction a line (-Dx) */
+void ir_dump(const struct ir_program *ir, FILE *out);
+
+/*
+ * Passes over a program, in iropt.c
+ */
+
+/*
+ * Work out the instructions whose sources are all constants, as the
+ * machine would, making them constants. A CMP on a constant mask that
+ * takes the same source in every component becomes a MOV of it.
+ */
+void ir_fold_constants(struct ir_program *ir);
+
+/*
+ * Have the instruction computing a value copied into a variable write
+ * the variable itself, when the copy is all that reads it and the
+ * variable's register is free from there on, and read copies that
+ * needn't be made from what they copy, dropping them.
+ */
+void ir_forward_copies(struct ir_program *ir);
+
+/*
+ * Take out the instructions that don't contribute to what the program
+ * leaves in its result registers, and the declarations of registers
+ * none of those left use.
+ */
+void ir_eliminate_dead_code(struct ir_program *ir);
+
+/*
+ * Put the constants the instructions read, but for those with a home of
+ * their own, into PARAM vectors c0, c1, ... at the start of the program,
+ * sharing components between reads, and read them through swizzles.
+ * Names the program already has are skipped; the new ones are kept in
+ * the session's arena.
+ */
+void ir_pool_constants(compile_session_t *cs, struct ir_program *ir);
+
+#endif /* _IR_H_ */
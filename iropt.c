@@ -0,0 +1,804 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "common.h"
+#include "session.h"
+#include "arena.h"
+#include "ir.h"
+
+/* Replace the program's order with the num values at order */
+static void opt_set_order(struct ir_program *ir, ir_value_t *order, unsigned int num, unsigned int max){
+	free(ir->order);
+	ir->order = order;
+	ir->num_order = num;
+	ir->max_order = max;
+}
+
+/*
+ * Constant folding
+ *
+ * Results are worked out in floats exactly as the machine does, so a
+ * folded program computes what it did before. Those that aren't finite
+ * are left to be computed, as they can't be written as literals.
+ */
+
+/* The components src reads, if it is a constant */
+static int fold_fetch(const struct ir_program *ir, const struct ir_src *src, float v[4]){
+	const struct ir_instr *in = &ir->instrs[src->value];
+	int i;
+
+	if(src->value == IR_NONE || in->op != IR_CONST)
+		return 0;
+	for(i = 0; i < 4; i++)
+		v[i] = in->value[IR_COMPONENT(src->swizzle, i)];
+	return 1;
+}
+
+static void fold_eval(enum ir_op op, float *a, float *b, float *c, float *r){
+	int i;
+
+	switch(op){
+	case IR_ABS:
+		for(i = 0; i < 4; i++) r[i] = fabsf(a[i]);
+		break;
+	case IR_ADD:
+		for(i = 0; i < 4; i++) r[i] = a[i] + b[i];
+		break;
+	case IR_CMP:
+		for(i = 0; i < 4; i++) r[i] = a[i] < 0.0f ? b[i] : c[i];
+		break;
+	case IR_DP3:
+		r[0] = r[1] = r[2] = r[3] = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+		break;
+	case IR_LIT:
+		a[0] = a[0] > 0.0f ? a[0] : 0.0f;
+		a[1] = a[1] > 0.0f ? a[1] : 0.0f;
+		a[3] = a[3] < -128.0f ? -128.0f : (a[3] > 128.0f ? 128.0f : a[3]);
+		r[0] = r[3] = 1.0f;
+		r[1] = a[0];
+		r[2] = a[0] > 0.0f ? powf(a[1], a[3]) : 0.0f;
+		break;
+	case IR_MOV:
+		for(i = 0; i < 4; i++) r[i] = a[i];
+		break;
+	case IR_MUL:
+		for(i = 0; i < 4; i++) r[i] = a[i] * b[i];
+		break;
+	case IR_POW:
+		r[0] = r[1] = r[2] = r[3] = powf(a[0], b[0]);
+		break;
+	case IR_RCP:
+		r[0] = r[1] = r[2] = r[3] = 1.0f / a[0];
+		break;
+	case IR_RSQ:
+		r[0] = r[1] = r[2] = r[3] = 1.0f / sqrtf(fabsf(a[0]));
+		break;
+	case IR_SGE:
+		for(i = 0; i < 4; i++) r[i] = a[i] >= b[i] ? 1.0f : 0.0f;
+		break;
+	case IR_SLT:
+		for(i = 0; i < 4; i++) r[i] = a[i] < b[i] ? 1.0f : 0.0f;
+		break;
+	case IR_SUB:
+		for(i = 0; i < 4; i++) r[i] = a[i] - b[i];
+		break;
+	default:
+		break;
+	}
+}
+
+/* A CMP on a constant mask taking its second or third source in every
+ * component it writes is a MOV of that source */
+static void fold_select(struct ir_program *ir, struct ir_instr *in){
+	float mask[4];
+	int i, side = 0;
+
+	if(in->op != IR_CMP || !fold_fetch(ir, &in->src[0], mask))
+		return;
+	for(i = 0; i < 4; i++){
+		if(!(in->mask & (1 << i)))
+			continue;
+		if(side && side != (mask[i] < 0.0f ? 1 : 2))
+			return;
+		side = mask[i] < 0.0f ? 1 : 2;
+	}
+
+	in->op = IR_MOV;
+	in->src[0] = in->src[side];
+	in->src[1].value = in->src[2].value = IR_NONE;
+}
+
+void ir_fold_constants(struct ir_program *ir){
+	/* The constant holding each value, where it is known */
+	ir_value_t *known = (ir_value_t *) calloc(ir->num_instrs, sizeof(ir_value_t));
+	unsigned int max = 2 * ir->num_order + 1, num = 0, p;
+	ir_value_t *order = (ir_value_t *) malloc(max * sizeof(ir_value_t));
+	float srcs[3][4], r[4];
+	struct ir_instr *in;
+	ir_value_t v, c, t;
+	int i, n, full;
+
+	for(p = 0; p < ir->num_order; p++){
+		v = ir->order[p];
+		in = IR_INSTR(ir, v);
+
+		if(in->op == IR_CONST)
+			known[v] = v;
+		if(!IR_IS_ARB(in->op)){
+			order[num++] = v;
+			continue;
+		}
+
+		n = ir_op_srcs[in->op];
+		for(i = 0; i < n; i++)
+			if(in->src[i].value != IR_NONE && known[in->src[i].value])
+				in->src[i].value = known[in->src[i].value];
+		fold_select(ir, in);
+		n = ir_op_srcs[in->op];
+
+		for(i = 0; i < n && fold_fetch(ir, &in->src[i], srcs[i]); i++)
+			;
+		if(i < n){
+			/* The components it keeps need a register to be in */
+			if(in->prev != IR_NONE && !in->home && IR_INSTR(ir, in->prev)->op == IR_CONST){
+				t = ir_new(ir, IR_MOV, (type_t) IR_INSTR(ir, v)->type, 0);
+				in = IR_INSTR(ir, v);
+				IR_INSTR(ir, t)->mask = (unsigned char) (IR_MASK_ALL & ~in->mask);
+				IR_INSTR(ir, t)->src[0].value = in->prev;
+				IR_INSTR(ir, t)->src[0].swizzle = IR_IDENTITY;
+				in->prev = t;
+				order[num++] = t;
+			}
+			order[num++] = v;
+			continue;
+		}
+
+		fold_eval((enum ir_op) in->op, srcs[0], srcs[1], srcs[2], r);
+		for(i = 0; i < 4 && (!(in->mask & (1 << i)) || isfinite(r[i])); i++)
+			;
+		if(i < 4){
+			order[num++] = v;
+			continue;
+		}
+
+		/* The components it doesn't write */
+		full = in->mask == IR_MASK_ALL || in->prev == IR_NONE || known[in->prev];
+		for(i = 0; i < 4; i++)
+			if(!(in->mask & (1 << i)))
+				r[i] = known[in->prev] ? IR_INSTR(ir, known[in->prev])->value[i] : 0.0f;
+
+		if(!in->home && full){
+			in->op = IR_CONST;
+			in->mask = IR_MASK_ALL;
+			in->prev = IR_NONE;
+			in->note = NULL;
+			memcpy(in->value, r, sizeof r);
+			known[v] = v;
+			order[num++] = v;
+			continue;
+		}
+
+		/* It has to be in its home, or to keep the rest of its prev:
+		 * make it a move of the constant, if it isn't one already */
+		if(in->op == IR_MOV && !full){
+			order[num++] = v;
+			continue;
+		}
+		if(in->op == IR_MOV && in->mask == IR_MASK_ALL && in->src[0].swizzle == IR_IDENTITY){
+			c = in->src[0].value;
+		} else {
+			c = ir_new(ir, IR_CONST, (type_t) IR_INSTR(ir, v)->type, 0);
+			in = IR_INSTR(ir, v);
+			memcpy(IR_INSTR(ir, c)->value, r, sizeof r);
+			order[num++] = c;
+			in->op = IR_MOV;
+			in->src[0].value = c;
+			in->src[0].swizzle = IR_IDENTITY;
+			in->src[1].value = in->src[2].value = IR_NONE;
+		}
+		if(full){
+			in->mask = IR_MASK_ALL;
+			in->prev = IR_NONE;
+			known[v] = c;
+		}
+		order[num++] = v;
+	}
+
+	opt_set_order(ir, order, num, max);
+	free(known);
+}
+
+/*
+ * Copy propagation and destination forwarding
+ *
+ * Code generation evaluates each expression into a temporary and copies
+ * it into the variable assigned. When nothing else reads the temporary,
+ * the instruction computing it can write the variable itself, provided
+ * the variable's register is free from that instruction on: what it
+ * holds isn't read after, and isn't replaced in between. Values a copy
+ * is read for are read where they already are instead.
+ */
+struct forward{
+	struct ir_src *alias;	/* by value: read this instead, IR_NONE if itself */
+	unsigned char *kept;	/* the copy stays, as a prev or in its register */
+	unsigned char *as_prev;	/* read as a prev */
+	unsigned int *uses;	/* reads, as sources or prev */
+	unsigned int *pos;	/* in the new order */
+	unsigned int *last_read;/* position after that of the last read so far */
+	ir_value_t *occupant;	/* by home, the last value in it so far */
+	ir_value_t *below;	/* by value, the one in its home before it */
+	ir_value_t *order;	/* the new order, IR_NONE for one taken out */
+	unsigned char *written;	/* by home, whether any instruction writes it */
+};
+
+/* Whether swizzle reads each component of mask from itself */
+static int fwd_identity(int swizzle, int mask){
+	int i;
+
+	for(i = 0; i < 4; i++)
+		if((mask & (1 << i)) && IR_COMPONENT(swizzle, i) != i)
+			return 0;
+	return 1;
+}
+
+/* Read src through the aliases of what it reads */
+static void fwd_resolve(const struct forward *fw, struct ir_src *src){
+	const struct ir_src *a;
+	int i, comps[4];
+
+	while(src->value != IR_NONE && (a = &fw->alias[src->value])->value != IR_NONE){
+		for(i = 0; i < 4; i++)
+			comps[i] = IR_COMPONENT(a->swizzle, IR_COMPONENT(src->swizzle, i));
+		src->value = a->value;
+		src->swizzle = (unsigned char) IR_SWIZZLE(comps[0], comps[1], comps[2], comps[3]);
+	}
+}
+
+static ir_value_t fwd_resolve_prev(const struct forward *fw, ir_value_t prev){
+	while(prev != IR_NONE && fw->alias[prev].value != IR_NONE && !fw->kept[prev])
+		prev = fw->alias[prev].value;
+	return prev;
+}
+
+/* Make reads of copy read value through swizzle */
+static void fwd_alias(struct forward *fw, ir_value_t copy, ir_value_t value, int swizzle){
+	fw->alias[copy].value = value;
+	fw->alias[copy].swizzle = (unsigned char) swizzle;
+	fw->uses[value] += fw->uses[copy] - 1;
+	fw->as_prev[value] |= fw->as_prev[copy];
+}
+
+/*
+ * A copy that needn't be made: a temporary's full copy of a value never
+ * overwritten, or a variable's copy of what it holds already. Copies of
+ * inputs and PARAMs into variables are read from the inputs and PARAMs,
+ * but are made all the same, for prev and what else may need them.
+ */
+static int fwd_drop_copy(const struct ir_program *ir, struct forward *fw, ir_value_t m){
+	const struct ir_instr *in = IR_INSTR(ir, m);
+	const struct ir_src *src = &in->src[0];
+	const struct ir_instr *s = IR_INSTR(ir, src->value);
+
+	if(in->op != IR_MOV || src->value == IR_NONE)
+		return 0;
+
+	if(in->home && src->value == fw->occupant[in->home] && fwd_identity(src->swizzle, in->mask)
+	   && (in->prev == IR_NONE ? in->mask == IR_MASK_ALL : in->prev == src->value)){
+		fwd_alias(fw, m, src->value, IR_IDENTITY);
+		return 1;
+	}
+
+	if(in->mask != IR_MASK_ALL || (s->home && fw->written[s->home]))
+		return 0;
+	if(!in->home && !fw->as_prev[m] && !fw->as_prev[src->value]){
+		fwd_alias(fw, m, src->value, src->swizzle);
+		return 1;
+	}
+	if(in->home && (s->op == IR_INPUT || s->op == IR_PARAM)){
+		fwd_alias(fw, m, src->value, src->swizzle);
+		fw->uses[src->value]++;
+		fw->kept[m] = 1;
+	}
+	return 0;
+}
+
+/*
+ * Have the instructions computing what MOV m copies into its home write
+ * it there instead: the one that does, or a run of temporary writes each
+ * taking over the last, as a constructor's are.
+ */
+static int fwd_forward(struct ir_program *ir, struct forward *fw, ir_value_t m){
+	struct ir_instr *in = IR_INSTR(ir, m), *tin;
+	ir_value_t t = in->src[0].value, bottom, o, undefined = IR_NONE;
+	int swizzle = in->src[0].swizzle, i, j, comps[4];
+	unsigned int home = in->home;
+
+	if(in->op != IR_MOV || !home || (IR_HOME(ir, home)->kind != IR_HOME_TEMP && IR_HOME(ir, home)->kind != IR_HOME_OUTPUT))
+		return 0;
+	tin = IR_INSTR(ir, t);
+	if(!IR_IS_ARB(tin->op) || fw->uses[t] != 1 || fw->as_prev[t] || tin->home == home)
+		return 0;
+	if(tin->home && (tin->prev != IR_NONE || IR_HOME(ir, tin->home)->kind != IR_HOME_TEMP))
+		return 0;
+
+	/* Where the home starts being written */
+	for(bottom = t; IR_INSTR(ir, bottom)->prev != IR_NONE; bottom = IR_INSTR(ir, bottom)->prev){
+		if(in->mask != IR_MASK_ALL || !fwd_identity(swizzle, IR_MASK_ALL))
+			return 0;
+		o = IR_INSTR(ir, bottom)->prev;
+		if(IR_INSTR(ir, o)->home || !IR_IS_ARB(IR_INSTR(ir, o)->op) || fw->uses[o] != 1)
+			return 0;
+	}
+	if(tin->op == IR_LIT && !fwd_identity(swizzle, in->mask))
+		return 0;
+	o = fw->occupant[home];
+	if(in->prev != IR_NONE && in->prev != o)
+		return 0;
+	/* Components of a variable or result never written are undefined,
+	 * so needn't be kept */
+	if(o != IR_NONE && in->prev == o && IR_INSTR(ir, o)->op == IR_INPUT && fw->uses[o] == 1){
+		undefined = o;
+		o = fw->below[o];
+	}
+	if(o != IR_NONE && (fw->pos[o] >= fw->pos[bottom] || fw->last_read[o] > fw->pos[bottom] + 1))
+		return 0;
+
+	/* A component by component op reads what it is read for */
+	switch(tin->op){
+	case IR_ABS: case IR_ADD: case IR_CMP: case IR_MOV:
+	case IR_MUL: case IR_SGE: case IR_SLT: case IR_SUB:
+		for(j = 0; j < ir_op_srcs[tin->op]; j++){
+			for(i = 0; i < 4; i++)
+				comps[i] = IR_COMPONENT(tin->src[j].swizzle, IR_COMPONENT(swizzle, i));
+			tin->src[j].swizzle = (unsigned char) IR_SWIZZLE(comps[0], comps[1], comps[2], comps[3]);
+		}
+		break;
+	default:
+		break;
+	}
+
+	for(bottom = t; bottom != IR_NONE; bottom = IR_INSTR(ir, bottom)->prev)
+		IR_INSTR(ir, bottom)->home = home;
+	if(undefined != IR_NONE){
+		fw->order[fw->pos[undefined]] = IR_NONE;
+		in->prev = IR_NONE;
+	}
+	if(tin->prev == IR_NONE){
+		tin->mask = in->mask;
+		tin->prev = in->prev;
+		if(in->prev != IR_NONE && fw->last_read[in->prev] < fw->pos[t] + 1)
+			fw->last_read[in->prev] = fw->pos[t] + 1;
+	}
+	tin->type = in->type;
+	if(!tin->note){
+		tin->note = in->note;
+		in->note = NULL;
+	}
+
+	fw->alias[m].value = t;
+	fw->alias[m].swizzle = IR_IDENTITY;
+	fw->uses[t] = fw->uses[m];
+	fw->as_prev[t] = fw->as_prev[m];
+	fw->occupant[home] = t;
+	return 1;
+}
+
+void ir_forward_copies(struct ir_program *ir){
+	struct forward fw;
+	unsigned int num = 0, num_kept, p;
+	ir_value_t *order = (ir_value_t *) malloc((ir->num_order + 1) * sizeof(ir_value_t));
+	const char *note = NULL;
+	struct ir_instr *in;
+	ir_value_t v;
+	int i;
+
+	fw.alias = (struct ir_src *) calloc(ir->num_instrs, sizeof(struct ir_src));
+	fw.kept = (unsigned char *) calloc(ir->num_instrs, 1);
+	fw.as_prev = (unsigned char *) calloc(ir->num_instrs, 1);
+	fw.uses = (unsigned int *) calloc(ir->num_instrs, sizeof(unsigned int));
+	fw.pos = (unsigned int *) calloc(ir->num_instrs, sizeof(unsigned int));
+	fw.last_read = (unsigned int *) calloc(ir->num_instrs, sizeof(unsigned int));
+	fw.occupant = (ir_value_t *) calloc(ir->num_homes, sizeof(ir_value_t));
+	fw.below = (ir_value_t *) calloc(ir->num_instrs, sizeof(ir_value_t));
+	fw.order = order;
+	fw.written = (unsigned char *) calloc(ir->num_homes, 1);
+
+	for(p = 0; p < ir->num_order; p++){
+		in = IR_INSTR(ir, ir->order[p]);
+		if(in->op == IR_CONST)
+			continue;
+		for(i = 0; i < ir_op_srcs[in->op]; i++)
+			fw.uses[in->src[i].value]++;
+		fw.uses[in->prev]++;
+		fw.as_prev[in->prev] = 1;
+		if(IR_IS_ARB(in->op))
+			fw.written[in->home] = 1;
+	}
+
+	for(p = 0; p < ir->num_order; p++){
+		v = ir->order[p];
+		in = IR_INSTR(ir, v);
+		if(in->op != IR_CONST){
+			for(i = 0; i < ir_op_srcs[in->op]; i++)
+				fwd_resolve(&fw, &in->src[i]);
+			in->prev = fwd_resolve_prev(&fw, in->prev);
+		}
+
+		if(fwd_drop_copy(ir, &fw, v) || fwd_forward(ir, &fw, v)){
+			/* Keep the comment for what comes next */
+			if(IR_INSTR(ir, v)->note && !note)
+				note = IR_INSTR(ir, v)->note;
+			continue;
+		}
+
+		if(note && !in->note)
+			in->note = note;
+		note = NULL;
+		fw.pos[v] = num;
+		order[num++] = v;
+		if(in->op != IR_CONST){
+			for(i = 0; i < ir_op_srcs[in->op]; i++)
+				fw.last_read[in->src[i].value] = num;
+			fw.last_read[in->prev] = num;
+		}
+		if(in->home){
+			fw.below[v] = fw.occupant[in->home];
+			fw.occupant[in->home] = v;
+		}
+	}
+
+	for(p = 0, num_kept = 0; p < num; p++)
+		if(order[p] != IR_NONE)
+			order[num_kept++] = order[p];
+	opt_set_order(ir, order, num_kept, ir->num_order + 1);
+	free(fw.alias);
+	free(fw.kept);
+	free(fw.as_prev);
+	free(fw.uses);
+	free(fw.pos);
+	free(fw.last_read);
+	free(fw.occupant);
+	free(fw.below);
+	free(fw.written);
+}
+
+/*
+ * Dead code elimination
+ *
+ * What the program computes is what its result registers hold at the
+ * end. An instruction is live if that, or a live instruction, reads its
+ * value, as a source or as the prev whose components it keeps; the
+ * selects an if is converted into read the value they may keep like any
+ * other source. The rest goes: work whose results are never used,
+ * assignments overwritten before they are read, constants and PARAMs
+ * nothing reads, and declarations of registers nothing live is in.
+ */
+void ir_eliminate_dead_code(struct ir_program *ir){
+	unsigned char *live = (unsigned char *) calloc(ir->num_instrs, 1);
+	unsigned char *used = (unsigned char *) calloc(ir->num_homes, 1);
+	ir_value_t *final = (ir_value_t *) calloc(ir->num_homes, sizeof(ir_value_t));
+	const struct ir_instr *in;
+	unsigned int num = 0, p, h;
+	ir_value_t v;
+	int i;
+
+	for(p = 0; p < ir->num_order; p++){
+		in = IR_INSTR(ir, ir->order[p]);
+		if(in->home && in->op != IR_DECL)
+			final[in->home] = ir->order[p];
+	}
+	for(h = 1; h < ir->num_homes; h++)
+		if(IR_HOME(ir, h)->kind == IR_HOME_OUTPUT)
+			live[final[h]] = 1;
+
+	for(p = ir->num_order; p-- > 0;){
+		v = ir->order[p];
+		in = IR_INSTR(ir, v);
+		if(!live[v] || in->op == IR_DECL)
+			continue;
+		used[in->home] = 1;
+		if(in->op == IR_CONST)
+			continue;
+		for(i = 0; i < ir_op_srcs[in->op]; i++)
+			live[in->src[i].value] = 1;
+		live[in->prev] = 1;
+	}
+
+	for(p = 0; p < ir->num_order; p++){
+		v = ir->order[p];
+		in = IR_INSTR(ir, v);
+		if(v != IR_NONE && (in->op == IR_DECL ? used[in->home] : live[v]))
+			ir->order[num++] = v;
+	}
+	ir->num_order = num;
+
+	free(live);
+	free(used);
+	free(final);
+}
+
+/*
+ * Constant pooling
+ *
+ * A read is given a vector that already holds all the values it needs,
+ * if one of those holding any of them does; otherwise the values it
+ * lacks are added to one with room for them, the fullest first, or to a
+ * new one. Values are found through a hash of their bits, so -0.0 is
+ * kept apart from 0.0 and the program reads what it did before.
+ */
+struct pool_slot{
+	float value;
+	ir_value_t param;	/* the first vector given it, IR_NONE if the slot is empty */
+};
+
+struct pool{
+	ir_value_t *params;	/* the vectors, IR_CONSTs with a home */
+	unsigned int num, max;
+
+	struct pool_slot *slots;
+	unsigned int num_slots, num_values;
+
+	/* Vectors with 1 to 3 components free, the latest last. A vector
+	 * filling up stays behind in the stack it leaves. */
+	ir_value_t *open[4];
+	unsigned int num_open[4], max_open[4];
+
+	/* Whether the program has a register cn of its own, by n */
+	unsigned char *taken;
+	unsigned int num_taken, next_name;
+};
+
+static unsigned int pool_hash(float value){
+	unsigned char bytes[sizeof value];
+	unsigned int h = 2166136261u;
+	size_t i;
+
+	memcpy(bytes, &value, sizeof value);
+	for(i = 0; i < sizeof value; i++)
+		h = (h ^ bytes[i]) * 16777619u;
+	return h;
+}
+
+/* The slot of value, or the empty one it would go in */
+static struct pool_slot *pool_slot(struct pool *pool, float value){
+	unsigned int i = pool_hash(value) & (pool->num_slots - 1);
+
+	while(pool->slots[i].param != IR_NONE && memcmp(&pool->slots[i].value, &value, sizeof value))
+		i = (i + 1) & (pool->num_slots - 1);
+	return &pool->slots[i];
+}
+
+static void pool_grow_slots(struct pool *pool){
+	struct pool_slot *old = pool->slots;
+	unsigned int num_old = pool->num_slots, i;
+
+	pool->num_slots = num_old ? 2 * num_old : 64;
+	pool->slots = (struct pool_slot *) calloc(pool->num_slots, sizeof(struct pool_slot));
+	for(i = 0; i < num_old; i++)
+		if(old[i].param != IR_NONE)
+			*pool_slot(pool, old[i].value) = old[i];
+	free(old);
+}
+
+/* Note that param holds value, unless another vector was given it first */
+static void pool_put(struct pool *pool, float value, ir_value_t param){
+	struct pool_slot *slot;
+
+	if(2 * (pool->num_values + 1) > pool->num_slots)
+		pool_grow_slots(pool);
+	slot = pool_slot(pool, value);
+	if(slot->param == IR_NONE){
+		slot->value = value;
+		slot->param = param;
+		pool->num_values++;
+	}
+}
+
+/* The component of param holding value, -1 if none */
+static int pool_find(const struct ir_program *ir, ir_value_t param, float value){
+	const struct ir_instr *in = IR_INSTR(ir, param);
+	int i;
+
+	for(i = 0; i < 4 && (in->mask & (1 << i)); i++)
+		if(!memcmp(&in->value[i], &value, sizeof value))
+			return i;
+	return -1;
+}
+
+/* How many of the num values at values param lacks */
+static int pool_lacks(const struct ir_program *ir, ir_value_t param, const float *values, int num){
+	int i, lacks = 0;
+
+	for(i = 0; i < num; i++)
+		lacks += pool_find(ir, param, values[i]) < 0;
+	return lacks;
+}
+
+/* How many components of param are still free */
+static int pool_room(const struct ir_program *ir, ir_value_t param){
+	int i;
+
+	for(i = 0; i < 4 && (IR_INSTR(ir, param)->mask & (1 << i)); i++)
+		;
+	return 4 - i;
+}
+
+/* Whether param has room for what it lacks of the num values */
+static int pool_fits(const struct ir_program *ir, ir_value_t param, const float *values, int num){
+	return pool_lacks(ir, param, values, num) <= pool_room(ir, param);
+}
+
+static void pool_open(const struct ir_program *ir, struct pool *pool, ir_value_t param){
+	int room = pool_room(ir, param);
+
+	if(room == 0)
+		return;
+	if(pool->num_open[room] == pool->max_open[room]){
+		pool->max_open[room] = pool->max_open[room] ? 2 * pool->max_open[room] : 8;
+		pool->open[room] = (ir_value_t *) realloc(pool->open[room], pool->max_open[room] * sizeof(ir_value_t));
+	}
+	pool->open[room][pool->num_open[room]++] = param;
+}
+
+/* The latest vector with room components free, IR_NONE if none */
+static ir_value_t pool_latest(const struct ir_program *ir, struct pool *pool, int room){
+	while(pool->num_open[room] && pool_room(ir, pool->open[room][pool->num_open[room] - 1]) != room)
+		pool->num_open[room]--;
+	return pool->num_open[room] ? pool->open[room][pool->num_open[room] - 1] : IR_NONE;
+}
+
+/* The numbers n of the program's registers named cn */
+static void pool_find_taken(const struct ir_program *ir, struct pool *pool){
+	const char *name;
+	unsigned long n;
+	unsigned int h;
+	char *end;
+
+	for(h = 1; h < ir->num_homes; h++){
+		name = ir->homes[h].name;
+		if(name[0] != 'c' || name[1] < '0' || name[1] > '9' || (name[1] == '0' && name[2]))
+			continue;
+		n = strtoul(name + 1, &end, 10);
+		if(*end == '\0' && n < pool->num_taken)
+			pool->taken[n] = 1;
+	}
+}
+
+/* A new vector, named apart from the program's registers */
+static ir_value_t pool_add(compile_session_t *cs, struct ir_program *ir, struct pool *pool){
+	char name[16];
+	char *copy;
+	ir_value_t param;
+
+	while(pool->next_name < pool->num_taken && pool->taken[pool->next_name])
+		pool->next_name++;
+	sprintf(name, "c%u", pool->next_name++);
+	copy = (char *) arena_alloc(&cs->arena, strlen(name) + 1);
+	strcpy(copy, name);
+
+	param = ir_new(ir, IR_CONST, VEC4, ir_add_home(ir, copy, IR_HOME_PARAM));
+	IR_INSTR(ir, param)->mask = 0;
+	if(pool->num == pool->max){
+		pool->max = pool->max ? 2 * pool->max : 8;
+		pool->params = (ir_value_t *) realloc(pool->params, pool->max * sizeof(ir_value_t));
+	}
+	pool->params[pool->num++] = param;
+	return param;
+}
+
+/* Read src, which is a constant, from the pool instead */
+static void pool_read(compile_session_t *cs, struct ir_program *ir, struct pool *pool, struct ir_src *src, int mask){
+	const struct ir_instr *in = IR_INSTR(ir, src->value);
+	float values[4];
+	int comps[4];
+	int i, j, num = 0, first = -1, room;
+	ir_value_t param = IR_NONE, holder;
+	struct ir_instr *pin;
+
+	/* The distinct values it needs */
+	for(i = 0; i < 4; i++){
+		comps[i] = IR_COMPONENT(src->swizzle, i);
+		if(!(mask & (1 << i)))
+			continue;
+		for(j = 0; j < num && memcmp(&values[j], &in->value[comps[i]], sizeof(float)); j++)
+			;
+		if(j == num)
+			values[num++] = in->value[comps[i]];
+	}
+	if(num == 0)
+		return;
+
+	for(j = 0; j < num && param == IR_NONE; j++){
+		holder = pool_slot(pool, values[j])->param;
+		if(holder != IR_NONE && !pool_lacks(ir, holder, values, num))
+			param = holder;
+	}
+	for(j = 0; j < num && param == IR_NONE; j++){
+		holder = pool_slot(pool, values[j])->param;
+		if(holder != IR_NONE && pool_fits(ir, holder, values, num))
+			param = holder;
+	}
+	for(room = 1; room < 4 && param == IR_NONE; room++){
+		holder = pool_latest(ir, pool, room);
+		if(holder != IR_NONE && pool_fits(ir, holder, values, num))
+			param = holder;
+	}
+	if(param == IR_NONE)
+		param = pool_add(cs, ir, pool);
+
+	pin = IR_INSTR(ir, param);
+	room = pool_room(ir, param);
+	for(j = 0; j < num; j++){
+		if(pool_find(ir, param, values[j]) >= 0)
+			continue;
+		for(i = 0; pin->mask & (1 << i); i++)
+			;
+		pin->value[i] = values[j];
+		pin->mask |= 1 << i;
+		pool_put(pool, values[j], param);
+	}
+	if(pool_room(ir, param) != room)
+		pool_open(ir, pool, param);
+
+	in = IR_INSTR(ir, src->value);
+	for(i = 0; i < 4; i++){
+		if(!(mask & (1 << i)))
+			continue;
+		comps[i] = pool_find(ir, param, in->value[comps[i]]);
+		if(first < 0)
+			first = comps[i];
+	}
+	for(i = 0; i < 4; i++)
+		if(!(mask & (1 << i)))
+			comps[i] = first;
+	src->value = param;
+	src->swizzle = (unsigned char) IR_SWIZZLE(comps[0], comps[1], comps[2], comps[3]);
+}
+
+void ir_pool_constants(compile_session_t *cs, struct ir_program *ir){
+	struct pool pool;
+	struct ir_instr *in;
+	struct ir_src src;
+	ir_value_t *order;
+	unsigned int p, max;
+	int i;
+
+	/* There are no more vectors than reads, so no more names to skip */
+	memset(&pool, 0, sizeof pool);
+	pool.num_taken = ir->num_homes + 3 * ir->num_order;
+	pool.taken = (unsigned char *) calloc(pool.num_taken, 1);
+	pool_find_taken(ir, &pool);
+	pool_grow_slots(&pool);
+
+	for(p = 0; p < ir->num_order; p++){
+		in = IR_INSTR(ir, ir->order[p]);
+		if(!IR_IS_ARB(in->op))
+			continue;
+		for(i = 0; i < ir_op_srcs[in->op]; i++){
+			if(in->src[i].value == IR_NONE || IR_INSTR(ir, in->src[i].value)->op != IR_CONST
+			   || IR_INSTR(ir, in->src[i].value)->home)
+				continue;
+			/* A new vector moves the instructions */
+			src = in->src[i];
+			pool_read(cs, ir, &pool, &src, ir_src_mask(in, i));
+			in = IR_INSTR(ir, ir->order[p]);
+			in->src[i] = src;
+		}
+	}
+
+	/* The vectors go first */
+	if(pool.num){
+		max = ir->num_order + pool.num;
+		order = (ir_value_t *) malloc(max * sizeof(ir_value_t));
+		memcpy(order, pool.params, pool.num * sizeof(ir_value_t));
+		memcpy(order + pool.num, ir->order, ir->num_order * sizeof(ir_value_t));
+		opt_set_order(ir, order, max, max);
+	}
+	free(pool.params);
+	free(pool.slots);
+	for(i = 1; i < 4; i++)
+		free(pool.open[i]);
+	free(pool.taken);
+}
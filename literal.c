@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <float.h>
+#include <math.h>
+
+#include "literal.h"
+
+/* Significant digits a 64 bit integer is sure to hold */
+#define MAX_DIGITS 19
+
+/* Decimals tried before writing a float with an exponent */
+#define MAX_DECIMALS 8
+
+/* Powers of ten that are exact in a double */
+#define MAX_EXACT_POW10 22
+static const double pow10_exact[MAX_EXACT_POW10 + 1] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*
+ * The float nearest to w * 10^e10, the quick way. w below 2^53 and
+ * 10^|e10| are exact doubles, so one multiply or divide gives the double
+ * nearest to it, and rounding that to float gives the nearest float --
+ * unless the double is exactly halfway between two floats, when the true
+ * value could be on either side, or is a float subnormal. Returns 0 in
+ * those cases and when w or e10 is too big; d is the double, for range
+ * checks.
+ */
+static int fast_float(unsigned long long w, int e10, double *d, float *f){
+	unsigned long long bits;
+
+	if(w >> 53 || e10 < -MAX_EXACT_POW10 || e10 > MAX_EXACT_POW10)
+		return 0;
+
+	*d = e10 < 0 ? (double) w / pow10_exact[-e10] : (double) w * pow10_exact[e10];
+	if(*d > FLT_MAX){
+		*f = HUGE_VALF;
+		return 1;
+	}
+	if(*d != 0 && *d < FLT_MIN)
+		return 0;
+
+	/* The 29 bits of a double's mantissa a float doesn't have */
+	memcpy(&bits, d, sizeof bits);
+	if((bits & ((1ULL << 29) - 1)) == (1ULL << 28))
+		return 0;
+
+	*f = (float) *d;
+	return 1;
+}
+
+int literal_parse_float(const char *text, float *value){
+	unsigned long long w = 0;
+	int digits = 0, e10 = 0, fraction = 0, dropped = 0;
+	const char *p;
+	double num;
+
+	/* Gather the first MAX_DIGITS significant digits into w, so the
+	 * literal is w * 10^e10 plus whatever was dropped */
+	for(p = text; ; p++){
+		if(*p == '.')
+			fraction = 1;
+		else if(*p >= '0' && *p <= '9'){
+			if(digits < MAX_DIGITS){
+				w = 10 * w + (*p - '0');
+				digits += w != 0;
+				e10 -= fraction;
+			}
+			else{
+				dropped |= *p != '0';
+				e10 += !fraction;
+			}
+		}
+		else
+			break;
+	}
+
+	if(!dropped && fast_float(w, e10, &num, value))
+		return num > FLT_MAX ? LITERAL_RANGE : LITERAL_OK;
+
+	/* Long or hard to round: leave it to the C library, which reads a
+	 * '.' as the compiler never changes from the C locale */
+	errno = 0;
+	num = strtod(text, NULL);
+	if(errno == ERANGE && num == HUGE_VAL)
+		return LITERAL_HUGE;
+	if(num > FLT_MAX)
+		return LITERAL_RANGE;
+
+	*value = strtof(text, NULL);
+	return LITERAL_OK;
+}
+
+/* Write the decimal digits of v backwards from end, returning the first */
+static char *format_digits(char *end, unsigned long long v){
+	do{
+		*--end = '0' + v % 10;
+		v /= 10;
+	} while(v);
+
+	return end;
+}
+
+/* Write units / 10^decimals, with at least one digit either side of the
+ * point */
+static int format_fixed(char *buf, unsigned long long units, int decimals){
+	char digits[32];
+	char *end = digits + sizeof digits;
+	char *p = format_digits(end, units);
+	int len;
+
+	while(p > end - decimals - 1)
+		*--p = '0';
+
+	len = end - p - decimals;
+	memcpy(buf, p, len);
+	buf[len++] = '.';
+	if(decimals){
+		memcpy(buf + len, end - decimals, decimals);
+		len += decimals;
+	}
+	else
+		buf[len++] = '0';
+	buf[len] = '\0';
+	return len;
+}
+
+/* Whether units / 10^decimals converts to value */
+static int converts_to(unsigned long long units, int decimals, float value){
+	char buf[LITERAL_FLOAT_LEN];
+	double d;
+	float f;
+
+	if(fast_float(units, -decimals, &d, &f))
+		return f == value;
+	format_fixed(buf, units, decimals);
+	return strtof(buf, NULL) == value;
+}
+
+/*
+ * Write value, positive and finite, with the fewest decimals up to
+ * MAX_DECIMALS that convert back to it; 0 if none do. value times
+ * 10^decimals is exact: 24 bits times 2^decimals times 5^decimals,
+ * which fits in 19 bits.
+ */
+static int format_shortest_fixed(char *buf, float value){
+	unsigned long long nearest, other;
+	double scaled;
+	int decimals;
+
+	if(!(value < 1e7f))
+		return 0;
+
+	for(decimals = 0; decimals <= MAX_DECIMALS; decimals++){
+		scaled = value * pow10_exact[decimals];
+		nearest = (unsigned long long) floor(scaled + 0.5);
+		if(converts_to(nearest, decimals, value))
+			return format_fixed(buf, nearest, decimals);
+
+		/* Just above a power of two the floats below are closer, so
+		 * the far side may still convert back */
+		if(scaled == (double) nearest)
+			continue;
+		other = scaled < (double) nearest ? nearest - 1 : nearest + 1;
+		if(converts_to(other, decimals, value))
+			return format_fixed(buf, other, decimals);
+	}
+
+	return 0;
+}
+
+int literal_format_float(char *buf, float value){
+	int len = 0, shortest, precision;
+	char *mantissa;
+
+	if(isnan(value) || isinf(value))
+		return sprintf(buf, "%f", value);
+
+	if(signbit(value)){
+		buf[len++] = '-';
+		value = -value;
+	}
+
+	if((shortest = format_shortest_fixed(buf + len, value)) > 0)
+		return len + shortest;
+
+	/* Very small or large: the fewest significant digits, of the 9 that
+	 * always do, with an exponent */
+	for(precision = 0; ; precision++){
+		shortest = snprintf(buf + len, LITERAL_FLOAT_LEN - len, "%.*e", precision, value);
+		if(precision == 8 || strtof(buf + len, NULL) == value)
+			break;
+	}
+
+	/* Keep a point in the mantissa: 1e-07 as 1.0e-07 */
+	if(precision == 0){
+		mantissa = buf + len;
+		memmove(mantissa + 3, mantissa + 1, shortest);
+		mantissa[1] = '.';
+		mantissa[2] = '0';
+		shortest += 2;
+	}
+	return len + shortest;
+}
@@ -0,0 +1,33 @@
+#ifndef _LITERAL_H
+#define _LITERAL_H
+
+/*
+ * Conversion of float literals between source text and float values.
+ * Both directions are exact: a literal becomes the float nearest to it,
+ * and a float is written with the fewest digits that convert back to
+ * that same float.
+ */
+
+/* Results of literal_parse_float() */
+enum {
+	LITERAL_OK = 0,
+	LITERAL_HUGE,		/* beyond the range of a double */
+	LITERAL_RANGE		/* beyond the range of a float */
+};
+
+/*
+ * Convert the float literal at text, of the form digits.digits or .digits
+ * and followed by a NUL (as yytext is), to the nearest float. Doesn't
+ * depend on the locale.
+ */
+int literal_parse_float(const char *text, float *value);
+
+/*
+ * Write the shortest text for value that converts back to it exactly,
+ * with a decimal point, e.g. "0.5", "-3.0" or "1.5e-07", and a NUL.
+ * buf must hold LITERAL_FLOAT_LEN bytes. Returns the length written.
+ */
+#define LITERAL_FLOAT_LEN 32
+int literal_format_float(char *buf, float value);
+
+#endif /* _LITERAL_H */
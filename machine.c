@@ -0,0 +1,827 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * machine.c
+ *
+ * ARBfp1.0 interpreter, see machine.h.
+ *
+ * Loading resolves every name in the program (temporaries, parameters,
+ * bindings and inline constants) to a slot in one flat register file
+ * and decodes the instructions into fixed-size records of register
+ * numbers, swizzles and write masks, so that executing a fragment is a
+ * single pass over an array with no name lookups or parsing.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "machine.h"
+#include "session.h"
+#include "stats.h"
+
+#define MAX_NAME    128
+#define MAX_SRCS    3
+
+/* What a register holds, which decides how it is reset per fragment */
+typedef enum {
+  REG_TEMP,     /* TEMP: cleared for every fragment */
+  REG_CONST,    /* PARAM with a constant value, or an inline constant */
+  REG_INPUT,    /* fragment.*, program.*, state.*: set by the caller */
+  REG_OUTPUT    /* result.*: cleared for every fragment */
+} reg_kind_t;
+
+typedef enum {
+  OP_ABS, OP_ADD, OP_CMP, OP_DP3, OP_DP4, OP_DPH, OP_DST, OP_EX2, OP_FLR,
+  OP_FRC, OP_KIL, OP_LG2, OP_LIT, OP_LRP, OP_MAD, OP_MAX, OP_MIN, OP_MOV,
+  OP_MUL, OP_POW, OP_RCP, OP_RSQ, OP_SCS, OP_SGE, OP_SLT, OP_SUB, OP_XPD,
+  NUM_ARB_OPS
+} arb_op_t;
+
+static const struct {
+  const char *name;
+  int numSrcs;
+} op_info[NUM_ARB_OPS] = {
+  { "ABS", 1 }, { "ADD", 2 }, { "CMP", 3 }, { "DP3", 2 }, { "DP4", 2 },
+  { "DPH", 2 }, { "DST", 2 }, { "EX2", 1 }, { "FLR", 1 }, { "FRC", 1 },
+  { "KIL", 1 }, { "LG2", 1 }, { "LIT", 1 }, { "LRP", 3 }, { "MAD", 3 },
+  { "MAX", 2 }, { "MIN", 2 }, { "MOV", 1 }, { "MUL", 2 }, { "POW", 2 },
+  { "RCP", 1 }, { "RSQ", 1 }, { "SCS", 1 }, { "SGE", 2 }, { "SLT", 2 },
+  { "SUB", 2 }, { "XPD", 2 }
+};
+
+struct msrc {
+  int reg;
+  unsigned char swz[4];
+  float sign;
+};
+
+struct minstr {
+  arb_op_t op;
+  int sat;
+  int dst;
+  unsigned char mask;       /* bit i set: component i is written */
+  struct msrc src[MAX_SRCS];
+};
+
+struct machine {
+  compile_session_t *cs;
+
+  /* Register file */
+  float (*regs)[4];
+  reg_kind_t *kinds;
+  char **regNames;
+  int numRegs, maxRegs;
+
+  /* Names (declared and binding) to registers, open addressing */
+  char **keys;
+  int *vals;
+  int hashSize, numNames;
+
+  /* Decoded program */
+  struct minstr *code;
+  int numInstrs, maxInstrs;
+
+  /* Registers cleared before every fragment */
+  int *resets;
+  int numResets;
+};
+
+/***********************************************************************
+ * Names and registers
+ **********************************************************************/
+static unsigned hash_name(const char *s) {
+  unsigned h = 2166136261u;
+
+  while (*s)
+    h = (h ^ (unsigned char) *s++) * 16777619u;
+  return h;
+}
+
+static int find_name(machine_t *m, const char *name) {
+  unsigned i;
+
+  if (m->hashSize == 0)
+    return -1;
+  i = hash_name(name) & (m->hashSize - 1);
+  while (m->keys[i]) {
+    if (strcmp(m->keys[i], name) == 0)
+      return m->vals[i];
+    i = (i + 1) & (m->hashSize - 1);
+  }
+  return -1;
+}
+
+static void add_name(machine_t *m, const char *name, int reg) {
+  char **oldKeys = m->keys;
+  int *oldVals = m->vals;
+  int oldSize = m->hashSize, i;
+  unsigned h;
+
+  if (2 * (m->numNames + 1) > m->hashSize) {
+    m->hashSize = m->hashSize ? 2 * m->hashSize : 64;
+    m->keys = (char **) calloc(m->hashSize, sizeof(char *));
+    m->vals = (int *) calloc(m->hashSize, sizeof(int));
+    m->numNames = 0;
+    for (i = 0; i < oldSize; i++) {
+      if (oldKeys[i]) {
+        h = hash_name(oldKeys[i]) & (m->hashSize - 1);
+        while (m->keys[h])
+          h = (h + 1) & (m->hashSize - 1);
+        m->keys[h] = oldKeys[i];
+        m->vals[h] = oldVals[i];
+        m->numNames++;
+      }
+    }
+    free(oldKeys);
+    free(oldVals);
+  }
+
+  h = hash_name(name) & (m->hashSize - 1);
+  while (m->keys[h])
+    h = (h + 1) & (m->hashSize - 1);
+  m->keys[h] = strdup(name);
+  m->vals[h] = reg;
+  m->numNames++;
+}
+
+static int new_reg(machine_t *m, reg_kind_t kind, const char *name) {
+  int r;
+
+  if (m->numRegs == m->maxRegs) {
+    m->maxRegs = m->maxRegs ? 2 * m->maxRegs : 64;
+    m->regs = (float (*)[4]) realloc(m->regs, m->maxRegs * sizeof *m->regs);
+    m->kinds = (reg_kind_t *) realloc(m->kinds, m->maxRegs * sizeof *m->kinds);
+    m->regNames = (char **) realloc(m->regNames, m->maxRegs * sizeof *m->regNames);
+  }
+
+  r = m->numRegs++;
+  memset(m->regs[r], 0, sizeof m->regs[r]);
+  m->kinds[r] = kind;
+  m->regNames[r] = strdup(name);
+
+  if (kind == REG_TEMP || kind == REG_OUTPUT) {
+    m->resets = (int *) realloc(m->resets, (m->numResets + 1) * sizeof(int));
+    m->resets[m->numResets++] = r;
+  }
+  return r;
+}
+
+static int is_binding(const char *name) {
+  return strncmp(name, "fragment.", 9) == 0 || strncmp(name, "program.", 8) == 0 ||
+         strncmp(name, "state.", 6) == 0 || strncmp(name, "result.", 7) == 0;
+}
+
+/* The one spelling used for bindings that have several */
+static void canonical_binding(const char *name, char *out) {
+  size_t len = strlen(name);
+
+  if (strcmp(name, "fragment.texcoord") == 0)
+    strcpy(out, "fragment.texcoord[0]");
+  else if (len > 8 && strcmp(name + len - 8, ".primary") == 0) {
+    memcpy(out, name, len - 8);
+    out[len - 8] = '\0';
+  } else
+    strcpy(out, name);
+}
+
+/* The register of a binding, made on first use */
+static int binding_reg(machine_t *m, const char *name) {
+  char canon[MAX_NAME + 16];
+  int r;
+
+  canonical_binding(name, canon);
+  if ((r = find_name(m, canon)) < 0) {
+    r = new_reg(m, strncmp(canon, "result.", 7) == 0 ? REG_OUTPUT : REG_INPUT, canon);
+    add_name(m, canon, r);
+  }
+  return r;
+}
+
+static int const_reg(machine_t *m, const float value[4]) {
+  char name[MAX_NAME];
+  int r;
+
+  snprintf(name, sizeof name, "{%g, %g, %g, %g}", value[0], value[1], value[2], value[3]);
+  if ((r = find_name(m, name)) < 0) {
+    r = new_reg(m, REG_CONST, name);
+    memcpy(m->regs[r], value, sizeof m->regs[r]);
+    add_name(m, name, r);
+  }
+  return r;
+}
+
+float *machine_binding(machine_t *m, const char *binding) {
+  char canon[MAX_NAME + 16];
+  int r;
+
+  if (strlen(binding) >= MAX_NAME)
+    return NULL;
+  canonical_binding(binding, canon);
+  if ((r = find_name(m, canon)) < 0 || m->kinds[r] == REG_TEMP || m->kinds[r] == REG_CONST)
+    return NULL;
+  return m->regs[r];
+}
+
+/***********************************************************************
+ * Program loading
+ **********************************************************************/
+
+/* Parsing state for one statement */
+struct cursor {
+  const char *p, *end;
+};
+
+static void skip_space(struct cursor *c) {
+  while (c->p < c->end && isspace((unsigned char) *c->p))
+    c->p++;
+}
+
+static int accept(struct cursor *c, char ch) {
+  skip_space(c);
+  if (c->p < c->end && *c->p == ch) {
+    c->p++;
+    return 1;
+  }
+  return 0;
+}
+
+/* A name, binding or opcode, brackets and dots included */
+static int read_word(struct cursor *c, char *word) {
+  int n = 0;
+
+  skip_space(c);
+  while (c->p < c->end && (isalnum((unsigned char) *c->p) || strchr("_.[]", *c->p))) {
+    if (n == MAX_NAME - 1)
+      return 0;
+    word[n++] = *c->p++;
+  }
+  word[n] = '\0';
+  return n > 0;
+}
+
+static int read_number(struct cursor *c, float *value) {
+  char *end;
+
+  skip_space(c);
+  *value = strtof(c->p, &end);
+  if (end == c->p || end > c->end)
+    return 0;
+  c->p = end;
+  return 1;
+}
+
+/* A scalar or {x, y, z, w} constant; a scalar is replicated */
+static int read_constant(struct cursor *c, float value[4]) {
+  int i, n = 0;
+
+  if (accept(c, '{')) {
+    do {
+      if (n == 4 || !read_number(c, &value[n++]))
+        return 0;
+    } while (accept(c, ','));
+    if (!accept(c, '}'))
+      return 0;
+    for (i = n; i < 4; i++)
+      value[i] = (i == 3) ? 1.0f : 0.0f;
+    return 1;
+  }
+
+  if (!read_number(c, &value[0]))
+    return 0;
+  value[1] = value[2] = value[3] = value[0];
+  return 1;
+}
+
+static int component(char ch) {
+  switch (ch) {
+    case 'x': case 'r': return 0;
+    case 'y': case 'g': return 1;
+    case 'z': case 'b': return 2;
+    case 'w': case 'a': return 3;
+    default:  return -1;
+  }
+}
+
+/* If word ends in a component selector (".x", ".xyzw", ".rgba", ...), cut
+ * it off and return it, else return NULL */
+static const char *split_suffix(char *word) {
+  char *dot = strrchr(word, '.');
+  size_t len;
+  int i;
+
+  if (dot == NULL || dot == word)
+    return NULL;
+  len = strlen(dot + 1);
+  if (len < 1 || len > 4)
+    return NULL;
+  for (i = 0; i < (int) len; i++)
+    if (component(dot[1 + i]) < 0)
+      return NULL;
+  *dot = '\0';
+  return dot + 1;
+}
+
+/* The register a declared name or binding refers to */
+static int lookup_reg(machine_t *m, const char *name) {
+  if (is_binding(name))
+    return binding_reg(m, name);
+  return find_name(m, name);
+}
+
+static int load_error(machine_t *m, int stmt, const char *message, const char *what) {
+  fprintf(m->cs->errorFile, "MACHINE ERROR, STATEMENT %d: %s%s%s\n", stmt, message,
+          what ? ": " : "", what ? what : "");
+  return 1;
+}
+
+static int parse_src(machine_t *m, struct cursor *c, int stmt, struct msrc *src) {
+  char word[MAX_NAME];
+  float value[4];
+  const char *swz;
+  int i, len;
+
+  src->sign = accept(c, '-') ? -1.0f : 1.0f;
+  if (!accept(c, '+'))
+    skip_space(c);
+
+  if (c->p < c->end && (*c->p == '{' || isdigit((unsigned char) *c->p) || *c->p == '.')) {
+    if (!read_constant(c, value))
+      return load_error(m, stmt, "bad constant", NULL);
+    src->reg = const_reg(m, value);
+    for (i = 0; i < 4; i++)
+      src->swz[i] = i;
+    return 0;
+  }
+
+  if (!read_word(c, word))
+    return load_error(m, stmt, "expected an operand", NULL);
+  swz = split_suffix(word);
+  if ((src->reg = lookup_reg(m, word)) < 0)
+    return load_error(m, stmt, "undeclared name", word);
+
+  if (swz == NULL) {
+    for (i = 0; i < 4; i++)
+      src->swz[i] = i;
+  } else {
+    /* One component is replicated; a shorter list repeats its last */
+    len = strlen(swz);
+    for (i = 0; i < 4; i++)
+      src->swz[i] = component(swz[i < len ? i : len - 1]);
+  }
+  return 0;
+}
+
+static int parse_dst(machine_t *m, struct cursor *c, int stmt, struct minstr *in) {
+  char word[MAX_NAME];
+  const char *mask;
+  int prev = -1, comp;
+
+  if (!read_word(c, word))
+    return load_error(m, stmt, "expected a destination", NULL);
+  mask = split_suffix(word);
+  if ((in->dst = lookup_reg(m, word)) < 0)
+    return load_error(m, stmt, "undeclared name", word);
+  if (m->kinds[in->dst] == REG_CONST || m->kinds[in->dst] == REG_INPUT)
+    return load_error(m, stmt, "destination is read-only", word);
+
+  if (mask == NULL) {
+    in->mask = 0xf;
+    return 0;
+  }
+  in->mask = 0;
+  for (; *mask; mask++) {
+    comp = component(*mask);
+    if (comp <= prev)
+      return load_error(m, stmt, "bad write mask", NULL);
+    in->mask |= 1 << comp;
+    prev = comp;
+  }
+  return 0;
+}
+
+static int parse_instr(machine_t *m, struct cursor *c, int stmt, const char *opname) {
+  struct minstr in;
+  char name[8];
+  size_t len = strlen(opname);
+  int op, i;
+
+  memset(&in, 0, sizeof in);
+  if (len == 7 && strcmp(opname + 3, "_SAT") == 0)
+    in.sat = 1;
+  else if (len != 3)
+    return load_error(m, stmt, "unknown instruction", opname);
+  memcpy(name, opname, 3);
+  name[3] = '\0';
+
+  for (op = 0; op < NUM_ARB_OPS; op++)
+    if (strcmp(name, op_info[op].name) == 0)
+      break;
+  if (op == NUM_ARB_OPS)
+    return load_error(m, stmt, "unsupported instruction", opname);
+  in.op = (arb_op_t) op;
+
+  if (in.op == OP_KIL) {
+    in.dst = -1;
+  } else {
+    if (parse_dst(m, c, stmt, &in))
+      return 1;
+    if (!accept(c, ','))
+      return load_error(m, stmt, "expected ','", NULL);
+  }
+
+  for (i = 0; i < op_info[op].numSrcs; i++) {
+    if (i > 0 && !accept(c, ','))
+      return load_error(m, stmt, "expected ','", NULL);
+    if (parse_src(m, c, stmt, &in.src[i]))
+      return 1;
+  }
+
+  if (m->numInstrs == m->maxInstrs) {
+    m->maxInstrs = m->maxInstrs ? 2 * m->maxInstrs : 64;
+    m->code = (struct minstr *) realloc(m->code, m->maxInstrs * sizeof(struct minstr));
+  }
+  m->code[m->numInstrs++] = in;
+  return 0;
+}
+
+/* TEMP a, b, ... */
+static int parse_temp(machine_t *m, struct cursor *c, int stmt) {
+  char word[MAX_NAME];
+
+  do {
+    if (!read_word(c, word))
+      return load_error(m, stmt, "expected a name", NULL);
+    if (find_name(m, word) >= 0)
+      return load_error(m, stmt, "name declared twice", word);
+    add_name(m, word, new_reg(m, REG_TEMP, word));
+  } while (accept(c, ','));
+  return 0;
+}
+
+/* PARAM/ATTRIB/OUTPUT name = value, and ALIAS name = name */
+static int parse_decl(machine_t *m, struct cursor *c, int stmt) {
+  char word[MAX_NAME], target[MAX_NAME];
+  float value[4];
+  int r;
+
+  if (!read_word(c, word))
+    return load_error(m, stmt, "expected a name", NULL);
+  if (find_name(m, word) >= 0)
+    return load_error(m, stmt, "name declared twice", word);
+  if (!accept(c, '='))
+    return load_error(m, stmt, "expected '='", NULL);
+
+  skip_space(c);
+  if (c->p < c->end && (*c->p == '{' || *c->p == '-' || *c->p == '.' ||
+                        isdigit((unsigned char) *c->p))) {
+    if (!read_constant(c, value))
+      return load_error(m, stmt, "bad constant", NULL);
+    r = new_reg(m, REG_CONST, word);
+    memcpy(m->regs[r], value, sizeof m->regs[r]);
+  } else {
+    if (!read_word(c, target))
+      return load_error(m, stmt, "expected a binding", NULL);
+    if ((r = lookup_reg(m, target)) < 0)
+      return load_error(m, stmt, "undeclared name", target);
+  }
+
+  add_name(m, word, r);
+  return 0;
+}
+
+static int parse_statement(machine_t *m, const char *start, const char *end, int stmt) {
+  struct cursor c;
+  char word[MAX_NAME];
+
+  c.p = start;
+  c.end = end;
+  if (!read_word(&c, word))
+    return load_error(m, stmt, "expected a statement", NULL);
+
+  if (strcmp(word, "TEMP") == 0) {
+    if (parse_temp(m, &c, stmt))
+      return 1;
+  } else if (strcmp(word, "PARAM") == 0 || strcmp(word, "ATTRIB") == 0 ||
+             strcmp(word, "OUTPUT") == 0 || strcmp(word, "ALIAS") == 0) {
+    if (parse_decl(m, &c, stmt))
+      return 1;
+  } else if (strcmp(word, "OPTION") == 0) {
+    return 0;
+  } else if (parse_instr(m, &c, stmt, word))
+    return 1;
+
+  skip_space(&c);
+  if (c.p != c.end)
+    return load_error(m, stmt, "unexpected text", NULL);
+  return 0;
+}
+
+machine_t *machine_load(compile_session_t *cs, const char *text, size_t len) {
+  static const char header[] = "!!ARBfp1.0";
+  const char *p = text, *end = text + len, *stmtStart;
+  char *clean, *q;
+  machine_t *m;
+  int stmt = 0, failed = 0, ended = 0;
+
+  if (len < sizeof header - 1 || memcmp(text, header, sizeof header - 1) != 0) {
+    fprintf(cs->errorFile, "MACHINE ERROR: not an ARBfp1.0 program\n");
+    return NULL;
+  }
+  p += sizeof header - 1;
+
+  m = (machine_t *) calloc(1, sizeof *m);
+  m->cs = cs;
+
+  /* Drop the comments, then take the program a statement at a time */
+  clean = (char *) malloc(end - p + 1);
+  for (q = clean; p < end; ) {
+    if (*p == '#') {
+      while (p < end && *p != '\n')
+        p++;
+    } else
+      *q++ = *p++;
+  }
+  *q = '\0';
+
+  for (p = clean; !failed && !ended; p++) {
+    stmtStart = p;
+    while (*p && *p != ';')
+      p++;
+    stmt++;
+
+    /* END finishes the program; it has no ';' */
+    while (isspace((unsigned char) *stmtStart))
+      stmtStart++;
+    if (strncmp(stmtStart, "END", 3) == 0 &&
+        (stmtStart[3] == '\0' || isspace((unsigned char) stmtStart[3]))) {
+      ended = 1;
+      break;
+    }
+    if (*p == '\0') {
+      if (stmtStart != p)
+        failed = load_error(m, stmt, "missing ';'", NULL);
+      break;
+    }
+    failed = parse_statement(m, stmtStart, p, stmt);
+  }
+  free(clean);
+
+  if (!failed && !ended)
+    failed = load_error(m, stmt, "missing END", NULL);
+  if (failed) {
+    machine_free(m);
+    return NULL;
+  }
+  return m;
+}
+
+void machine_free(machine_t *m) {
+  int i;
+
+  if (m == NULL)
+    return;
+  for (i = 0; i < m->hashSize; i++)
+    free(m->keys[i]);
+  for (i = 0; i < m->numRegs; i++)
+    free(m->regNames[i]);
+  free(m->keys);
+  free(m->vals);
+  free(m->regs);
+  free(m->kinds);
+  free(m->regNames);
+  free(m->code);
+  free(m->resets);
+  free(m);
+}
+
+/***********************************************************************
+ * Execution
+ **********************************************************************/
+static inline void fetch(float (*regs)[4], const struct msrc *src, float *v) {
+  const float *r = regs[src->reg];
+
+  v[0] = src->sign * r[src->swz[0]];
+  v[1] = src->sign * r[src->swz[1]];
+  v[2] = src->sign * r[src->swz[2]];
+  v[3] = src->sign * r[src->swz[3]];
+}
+
+static inline float clamp01(float x) {
+  return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+}
+
+static int execute(machine_t *m, FILE *trace) {
+  float (*regs)[4] = m->regs;
+  const struct minstr *in, *end = m->code + m->numInstrs;
+  float a[4], b[4], c[4], r[4], t;
+  float *d;
+  int i;
+
+  for (i = 0; i < m->numResets; i++)
+    memset(regs[m->resets[i]], 0, sizeof regs[0]);
+
+  for (in = m->code; in < end; in++) {
+    fetch(regs, &in->src[0], a);
+    if (op_info[in->op].numSrcs > 1)
+      fetch(regs, &in->src[1], b);
+    if (op_info[in->op].numSrcs > 2)
+      fetch(regs, &in->src[2], c);
+
+    switch (in->op) {
+      case OP_ABS:
+        for (i = 0; i < 4; i++) r[i] = fabsf(a[i]);
+        break;
+      case OP_ADD:
+        for (i = 0; i < 4; i++) r[i] = a[i] + b[i];
+        break;
+      case OP_CMP:
+        for (i = 0; i < 4; i++) r[i] = a[i] < 0.0f ? b[i] : c[i];
+        break;
+      case OP_DP3:
+        r[0] = r[1] = r[2] = r[3] = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+        break;
+      case OP_DP4:
+        r[0] = r[1] = r[2] = r[3] = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+        break;
+      case OP_DPH:
+        r[0] = r[1] = r[2] = r[3] = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + b[3];
+        break;
+      case OP_DST:
+        r[0] = 1.0f;
+        r[1] = a[1] * b[1];
+        r[2] = a[2];
+        r[3] = b[3];
+        break;
+      case OP_EX2:
+        r[0] = r[1] = r[2] = r[3] = exp2f(a[0]);
+        break;
+      case OP_FLR:
+        for (i = 0; i < 4; i++) r[i] = floorf(a[i]);
+        break;
+      case OP_FRC:
+        for (i = 0; i < 4; i++) r[i] = a[i] - floorf(a[i]);
+        break;
+      case OP_KIL:
+        if (a[0] < 0.0f || a[1] < 0.0f || a[2] < 0.0f || a[3] < 0.0f) {
+          if (trace)
+            fprintf(trace, "  KIL\n");
+          return 1;
+        }
+        continue;
+      case OP_LG2:
+        r[0] = r[1] = r[2] = r[3] = log2f(a[0]);
+        break;
+      case OP_LIT:
+        a[0] = a[0] > 0.0f ? a[0] : 0.0f;
+        a[1] = a[1] > 0.0f ? a[1] : 0.0f;
+        a[3] = a[3] < -128.0f ? -128.0f : (a[3] > 128.0f ? 128.0f : a[3]);
+        r[0] = r[3] = 1.0f;
+        r[1] = a[0];
+        r[2] = a[0] > 0.0f ? powf(a[1], a[3]) : 0.0f;
+        break;
+      case OP_LRP:
+        for (i = 0; i < 4; i++) r[i] = a[i] * b[i] + (1.0f - a[i]) * c[i];
+        break;
+      case OP_MAD:
+        for (i = 0; i < 4; i++) r[i] = a[i] * b[i] + c[i];
+        break;
+      case OP_MAX:
+        for (i = 0; i < 4; i++) r[i] = a[i] > b[i] ? a[i] : b[i];
+        break;
+      case OP_MIN:
+        for (i = 0; i < 4; i++) r[i] = a[i] < b[i] ? a[i] : b[i];
+        break;
+      case OP_MOV:
+        for (i = 0; i < 4; i++) r[i] = a[i];
+        break;
+      case OP_MUL:
+        for (i = 0; i < 4; i++) r[i] = a[i] * b[i];
+        break;
+      case OP_POW:
+        r[0] = r[1] = r[2] = r[3] = powf(a[0], b[0]);
+        break;
+      case OP_RCP:
+        r[0] = r[1] = r[2] = r[3] = 1.0f / a[0];
+        break;
+      case OP_RSQ:
+        r[0] = r[1] = r[2] = r[3] = 1.0f / sqrtf(fabsf(a[0]));
+        break;
+      case OP_SCS:
+        r[0] = cosf(a[0]);
+        r[1] = sinf(a[0]);
+        r[2] = r[3] = 0.0f;
+        break;
+      case OP_SGE:
+        for (i = 0; i < 4; i++) r[i] = a[i] >= b[i] ? 1.0f : 0.0f;
+        break;
+      case OP_SLT:
+        for (i = 0; i < 4; i++) r[i] = a[i] < b[i] ? 1.0f : 0.0f;
+        break;
+      case OP_SUB:
+        for (i = 0; i < 4; i++) r[i] = a[i] - b[i];
+        break;
+      case OP_XPD:
+        r[0] = a[1] * b[2] - a[2] * b[1];
+        r[1] = a[2] * b[0] - a[0] * b[2];
+        r[2] = a[0] * b[1] - a[1] * b[0];
+        r[3] = 0.0f;
+        break;
+      default:
+        continue;
+    }
+
+    d = regs[in->dst];
+    for (i = 0; i < 4; i++) {
+      if (in->mask & (1 << i)) {
+        t = r[i];
+        d[i] = in->sat ? clamp01(t) : t;
+      }
+    }
+
+    if (trace)
+      fprintf(trace, "  %s%s\t%s = (%g, %g, %g, %g)\n", op_info[in->op].name,
+              in->sat ? "_SAT" : "", m->regNames[in->dst], d[0], d[1], d[2], d[3]);
+  }
+  return 0;
+}
+
+int machine_execute(machine_t *m) {
+  return execute(m, NULL);
+}
+
+/* Print the outputs of the fragment just run */
+static void print_outputs(compile_session_t *cs, machine_t *m, long fragment, int killed) {
+  int i;
+
+  fprintf(cs->outputFile, "fragment %ld:", fragment);
+  if (killed) {
+    fprintf(cs->outputFile, " killed\n");
+    return;
+  }
+  for (i = 0; i < m->numRegs; i++) {
+    if (m->kinds[i] == REG_OUTPUT)
+      fprintf(cs->outputFile, " %s %g %g %g %g", m->regNames[i],
+              m->regs[i][0], m->regs[i][1], m->regs[i][2], m->regs[i][3]);
+  }
+  fprintf(cs->outputFile, "\n");
+}
+
+long machine_run(compile_session_t *cs, machine_t *m) {
+  char line[MAX_TEXT], name[MAX_TEXT];
+  float value[4], *reg;
+  double start, secs = 0.0;
+  long fragments = 0;
+  int lineno = 0, pending = FALSE, n, i, killed;
+  char *p, *comment;
+
+  for (;;) {
+    p = fgets(line, sizeof line, cs->runInputFile);
+    if (p) {
+      lineno++;
+      if ((comment = strchr(line, '#')) != NULL)
+        *comment = '\0';
+      n = sscanf(line, "%255s %f %f %f %f", name, &value[0], &value[1], &value[2], &value[3]);
+      if (n >= 2) {
+        if (n == 2)
+          value[1] = value[2] = value[3] = value[0];
+        for (i = n - 1; i < 4 && n > 2; i++)
+          value[i] = 0.0f;
+        if ((reg = machine_binding(m, name)) != NULL)
+          memcpy(reg, value, sizeof value);
+        else if (cs->traceExecution)
+          fprintf(cs->traceFile, "run input line %d: %s is not used by the program\n", lineno, name);
+        pending = TRUE;
+        continue;
+      }
+      if (n == 1) {
+        fprintf(cs->errorFile, "RUN INPUT ERROR, LINE %d: expected values for %s\n", lineno, name);
+        continue;
+      }
+      if (strspn(line, " \t\r\n") != strlen(line))
+        continue;
+    }
+
+    /* A blank line or the end of the input finishes a fragment */
+    if (pending) {
+      fragments++;
+      if (cs->traceExecution)
+        fprintf(cs->traceFile, "fragment %ld:\n", fragments);
+      start = cs->traceStats ? stats_now() : 0.0;
+      killed = execute(m, cs->traceExecution ? cs->traceFile : NULL);
+      if (cs->traceStats)
+        secs += stats_now() - start;
+      print_outputs(cs, m, fragments, killed);
+      pending = FALSE;
+    }
+    if (p == NULL)
+      break;
+  }
+
+  if (cs->traceStats)
+    fprintf(cs->traceFile, "Execution: %ld fragments, %d instructions, %.3f ms (%.0f fragments/s)\n",
+            fragments, m->numInstrs, secs * 1e3, secs > 0 ? fragments / secs : 0.0);
+  return fragments;
+}
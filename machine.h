@@ -0,0 +1,65 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * machine.h
+ *
+ * The machine interpreter: loads an ARBfp1.0 program, as produced by
+ * genCode(), and runs it over a stream of fragments.
+ *
+ * The run input holds one record per fragment, separated by blank
+ * lines. Each line of a record sets a binding:
+ *
+ *   fragment.color 1 0 0 1
+ *   program.env[1] 0 0.7 0.7 0
+ *   state.light[0].half 0 0 1 0
+ *
+ * A single value is replicated to all four components; otherwise the
+ * missing components are 0. Values persist from one record to the next,
+ * so uniforms only need to be given once. # starts a comment. For every
+ * fragment the outputs the program writes are printed, e.g.
+ *
+ *   fragment 1: result.color 1 0.5 0 1
+ **********************************************************************/
+
+#ifndef _MACHINE_H_
+#define _MACHINE_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "common.h"
+
+typedef struct machine machine_t;
+
+/*
+ * Load the len bytes of ARB program text at text. Errors are reported
+ * to the session's error file; returns NULL if the program can't be
+ * loaded.
+ */
+machine_t *machine_load(compile_session_t *cs, const char *text, size_t len);
+
+void machine_free(machine_t *m);
+
+/*
+ * The register of the binding named (e.g. "fragment.color",
+ * "program.env[1]" or "result.color"), four floats to set before
+ * machine_execute() or read after it. NULL if the program doesn't use
+ * the binding.
+ */
+float *machine_binding(machine_t *m, const char *binding);
+
+/*
+ * Run the program once over the current bindings. Returns nonzero if
+ * the fragment was killed (KIL).
+ */
+int machine_execute(machine_t *m);
+
+/*
+ * Run the program over every fragment in the session's run input file,
+ * printing the outputs to its output file. With -Tx every instruction
+ * is traced; with -Ts the execution time and rate are reported. Returns
+ * the number of fragments run.
+ */
+long machine_run(compile_session_t *cs, machine_t *m);
+
+#endif /* _MACHINE_H_ */
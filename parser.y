@@ -22,13 +22,15 @@
 #include "ast.h"
 #include "symbol.h"
 #include "semantic.h"
+#include "session.h"
 
 #define YYERROR_VERBOSE
-#define yTRACE(x)    { if (traceParser) fprintf(traceFile, "%s\n", x); }
+/* The parser's stack is on the heap and grows as the source nests;
+ * don't stop it at bison's default of 10000 */
+#define YYMAXDEPTH 100000000
+#define yTRACE(x)    { if (cs->traceParser) fprintf(cs->traceFile, "%s\n", x); }
 
-void yyerror(const char* s);    /* what to do in case of error            */
-int yylex();              /* procedure for calling lexical analyzer */
-extern int yyline;        /* variable holding current line number   */
+void yyerror(compile_session_t *cs, const char* s); /* what to do in case of error            */
 
 %}
 
@@ -52,17 +54,29 @@ extern int yyline;        /* variable holding current line number   */
 #define YYDEBUG 1
 %}
 
+// the compile session is threaded through the parser and the scanner, and
+// the parser keeps no other state outside yyparse(), so any number of
+// sessions can be parsed at once
+%define api.pure full
+%parse-param { compile_session_t *cs }
+%lex-param   { compile_session_t *cs }
+
 // defines the yyval union
 %union {
   int as_int;
   int as_vec;
   float as_float;
-  char *as_str;
+  ident_t as_id;
   int as_func;
-  node *as_ast;
+  node_t as_ast;
   type_t as_type;
 }
 
+%code provides {
+/* procedure for calling lexical analyzer */
+int yylex(YYSTYPE *lvalp, compile_session_t *cs);
+}
+
 %token          FLOAT_T
 %token 		INT_T
 %token          BOOL_T
@@ -77,7 +91,7 @@ extern int yyline;        /* variable holding current line number   */
 %token <as_vec>   IVEC_T
 %token <as_float> FLOAT_C
 %token <as_int>   INT_C
-%token <as_str>   ID
+%token <as_id>    ID
 %token <as_func>  FUNC
 
 // operator precdence
@@ -96,14 +110,14 @@ extern int yyline;        /* variable holding current line number   */
 
 // type declarations
 // TODO: fill this out
-%type <as_ast> arguments_opt
-%type <as_ast> arguments
+%type <as_int> arguments_opt
+%type <as_int> arguments
 %type <as_ast> expression
 %type <as_type> type
 %type <as_ast> variable
-%type <as_ast> declarations
+%type <as_int> declarations
 %type <as_ast> declaration
-%type <as_ast> statements
+%type <as_int> statements
 %type <as_ast> statement
 %type <as_ast> scope
 
@@ -126,63 +140,45 @@ program
   : scope 
       	{
 		yTRACE("program -> scope\n");
-		ast = $1;
-		semantic_check(ast);
+		cs->ast.root = $1;
 	} 
   ;
 
 scope
   : '{' {
 		/* Adjust symbol table */
-		st_curr = st_new();
-		if(st_curr == NULL){
-			printf("Error: couldn't create new symbol table for scope.\n");
+		cs->st_curr = st_new(cs);
+		if(cs->st_curr == NULL){
+			fprintf(cs->errorFile, "Error: couldn't create new symbol table for scope.\n");
 			/* TODO: Deal with this properly? */
 		}
 
-		/* add pre-defined varialbes to symbol table. */
-		if(st_curr->parent == NULL){ //this makes sure it's only in the initial scope that the variables are inserted
-			//result class variables
-			st_insert("gl_FragColor", VEC4, FALSE);
-			st_insert("gl_FragDepth", BOOL, FALSE);
-			st_insert("gl_FragCoord", VEC4, FALSE);
-
-			//attribute class variables
-			st_insert("gl_TexCoord", VEC4, FALSE);
-			st_insert("gl_Color", VEC4, FALSE);
-			st_insert("gl_Secondary", VEC4, FALSE);
-			st_insert("gl_FogFragCoord", VEC4, FALSE);
-
-			//uniform class variables
-			st_insert("gl_Light_Half", VEC4, TRUE);
-			st_insert("gl_Light_Ambient", VEC4, TRUE);
-			st_insert("gl_Material_Shininess", VEC4, TRUE);
-			st_insert("env1", VEC4, TRUE);
-			st_insert("env2", VEC4, TRUE);
-			st_insert("env3", VEC4, TRUE);			
-		}
+		/* The pre-defined variables are searched after the outermost
+		 * scope, whose parent is NULL. */
 	} 
 	declarations statements '}'
       	{
 		yTRACE("scope -> { declarations statements }\n");
-		$$ = ast_allocate(SCOPE_NODE, $3, $4);
+		$$ = ast_allocate(cs, SCOPE_NODE, $3, $4);
 		
 		/* Adjust symbol table */
-		if(st_curr->parent)
-			st_curr = st_curr->parent;
+		cs->st_curr = cs->st_curr->parent;
 	}
   ;
 
+// lists are built on the AST's pending stack, from the mark taken where
+// they start, and moved into place by the node that takes them
 declarations
   : declarations declaration
       	{
 		yTRACE("declarations -> declarations declaration\n");
-		$$ = ast_allocate(DECLARATIONS_NODE, $1, $2);
+		$$ = $1;
+		ast_push(cs, $2);
 	}
   | 
       	{ 
 		yTRACE("declarations -> \n");
-		$$ = NULL;
+		$$ = ast_mark(cs);
 	}
   ;
 
@@ -190,12 +186,15 @@ statements
   : statements statement
       	{ 	
 		yTRACE("statements -> statements statement\n");
-		$$ = ast_allocate(STATEMENTS_NODE, $1, $2);
+		$$ = $1;
+		/* An empty statement ';' leaves nothing to keep */
+		if($2 != AST_NIL)
+			ast_push(cs, $2);
 	}
   | 
       	{ 
 		yTRACE("statements -> \n");
-		$$ = NULL; 
+		$$ = ast_mark(cs);
 	}
   ;
 
@@ -203,20 +202,17 @@ declaration
   : type ID ';' 
       	{
 		yTRACE("declaration -> type ID ;\n");
-		$$ = ast_allocate(DECLARATION_NODE, $2, NULL);
-		st_insert($2, $1, FALSE);
+		$$ = ast_allocate(cs, DECLARATION_NODE, st_insert(cs, $2, $1, FALSE), AST_NIL);
 	}
   | type ID '=' expression ';'
       	{ 
 		yTRACE("declaration -> type ID = expression ;\n");
-		$$ = ast_allocate(DECLARATION_NODE, $2, $4);
-		st_insert($2, $1, FALSE);
+		$$ = ast_allocate(cs, DECLARATION_NODE, st_insert(cs, $2, $1, FALSE), $4);
 	}
   | CONST type ID '=' expression ';'
       	{ 	
 		yTRACE("declaration -> CONST type ID = expression ;\n");
-		$$ = ast_allocate(DECLARATION_NODE, $3, $5);
-		st_insert($3, $2, TRUE);
+		$$ = ast_allocate(cs, DECLARATION_NODE, st_insert(cs, $3, $2, TRUE), $5);
 	}
   ;
 
@@ -224,17 +220,17 @@ statement
   : variable '=' expression ';'
       	{ 
 		yTRACE("statement -> variable = expression ;\n");
-		$$ = ast_allocate(ASSIGNMENT_NODE, $1, $3);
+		$$ = ast_allocate(cs, ASSIGNMENT_NODE, $1, $3);
 	}
   | IF '(' expression ')' statement ELSE statement %prec WITH_ELSE
       	{ 	
 		yTRACE("statement -> IF ( expression ) statement ELSE statement \n");
-		$$ = ast_allocate(IF_STATEMENT_NODE, $3, $5, $7);
+		$$ = ast_allocate(cs, IF_STATEMENT_NODE, $3, $5, $7);
 	}
   | IF '(' expression ')' statement %prec WITHOUT_ELSE
       	{ 
 		yTRACE("statement -> IF ( expression ) statement \n");
-		$$ = ast_allocate(IF_STATEMENT_NODE, $3, $5, NULL);
+		$$ = ast_allocate(cs, IF_STATEMENT_NODE, $3, $5, AST_NIL);
 	}
   | scope 
       	{ 
@@ -244,7 +240,7 @@ statement
   | ';'
       	{ 
 		yTRACE("statement -> ; \n");
-		$$ = NULL;
+		$$ = AST_NIL;
 	}
   ;
 
@@ -329,113 +325,113 @@ expression
   : type '(' arguments_opt ')' %prec '('
       	{ 
 		yTRACE("expression -> type ( arguments_opt ) \n");
-		$$ = ast_allocate(CONSTRUCTOR_NODE, $1, $3);
+		$$ = ast_allocate(cs, CONSTRUCTOR_NODE, $1, $3);
 	}
   | FUNC '(' arguments_opt ')' %prec '('
       	{ 
 		yTRACE("expression -> FUNC ( arguments_opt ) \n");
-		$$ = ast_allocate(FUNCTION_NODE, $1, $3);
+		$$ = ast_allocate(cs, FUNCTION_NODE, $1, $3);
 	}
 
   /* unary opterators */
   | '-' expression %prec UMINUS
       	{ 
 		yTRACE("expression -> - expression \n");
-		$$ = ast_allocate(UNARY_EXPRESSION_NODE, '-', $2);
+		$$ = ast_allocate(cs, UNARY_EXPRESSION_NODE, '-', $2);
 	}
   | '!' expression %prec '!'
       	{ 
 		yTRACE("expression -> ! expression \n") 
-		$$ = ast_allocate(UNARY_EXPRESSION_NODE, '!', $2);
+		$$ = ast_allocate(cs, UNARY_EXPRESSION_NODE, '!', $2);
 	}
 
   /* binary operators */
   | expression AND expression %prec AND
       	{ 
 		yTRACE("expression -> expression AND expression \n");
-		$$ = ast_allocate(BINARY_EXPRESSION_NODE, _AND, $1, $3);
+		$$ = ast_allocate(cs, BINARY_EXPRESSION_NODE, _AND, $1, $3);
 	}
   | expression OR expression %prec OR
       	{ 
 		yTRACE("expression -> expression OR expression \n");
-		$$ = ast_allocate(BINARY_EXPRESSION_NODE, _OR, $1, $3);
+		$$ = ast_allocate(cs, BINARY_EXPRESSION_NODE, _OR, $1, $3);
 	}
   | expression EQ expression %prec EQ
       	{ 
 		yTRACE("expression -> expression EQ expression \n");
-		$$ = ast_allocate(BINARY_EXPRESSION_NODE, _EQ, $1, $3);
+		$$ = ast_allocate(cs, BINARY_EXPRESSION_NODE, _EQ, $1, $3);
 	}
   | expression NEQ expression %prec NEQ
       	{ 
 		yTRACE("expression -> expression NEQ expression \n");
-		$$ = ast_allocate(BINARY_EXPRESSION_NODE, _NEQ, $1, $3);
+		$$ = ast_allocate(cs, BINARY_EXPRESSION_NODE, _NEQ, $1, $3);
 	}
   | expression '<' expression %prec '<'
       	{ 
 		yTRACE("expression -> expression < expression \n");
-		$$ = ast_allocate(BINARY_EXPRESSION_NODE, '<', $1, $3);
+		$$ = ast_allocate(cs, BINARY_EXPRESSION_NODE, '<', $1, $3);
 	}
   | expression LEQ expression %prec LEQ
       	{ 
 		yTRACE("expression -> expression LEQ expression \n");
-		$$ = ast_allocate(BINARY_EXPRESSION_NODE, _LEQ, $1, $3);
+		$$ = ast_allocate(cs, BINARY_EXPRESSION_NODE, _LEQ, $1, $3);
 	}
   | expression '>' expression %prec '>'
       	{ 
 		yTRACE("expression -> expression > expression \n");
-		$$ = ast_allocate(BINARY_EXPRESSION_NODE, '>', $1, $3);
+		$$ = ast_allocate(cs, BINARY_EXPRESSION_NODE, '>', $1, $3);
 	}
   | expression GEQ expression %prec GEQ
       	{ 
 		yTRACE("expression -> expression GEQ expression \n");
-		$$ = ast_allocate(BINARY_EXPRESSION_NODE, _GEQ, $1, $3);
+		$$ = ast_allocate(cs, BINARY_EXPRESSION_NODE, _GEQ, $1, $3);
 	}
   | expression '+' expression %prec '+'
       	{ 
 		yTRACE("expression -> expression + expression \n");
-		$$ = ast_allocate(BINARY_EXPRESSION_NODE, '+', $1, $3);
+		$$ = ast_allocate(cs, BINARY_EXPRESSION_NODE, '+', $1, $3);
 	}
   | expression '-' expression %prec '-'
       	{ 
 		yTRACE("expression -> expression - expression \n");
-		$$ = ast_allocate(BINARY_EXPRESSION_NODE, '-', $1, $3);
+		$$ = ast_allocate(cs, BINARY_EXPRESSION_NODE, '-', $1, $3);
 	}
   | expression '*' expression %prec '*'
       	{ 
 		yTRACE("expression -> expression * expression \n"); 
-		$$ = ast_allocate(BINARY_EXPRESSION_NODE, '*', $1, $3);
+		$$ = ast_allocate(cs, BINARY_EXPRESSION_NODE, '*', $1, $3);
 	}
   | expression '/' expression %prec '/'
       	{ 
 		yTRACE("expression -> expression / expression \n");
-		$$ = ast_allocate(BINARY_EXPRESSION_NODE, '/', $1, $3);
+		$$ = ast_allocate(cs, BINARY_EXPRESSION_NODE, '/', $1, $3);
 	}
   | expression '^' expression %prec '^'
       	{ 
 		yTRACE("expression -> expression ^ expression \n"); 
-		$$ = ast_allocate(BINARY_EXPRESSION_NODE, '^', $1, $3);
+		$$ = ast_allocate(cs, BINARY_EXPRESSION_NODE, '^', $1, $3);
 	}
 
   /* literals */
   | TRUE_C
       	{ 
 		yTRACE("expression -> TRUE_C \n");
-		$$ = ast_allocate(BOOL_NODE, TRUE);
+		$$ = ast_allocate(cs, BOOL_NODE, TRUE);
 	}
   | FALSE_C
       	{ 
 		yTRACE("expression -> FALSE_C \n"); 
-		$$ = ast_allocate(BOOL_NODE, FALSE);
+		$$ = ast_allocate(cs, BOOL_NODE, FALSE);
 	}
   | INT_C
       	{ 
 		yTRACE("expression -> INT_C \n");
-		$$ = ast_allocate(INT_NODE, $1);
+		$$ = ast_allocate(cs, INT_NODE, $1);
 	}
   | FLOAT_C
       	{ 
 		yTRACE("expression -> FLOAT_C \n");
-		$$ = ast_allocate(FLOAT_NODE, (double) $1);
+		$$ = ast_allocate(cs, FLOAT_NODE, (double) $1);
 	}
 
   /* misc */
@@ -455,12 +451,12 @@ variable
   : ID
      	{
 		yTRACE("variable -> ID \n");
-		$$ = ast_allocate(VAR_NODE, $1, -1);
+		$$ = ast_allocate(cs, VAR_NODE, $1, -1);
 	}
   | ID '[' INT_C ']' %prec '['
       	{
 		yTRACE("variable -> ID [ INT_C ] \n");
-		$$ = ast_allocate(VAR_NODE, $1, $3);
+		$$ = ast_allocate(cs, VAR_NODE, $1, $3);
 	}
   ;
 
@@ -468,12 +464,14 @@ arguments
   : arguments ',' expression
       	{ 
 		yTRACE("arguments -> arguments , expression \n"); 
-		$$ = ast_allocate(ARGUMENTS_NODE, $1, $3);	
+		$$ = $1;
+		ast_push(cs, $3);
 	}
   | expression
       	{ 
 		yTRACE("arguments -> expression \n"); 
-		$$ = ast_allocate(ARGUMENTS_NODE, NULL, $1);	
+		$$ = ast_mark(cs);
+		ast_push(cs, $1);
 	}
   ;
 
@@ -486,7 +484,7 @@ arguments_opt
   |
       	{ 
 		yTRACE("arguments_opt -> \n");
-		$$ = NULL;
+		$$ = ast_mark(cs);
 	}
   ;
 
@@ -498,23 +496,20 @@ arguments_opt
  * The given yyerror function should not be touched. You may add helper
  * functions as necessary in subsequent phases.
  ***********************************************************************/
-void yyerror(const char* s) {
-  if(errorOccurred) {
+void yyerror(compile_session_t *cs, const char* s) {
+  if(cs->errorOccurred) {
     return;    /* Error has already been reported by scanner */
   } else {
-    errorOccurred = 1;
+    cs->errorOccurred = 1;
   }
 
-  fprintf(errorFile, "\nPARSER ERROR, LINE %d", yyline);
+  fprintf(cs->errorFile, "\nPARSER ERROR, LINE %d", cs->yyline);
   
-  if(strcmp(s, "parse error")) {
-    if(strncmp(s, "parse error, ", 13)) {
-      fprintf(errorFile, ": %s\n", s);
-    } else {
-      fprintf(errorFile, ": %s\n", s+13);
-    }
+  if(strncmp(s, "parse error, ", 13)) {
+    fprintf(cs->errorFile, ": %s\n", s);
   } else {
-    fprintf(errorFile, ": Reading token %s\n", yytname[YYTRANSLATE(yychar)]);
+    fprintf(cs->errorFile, ": %s\n", s+13);
   }
+  sourceQuote(cs, cs->yyline);
 }
 
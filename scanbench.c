@@ -0,0 +1,100 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * scanbench.c
+ *
+ * Scanner benchmark: scans each source file given, without parsing it,
+ * and reports the tokens scanned per second. It is linked once against
+ * each scanner (scanbench-flex and scanbench-hand, see the Makefile) so
+ * the two can be compared on the same sources:
+ *
+ *   scanbench-hand [-n repeats] file...
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "session.h"
+#include "stats.h"
+#include "intern.h"
+#include "parser.tab.h"
+
+extern void scanner_restart(compile_session_t *cs);
+extern void scanner_free(compile_session_t *cs);
+
+/* Scan the session's source once, returning the number of tokens or -1
+ * on a lexical error */
+static long scan(compile_session_t *cs) {
+  YYSTYPE lval;
+  long tokens = 0;
+
+  cs->yyline = 1;
+  cs->errorOccurred = FALSE;
+  scanner_restart(cs);
+  while (yylex(&lval, cs))
+    tokens++;
+  scanner_free(cs);
+  intern_reset(cs);
+  arena_release(&cs->arena);
+
+  return cs->errorOccurred ? -1 : tokens;
+}
+
+int main(int argc, char **argv) {
+  compile_session_t cs;
+  const char *name;
+  double start, elapsed;
+  long tokens = 0;
+  int repeats = 10;
+  int i, r, status = 0;
+
+  if ((name = strrchr(argv[0], '/')) != NULL)
+    name++;
+  else
+    name = argv[0];
+
+  i = 1;
+  if (i + 1 < argc && !strcmp(argv[i], "-n")) {
+    repeats = atoi(argv[i + 1]);
+    i += 2;
+  }
+  if (i >= argc || repeats < 1) {
+    fprintf(stderr, "usage: %s [-n repeats] file...\n", name);
+    return 1;
+  }
+
+  for (; i < argc; i++) {
+    session_init(&cs);
+    if ((cs.inputFile = fopen(argv[i], "r")) == NULL) {
+      fprintf(stderr, "%s: cannot open %s\n", name, argv[i]);
+      status = 1;
+      continue;
+    }
+    if (session_read_source(&cs)) {
+      fclose(cs.inputFile);
+      status = 1;
+      continue;
+    }
+
+    start = stats_now();
+    for (r = 0; r < repeats; r++)
+      if ((tokens = scan(&cs)) < 0)
+        break;
+    elapsed = stats_now() - start;
+
+    if (tokens >= 0)
+      printf("%s: %s: %ld tokens, %.3f ms/scan, %.0f tokens/s, %.1f MB/s\n",
+             name, argv[i], tokens, 1e3 * elapsed / repeats,
+             tokens * repeats / elapsed,
+             cs.sourceLen * repeats / elapsed / 1e6);
+    else
+      status = 1;
+
+    session_free_source(&cs);
+    fclose(cs.inputFile);
+  }
+
+  return status;
+}
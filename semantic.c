@@ -2,1095 +2,582 @@
 #include "ast.h"
 #include "symbol.h"
 #include "common.h"
+#include "session.h"
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
 
-// forward declare for sem_check_args
-static void sem_check_expr(node *, type_t *);
+/*
+ * The checks run as the tree is walked, each node's once its children
+ * are done. The type of each expression checked is pushed on a stack,
+ * by its index (see print_type_index()), where its parent takes it from.
+ */
+static void sem_push_type(struct ast_stack *types, int type){
+	*(int *) ast_stack_push(types, sizeof type) = type;
+}
 
-static void sem_check_args(node *ast, int *arg_count, type_t *type1, type_t *type2, type_t *type3, type_t *type4){
-	
-	assert(ast != NULL);
-        assert(ast->kind & ARGUMENTS_NODE);
+static int sem_pop_type(struct ast_stack *types){
+	return *(int *) ast_stack_pop(types, sizeof(int));
+}
 
-	/* No function or constructor should have more than 4 arguments */
-	if(*arg_count > 4) return;
+/*
+ * The typing rules are tables over the index print_type_index() gives
+ * each type. An entry is the index of the type of the result, or one of
+ * the errors after them.
+ */
+enum {
+	I1, I2, I3, I4,		/* int, ivec2, ivec3, ivec4 */
+	F1, F2, F3, F4,		/* float, vec2, vec3, vec4 */
+	B1, B2, B3, B4,		/* bool, bvec2, bvec3, bvec4 */
+	AN,			/* any */
+
+	NB,			/* an operand is bool */
+	SB,			/* the operands have different base types */
+	SV,			/* a scalar and a vector */
+	NS,			/* an operand isn't a scalar */
+	NL,			/* logical: an operand isn't bool */
+	LV,			/* logical: a scalar and a vector */
+
+	ARGS_BASE		/* of a call: the base type of its arguments */
+};
+
+#define SEM_BASE(index)	((index) & ~3)		/* int, float, bool or any */
+#define SEM_SIZE(index)	(((index) & 3) + 1)	/* of a vector, 1 for a scalar */
+#define SEM_ARG(index)	(1 << (index))
+
+struct sem_unary_rule {
+	const char *error;			/* with the operand's type */
+	unsigned char types[NUM_TYPES];		/* by the operand's type */
+};
+
+static const struct sem_unary_rule sem_unary_rules[] = {
+	{ "SEMANTIC ERROR: Attempting to use unary logical operator '!' on type %s. Type must be bool.\n",
+	/*  I1  I2  I3  I4  F1  F2  F3  F4  B1  B2  B3  B4  AN */
+	  { NL, NL, NL, NL, NL, NL, NL, NL, B1, B1, B1, B1, B1 } },
+	{ "SEMANTIC ERROR: Attempting to use unary arithmetic operator '-' on type %s. Type must be int, float, ivec or vec.\n",
+	  { I1, I2, I3, I4, F1, F2, F3, F4, NB, NB, NB, NB, AN } }
+};
+
+struct sem_binary_rule {
+	const char *ops;			/* in the errors */
+	unsigned char types[NUM_TYPES][NUM_TYPES];	/* by left, then right operand type */
+};
+
+static const struct sem_binary_rule sem_binary_rules[] = {
+	{ "'+' or '-'", {
+	/*	      I1  I2  I3  I4  F1  F2  F3  F4  B1  B2  B3  B4  AN */
+	/* int   */ { I1, SV, SV, SV, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec2 */ { SV, I1, I1, I1, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec3 */ { SV, I1, I1, I1, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec4 */ { SV, I1, I1, I1, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* float */ { SB, SB, SB, SB, F1, SV, SV, SV, NB, NB, NB, NB, F1 },
+	/* vec2  */ { SB, SB, SB, SB, SV, F1, F1, F1, NB, NB, NB, NB, F1 },
+	/* vec3  */ { SB, SB, SB, SB, SV, F1, F1, F1, NB, NB, NB, NB, F1 },
+	/* vec4  */ { SB, SB, SB, SB, SV, F1, F1, F1, NB, NB, NB, NB, F1 },
+	/* bool  */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec2 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec3 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec4 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* any   */ { I1, I1, I1, I1, F1, F1, F1, F1, NB, NB, NB, NB, AN } } },
+	{ "'*'", {
+	/* int   */ { I1, I1, I1, I1, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec2 */ { I1, I1, I1, I1, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec3 */ { I1, I1, I1, I1, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec4 */ { I1, I1, I1, I1, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* float */ { SB, SB, SB, SB, F1, F1, F1, F1, NB, NB, NB, NB, F1 },
+	/* vec2  */ { SB, SB, SB, SB, F1, F1, F1, F1, NB, NB, NB, NB, F1 },
+	/* vec3  */ { SB, SB, SB, SB, F1, F1, F1, F1, NB, NB, NB, NB, F1 },
+	/* vec4  */ { SB, SB, SB, SB, F1, F1, F1, F1, NB, NB, NB, NB, F1 },
+	/* bool  */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec2 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec3 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec4 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* any   */ { I1, I1, I1, I1, F1, F1, F1, F1, NB, NB, NB, NB, AN } } },
+	{ "'/' or '^'", {
+	/* int   */ { I1, NS, NS, NS, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec2 */ { NS, NS, NS, NS, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec3 */ { NS, NS, NS, NS, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec4 */ { NS, NS, NS, NS, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* float */ { SB, SB, SB, SB, F1, NS, NS, NS, NB, NB, NB, NB, F1 },
+	/* vec2  */ { SB, SB, SB, SB, NS, NS, NS, NS, NB, NB, NB, NB, F1 },
+	/* vec3  */ { SB, SB, SB, SB, NS, NS, NS, NS, NB, NB, NB, NB, F1 },
+	/* vec4  */ { SB, SB, SB, SB, NS, NS, NS, NS, NB, NB, NB, NB, F1 },
+	/* bool  */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec2 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec3 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec4 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* any   */ { I1, I1, I1, I1, F1, F1, F1, F1, NB, NB, NB, NB, AN } } },
+	{ "'<', '<=', '>', or '>='", {
+	/* int   */ { B1, NS, NS, NS, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec2 */ { NS, NS, NS, NS, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec3 */ { NS, NS, NS, NS, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec4 */ { NS, NS, NS, NS, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* float */ { SB, SB, SB, SB, B1, NS, NS, NS, NB, NB, NB, NB, F1 },
+	/* vec2  */ { SB, SB, SB, SB, NS, NS, NS, NS, NB, NB, NB, NB, F1 },
+	/* vec3  */ { SB, SB, SB, SB, NS, NS, NS, NS, NB, NB, NB, NB, F1 },
+	/* vec4  */ { SB, SB, SB, SB, NS, NS, NS, NS, NB, NB, NB, NB, F1 },
+	/* bool  */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec2 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec3 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec4 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* any   */ { I1, I1, I1, I1, F1, F1, F1, F1, NB, NB, NB, NB, AN } } },
+	{ "'==' or '!='", {
+	/* int   */ { B1, SV, SV, SV, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec2 */ { SV, B1, B1, B1, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec3 */ { SV, B1, B1, B1, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* ivec4 */ { SV, B1, B1, B1, SB, SB, SB, SB, NB, NB, NB, NB, I1 },
+	/* float */ { SB, SB, SB, SB, B1, SV, SV, SV, NB, NB, NB, NB, F1 },
+	/* vec2  */ { SB, SB, SB, SB, SV, B1, B1, B1, NB, NB, NB, NB, F1 },
+	/* vec3  */ { SB, SB, SB, SB, SV, B1, B1, B1, NB, NB, NB, NB, F1 },
+	/* vec4  */ { SB, SB, SB, SB, SV, B1, B1, B1, NB, NB, NB, NB, F1 },
+	/* bool  */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec2 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec3 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* bvec4 */ { NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB, NB },
+	/* any   */ { I1, I1, I1, I1, F1, F1, F1, F1, NB, NB, NB, NB, AN } } },
+	{ NULL, {
+	/* int   */ { NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL },
+	/* ivec2 */ { NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL },
+	/* ivec3 */ { NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL },
+	/* ivec4 */ { NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL },
+	/* float */ { NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL },
+	/* vec2  */ { NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL },
+	/* vec3  */ { NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL },
+	/* vec4  */ { NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL, NL },
+	/* bool  */ { NL, NL, NL, NL, NL, NL, NL, NL, B1, LV, LV, LV, B1 },
+	/* bvec2 */ { NL, NL, NL, NL, NL, NL, NL, NL, LV, B1, B1, B1, B1 },
+	/* bvec3 */ { NL, NL, NL, NL, NL, NL, NL, NL, LV, B1, B1, B1, B1 },
+	/* bvec4 */ { NL, NL, NL, NL, NL, NL, NL, NL, LV, B1, B1, B1, B1 },
+	/* any   */ { NL, NL, NL, NL, NL, NL, NL, NL, B1, B1, B1, B1, B1 } } }
+};
+
+/* By error, from NB on. The logical ones take the operands' types, the
+ * others the operators. */
+static const char *sem_binary_errors[] = {
+	"SEMANTIC ERROR: Binary op %s. Types can't be bool.\n",
+	"SEMANTIC ERROR: Binary op %s. Must have same base types.\n",
+	"SEMANTIC ERROR: Binary op %s. Can't mix scalars and vectors.\n",
+	"SEMANTIC ERROR: Binary op %s. Must both be scalars.\n",
+	"SEMANTIC ERROR: Both operands of logical binary expression need to be of bool type, and are not. "
+		"One is type %s, and the other is type %s.\n",
+	"SEMANTIC ERROR: Both operands of logical binary expression need to be the same (either scalar or vector), and are not. "
+		"One is type %s, and the other is type %s.\n"
+};
+
+static const struct sem_unary_rule *sem_unary_rule(int op){
+	switch(op){
+	  case '!':	return &sem_unary_rules[0];
+	  case '-':	return &sem_unary_rules[1];
+	  default:	return NULL;
+	}
+}
 
-	if(ast->arguments.args != NULL)
-		sem_check_args(ast->arguments.args, arg_count, type1, type2, type3, type4);
-	switch(*arg_count){
-	  case 0:
-		sem_check_expr(ast->arguments.expr, type1);
-		break;
-	  case 1:
-		sem_check_expr(ast->arguments.expr, type2);
-                break;
-	  case 2:
-		sem_check_expr(ast->arguments.expr, type3);
-                break;
-	  case 3:
-		sem_check_expr(ast->arguments.expr, type4);
-                break;
-	  /* No need to support over 4 arguments */
-	  default:
-		break;
+static const struct sem_binary_rule *sem_binary_rule(int op){
+	switch(op){
+	  case '+':
+	  case '-':	return &sem_binary_rules[0];
+	  case '*':	return &sem_binary_rules[1];
+	  case '/':
+	  case '^':	return &sem_binary_rules[2];
+	  case '<':
+	  case _LEQ:
+	  case '>':
+	  case _GEQ:	return &sem_binary_rules[3];
+	  case _EQ:
+	  case _NEQ:	return &sem_binary_rules[4];
+	  case _AND:
+	  case _OR:	return &sem_binary_rules[5];
+	  default:	return NULL;
+	}
+}
+
+/*
+ * What a function or constructor takes: the number of arguments and the
+ * types each may be. The result is its type, also when the call is
+ * wrong, unless it is ARGS_BASE: then the arguments that aren't any must
+ * all be of one type, and the result is its base type (any if wrong).
+ */
+struct sem_signature {
+	const char *count_error;	/* with the number of arguments */
+	const char *type_error;		/* with the types of the arguments */
+	unsigned char num_args;
+	unsigned char result;
+	unsigned short args;		/* SEM_ARG() of each type accepted */
+};
+
+#define SEM_INT_ARG	(SEM_ARG(I1) | SEM_ARG(AN))
+#define SEM_FLOAT_ARG	(SEM_ARG(F1) | SEM_ARG(AN))
+#define SEM_BOOL_ARG	(SEM_ARG(B1) | SEM_ARG(AN))
+
+/* By func_t */
+static const struct sem_signature sem_functions[NUM_FUNCS] = {
+	{ "SEMANTIC ERROR: DP3 function needs 2 arguments, and has %d arguments.\n",
+	  "SEMANTIC ERROR: DP3 function need arguments to be ivec3s, ivec4s, vec3s, or vec4s. Argument types are: %s, %s\n",
+	  2, ARGS_BASE, SEM_ARG(I3) | SEM_ARG(I4) | SEM_ARG(F3) | SEM_ARG(F4) | SEM_ARG(AN) },
+	{ "SEMANTIC ERROR: LIT function needs 1 argument, and has %d arguments.\n",
+	  "SEMANTIC ERROR: LIT function needs argument type vec4, and has argument type %s.\n",
+	  1, F4, SEM_ARG(F4) | SEM_ARG(AN) },
+	{ "SEMANTIC ERROR: RSQ function needs 1 argument, and has %d arguments.\n",
+	  "SEMANTIC ERROR: RSQ function needs argument type int or float, and has argument type %s.\n",
+	  1, F1, SEM_ARG(I1) | SEM_ARG(F1) | SEM_ARG(AN) }
+};
+
+/* By the index of the type constructed; there is no constructor for any */
+static const struct sem_signature sem_constructors[NUM_TYPES - 1] = {
+	{ "SEMANTIC ERROR: INT constructor needs 1 argument, and has %d arguments.\n",
+	  "SEMANTIC ERROR: INT constructor needs argument type int, and has argument type %s.\n",
+	  1, I1, SEM_INT_ARG },
+	{ "SEMANTIC ERROR: IVEC2 constructor needs 2 arguments, and has %d arguments.\n",
+	  "SEMANTIC ERROR: IVEC2 constructor needs arguments type int, and has arguments type %s, %s.\n",
+	  2, I2, SEM_INT_ARG },
+	{ "SEMANTIC ERROR: IVEC3 constructor needs 3 arguments, and has %d arguments.\n",
+	  "SEMANTIC ERROR: IVEC3 constructor needs arguments type int, and has arguments type %s, %s, %s.\n",
+	  3, I3, SEM_INT_ARG },
+	{ "SEMANTIC ERROR: IVEC4 constructor needs 4 arguments, and has %d arguments.\n",
+	  "SEMANTIC ERROR: IVEC4 constructor needs arguments type int, and has arguments type %s, %s, %s, %s.\n",
+	  4, I4, SEM_INT_ARG },
+	{ "SEMANTIC ERROR: FLOAT constructor needs 1 argument, and has %d arguments.\n",
+	  "SEMANTIC ERROR: FLOAT constructor needs argument type float, and has argument type %s.\n",
+	  1, F1, SEM_FLOAT_ARG },
+	{ "SEMANTIC ERROR: VEC2 constructor needs 2 arguments, and has %d arguments.\n",
+	  "SEMANTIC ERROR: VEC2 constructor needs arguments type float, and has arguments type %s, %s.\n",
+	  2, F2, SEM_FLOAT_ARG },
+	{ "SEMANTIC ERROR: VEC3 constructor needs 3 arguments, and has %d arguments.\n",
+	  "SEMANTIC ERROR: VEC3 constructor needs arguments type float, and has arguments type %s, %s, %s.\n",
+	  3, F3, SEM_FLOAT_ARG },
+	{ "SEMANTIC ERROR: VEC4 constructor needs 4 arguments, and has %d arguments.\n",
+	  "SEMANTIC ERROR: VEC4 constructor needs arguments type float, and has arguments type %s, %s, %s, %s.\n",
+	  4, F4, SEM_FLOAT_ARG },
+	{ "SEMANTIC ERROR: BOOL constructor needs 1 argument, and has %d arguments.\n",
+	  "SEMANTIC ERROR: BOOL constructor needs argument type bool, and has argument type %s.\n",
+	  1, B1, SEM_BOOL_ARG },
+	{ "SEMANTIC ERROR: BVEC2 constructor needs 2 arguments, and has %d arguments.\n",
+	  "SEMANTIC ERROR: BVEC2 constructor needs arguments type bool, and has arguments type %s, %s.\n",
+	  2, B2, SEM_BOOL_ARG },
+	{ "SEMANTIC ERROR: BVEC3 constructor needs 3 arguments, and has %d arguments.\n",
+	  "SEMANTIC ERROR: BVEC3 constructor needs arguments type bool, and has arguments type %s, %s, %s.\n",
+	  3, B3, SEM_BOOL_ARG },
+	{ "SEMANTIC ERROR: BVEC4 constructor needs 4 arguments, and has %d arguments.\n",
+	  "SEMANTIC ERROR: BVEC4 constructor needs arguments type bool, and has arguments type %s, %s, %s, %s.\n",
+	  4, B4, SEM_BOOL_ARG }
+};
+
+/* Take the types of the arguments of a call, returning how many
+ * arguments there are and the indices of the types of the first four */
+static int sem_check_args(struct ast_stack *types, struct ast_node *ast, int args[4]){
+	unsigned int i;
+
+	assert(AST_IS_EXPR(ast->kind));
+
+	/* No need to support over 4 arguments, the rest aren't checked */
+	for(i = ast->args.num < 4 ? ast->args.num : 4; i > 0; i--)
+		args[i - 1] = sem_pop_type(types);
+
+	return ast->args.num;
+}
+
+/* The index of the type of a call to sig, given its arguments, reporting
+ * what's wrong with it */
+static int sem_check_call(compile_session_t *cs, const struct sem_signature *sig, int arg_count, const int args[4]){
+	int same, i;
+
+	if(arg_count != sig->num_args){
+		fprintf(cs->errorFile, sig->count_error, arg_count);
+		cs->errorOccurred = TRUE;
+		return sig->result == ARGS_BASE ? AN : sig->result;
+	}
+
+	same = AN;
+	for(i = 0; i < arg_count; i++){
+		if(!(sig->args & SEM_ARG(args[i])))
+			break;
+		if(args[i] == AN)
+			continue;
+		if(sig->result == ARGS_BASE && same != AN && args[i] != same)
+			break;
+		same = args[i];
 	}
 
-	(*arg_count)++;
+	if(i < arg_count){
+		fprintf(cs->errorFile, sig->type_error, type_strings[args[0]], type_strings[args[1]],
+			type_strings[args[2]], type_strings[args[3]]);
+		cs->errorOccurred = TRUE;
+		return sig->result == ARGS_BASE ? AN : sig->result;
+	}
 
-	return;
+	return sig->result == ARGS_BASE ? SEM_BASE(same) : sig->result;
 }
 
-static void sem_check_expr(node *ast, type_t *type){
-	struct st_entry *ste;
-	type_t type1, type2, type3, type4;
-	int arg_count;
+static void sem_check_expr(compile_session_t *cs, node_t n, struct ast_stack *types, int *type){
+	struct ast_node *ast = AST_NODE(cs, n);
+	const struct sem_unary_rule *unary;
+	const struct sem_binary_rule *binary;
+	const struct st_entry *ste;
+	int args[4] = { AN, AN, AN, AN };
+	int type1, type2, result, arg_count;
 
-	assert(ast != NULL);
-        assert(ast->kind & EXPRESSION_NODE);
+	assert(n != AST_NIL);
+        assert(AST_IS_EXPR(ast->kind));
 
         switch(ast->kind){
 	  case UNARY_EXPRESSION_NODE:
-		sem_check_expr(ast->unary_expr.expr, &type1);
+		type1 = sem_pop_type(types);
 
-		/* Type check */	
-		switch(ast->unary_expr.op){	
-		  case '!': /* Logical unary operator */
-			if(!(type1 & BOOL)){
-				fprintf(errorFile, "SEMANTIC ERROR: Attempting to use unary logical operator '!' on type %s. Type must be bool.\n", type_strings[print_type_index(type1)]);
-				errorOccurred = TRUE;
-				ast->unary_expr.type = ANY;
-				*type = ANY;
-			}
-			else{ /* We're good. */	
-				ast->unary_expr.type = BOOL;
-				*type = BOOL;
-			}
-			break;
-		  case '-': /* Arithmetic unary operator */
-			if((type1 & BOOL) && (type1 != ANY)){
-				fprintf(errorFile, "SEMANTIC ERROR: Attempting to use unary arithmetic operator '-' on type %s. Type must be int, float, ivec or vec.\n", type_strings[print_type_index(type1)]);
-                                errorOccurred = TRUE;
-                                ast->unary_expr.type = ANY;
-                                *type = ANY;
-			}
-			else{ /* We're good. */
-				ast->unary_expr.type = type1;
-                                *type = type1;
-			}
-			break;
-		  default:
-			printf("sem_check_expr: Unsupported unary op type.\n");
+		unary = sem_unary_rule(ast->op);
+		if(unary == NULL){
+			fprintf(cs->outputFile, "sem_check_expr: Unsupported unary op type.\n");
 			break;
 		}
+
+		result = unary->types[type1];
+		if(result >= NUM_TYPES){
+			fprintf(cs->errorFile, unary->error, type_strings[type1]);
+			cs->errorOccurred = TRUE;
+			result = AN;
+		}
+		AST_SET_TYPE(cs, n, type_values[result]);
+		*type = result;
 		break;
 	  case BINARY_EXPRESSION_NODE:
-		sem_check_expr(ast->binary_expr.left, &type1);
-		sem_check_expr(ast->binary_expr.right, &type2);
-
-		/* Type check */
-		switch(ast->binary_expr.op){
-			case _AND:
-			case _OR:/* Logical binary operators */
-				/* 1. Must be bools */
-				if(!((type1 & BOOL) && (type2 & BOOL))){
-					fprintf(errorFile, "SEMANTIC ERROR: Both operands of logical binary expression need to be of bool type, and are not. "
-							    "One is type %s, and the other is type %s.\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)]);
-					errorOccurred = TRUE;
-                       	 		ast->binary_expr.type = ANY;
-					*type = ANY;
-					return;
-				}
-				/* 2. Can't mix scalars and vectors */
-				if((type1 == ANY) || (type2 == ANY)){
-					/* If either are type ANY, then we're good. */
-					ast->binary_expr.type = BOOL;
-                                	*type = BOOL;
-					return;
-				}
-				if(type1 == BOOL){
-					if(type2 != BOOL){ /* type1 is scalar, type2 is vector */
-						fprintf(errorFile, "SEMANTIC ERROR: Both operands of logical binary expression need to be the same (either scalar or vector), and are not. "
-								    "One is type %s, and the other is type %s.\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)]);
-                                        	errorOccurred = TRUE;
-                                        	ast->binary_expr.type = ANY;
-                                        	*type = ANY;
-                                        	return;
-					}
-				}
-				else if(type2 == BOOL){ /* type1 is vector, type2 is scalar */
-					fprintf(errorFile, "SEMANTIC ERROR: Both operands of logical binary expression need to be the same (either scalar or vector), and are not. "
-                                                            "One is type %s, and the other is type %s.\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)]);
-                                      	errorOccurred = TRUE;
-                                       	ast->binary_expr.type = ANY;
-                                       	*type = ANY;
-                                       	return;
-				}
-
-				/* We're good. */
-				ast->binary_expr.type = BOOL;
-				*type = BOOL;
-				break;
-			  case '+':
-			  case '-': /* Arithmetic binary operators that accept scalars or vectors, but not mixes of the two */
-				/* 1. Can't be bools */
-				if(((type1 & BOOL) && (type1 != ANY)) || ((type2 & BOOL) && (type2 != ANY))){
-					fprintf(errorFile, "SEMANTIC ERROR: Binary op '+' or '-'. Types can't be bool.\n");
-					errorOccurred = TRUE;
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-				}
-				/* 2. Must have same base types */
-				if((type1 == ANY) && (type2 == ANY)){ /* Both are any */
-					ast->binary_expr.type = ANY;
-                                	*type = ANY;
-					return;
-				}
-				else if(type1 == ANY){ /* type1 is any, type2 is not */
-					ast->binary_expr.type = (type2 & INT) ? INT : FLOAT;
-                                	*type = (type2 & INT) ? INT : FLOAT;
-					return;
-				}
-				else if(type2 == ANY){ /* type2 is any, type1 is not */
-					ast->binary_expr.type = (type1 & INT) ? INT : FLOAT;
-                                	*type = (type1 & INT) ? INT : FLOAT;
-					return;
-				}
-				/* Neither are ANY, so do the base type checking */
-				if(type1 & INT){
-					if(!(type2 & INT)){ /* type1 int type2 float */
-						fprintf(errorFile, "SEMANTIC ERROR: Binary op '+' or '-'. Must have same base types.\n");
-                                        	errorOccurred = TRUE;
-                                        	ast->binary_expr.type = ANY;
-                                        	*type = ANY;
-                                        	return;
-					}
-					/* 3. If 1 is scalar, 2 needs to be scalar */
-					if(type1 == INT){
-						if(type2 != INT){
-							fprintf(errorFile, "SEMANTIC ERROR: Binary op '+' or '-'. Can't mix scalars and vectors.\n");
-                                                	errorOccurred = TRUE;
-                                                	ast->binary_expr.type = ANY;
-                                                	*type = ANY;
-                                                	return;
-						}
-					}
-					/* 4. If 1 is vector, 2 needs to be vector */
-					else if(type2 == INT){
-						fprintf(errorFile, "SEMANTIC ERROR: Binary op '+' or '-'. Can't mix scalars and vectors.\n");
-                                                errorOccurred = TRUE;
-                                                ast->binary_expr.type = ANY;
-                                                *type = ANY;
-                                                return;
-					}
-				}
-				else if(type2 & INT){ /* type1 float type2 int */
-					fprintf(errorFile, "SEMANTIC ERROR: Binary op '+' or '-'. Must have same base types.\n");
-                                        errorOccurred = TRUE;
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-				}
-				else{ /* type1 float type2 float */
-					/* 3. If 1 is scalar, 2 needs to be scalar */
-                                        if(type1 == FLOAT){
-                                                if(type2 != FLOAT){
-                                                        fprintf(errorFile, "SEMANTIC ERROR: Binary op '+' or '-'. Can't mix scalars and vectors.\n");
-                                                        errorOccurred = TRUE;
-                                                        ast->binary_expr.type = ANY;
-                                                        *type = ANY;
-                                                        return;
-                                                }
-                                        }
-                                        /* 4. If 1 is vector, 2 needs to be vector */
-                                        else if(type2 == FLOAT){
-                                                fprintf(errorFile, "SEMANTIC ERROR: Binary op '+' or '-'. Can't mix scalars and vectors.\n");
-                                                errorOccurred = TRUE;
-                                                ast->binary_expr.type = ANY;
-                                                *type = ANY;
-                                                return;
-                                        }
-				}
+		type2 = sem_pop_type(types);
+		type1 = sem_pop_type(types);
 
-				/* We're good. */
-				ast->binary_expr.type = (type1 & INT) ? INT : FLOAT;
-                                *type = (type1 & INT) ? INT : FLOAT;
-				break;
-			  case '*': /* Arithmetic binary operators that accept scalars, vectors, and mixes */
-                                /* 1. Can't be bools */
-                                if(((type1 & BOOL) && (type1 != ANY)) || ((type2 & BOOL) && (type2 != ANY))){
-                                        fprintf(errorFile, "SEMANTIC ERROR: Binary op '*'. Types can't be bool.\n");
-                                        errorOccurred = TRUE;
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-                                }
-                                /* 2. Must have same base types */
-                                if((type1 == ANY) && (type2 == ANY)){ /* Both are any */
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-                                }
-                                else if(type1 == ANY){ /* type1 is any, type2 is not */
-                                        ast->binary_expr.type = (type2 & INT) ? INT : FLOAT;
-                                        *type = (type2 & INT) ? INT : FLOAT;
-                                        return;
-                                }
-                                else if(type2 == ANY){ /* type2 is any, type1 is not */
-                                        ast->binary_expr.type = (type1 & INT) ? INT : FLOAT;
-                                        *type = (type1 & INT) ? INT : FLOAT;
-                                        return;
-                                }
-                                /* Neither are ANY, so do the base type checking */
-                                if(type1 & INT){
-                                        if(!(type2 & INT)){ /* type1 int type2 float */
-                                                fprintf(errorFile, "SEMANTIC ERROR: Binary op '*'. Must have same base types.\n");
-                                                errorOccurred = TRUE;
-                                                ast->binary_expr.type = ANY;
-                                                *type = ANY;
-                                                return;
-                                        }
-                                }
-                                else if(type2 & INT){ /* type1 float type2 int */
-                                        fprintf(errorFile, "SEMANTIC ERROR: Binary op '*'. Must have same base types.\n");
-                                        errorOccurred = TRUE;
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-                                }
-
-                                /* We're good. */
-                                ast->binary_expr.type = (type1 & INT) ? INT : FLOAT;
-                                *type = (type1 & INT) ? INT : FLOAT;
-                                break;
-			  case '/':
-			  case '^': /* Arithmetic binary operators that accept scalars only */
-                                /* 1. Can't be bools */
-                                if(((type1 & BOOL) && (type1 != ANY)) || ((type2 & BOOL) && (type2 != ANY))){
-                                        fprintf(errorFile, "SEMANTIC ERROR: Binary op '/' or '^'. Types can't be bool.\n");
-                                        errorOccurred = TRUE;
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-                                }
-                                /* 2. Must have same base types */
-                                if((type1 == ANY) && (type2 == ANY)){ /* Both are any */
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-                                }
-                                else if(type1 == ANY){ /* type1 is any, type2 is not */
-                                        ast->binary_expr.type = (type2 & INT) ? INT : FLOAT;
-                                        *type = (type2 & INT) ? INT : FLOAT;
-                                        return;
-                                }
-                                else if(type2 == ANY){ /* type2 is any, type1 is not */
-                                        ast->binary_expr.type = (type1 & INT) ? INT : FLOAT;
-                                        *type = (type1 & INT) ? INT : FLOAT;
-                                        return;
-                                }
-                                /* Neither are ANY, so do the base type checking */
-                                if(type1 & INT){
-                                        if(!(type2 & INT)){ /* type1 int type2 float */
-                                                fprintf(errorFile, "SEMANTIC ERROR: Binary op '/' or '^'. Must have same base types.\n");
-                                                errorOccurred = TRUE;
-                                                ast->binary_expr.type = ANY;
-                                                *type = ANY;
-                                                return;
-                                        }
-					else if((type1 != INT) || (type2 != INT)){ /* Both are ints, but one (or both) is/are not scalar */
-						fprintf(errorFile, "SEMANTIC ERROR: Binary op '/' or '^'. Must both be scalars.\n");
-                                                errorOccurred = TRUE;
-                                                ast->binary_expr.type = ANY;
-                                                *type = ANY;
-                                                return;
-					}
-                                }
-                                else if(type2 & INT){ /* type1 float type2 int */
-                                        fprintf(errorFile, "SEMANTIC ERROR: Binary op '/' or '^'. Must have same base types.\n");
-                                        errorOccurred = TRUE;
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-                                }
-				else if((type1 != FLOAT) || (type2 != FLOAT)){ /* Both are floats, but one (or both) is/are not scalar */
-                                     	fprintf(errorFile, "SEMANTIC ERROR: Binary op '/' or '^'. Must both be scalars.\n");
-                               	        errorOccurred = TRUE;
-                     	                ast->binary_expr.type = ANY;
-               	                        *type = ANY;
-       	                                return;
-				}
-
-                                /* We're good. */
-                                ast->binary_expr.type = (type1 & INT) ? INT : FLOAT;
-                                *type = (type1 & INT) ? INT : FLOAT;
-				break;
-			  case '<':
-                          case _LEQ:
-                          case '>':
-                          case _GEQ: /* Comparison binary operators that accept scalars only */
-                                /* 1. Can't be bools */
-                                if(((type1 & BOOL) && (type1 != ANY)) || ((type2 & BOOL) && (type2 != ANY))){
-                                        fprintf(errorFile, "SEMANTIC ERROR: Binary op '<', '<=', '>', or '>='. Types can't be bool.\n");
-                                        errorOccurred = TRUE;
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-                                }
-                                /* 2. Must have same base types */
-                                if((type1 == ANY) && (type2 == ANY)){ /* Both are any */
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-                                }
-                                else if(type1 == ANY){ /* type1 is any, type2 is not */
-                                        ast->binary_expr.type = (type2 & INT) ? INT : FLOAT;
-                                        *type = (type2 & INT) ? INT : FLOAT;
-                                        return;
-                                }
-                                else if(type2 == ANY){ /* type2 is any, type1 is not */
-                                        ast->binary_expr.type = (type1 & INT) ? INT : FLOAT;
-                                        *type = (type1 & INT) ? INT : FLOAT;
-                                        return;
-                                }
-                                /* Neither are ANY, so do the base type checking */
-                                if(type1 & INT){
-                                        if(!(type2 & INT)){ /* type1 int type2 float */
-                                                fprintf(errorFile, "SEMANTIC ERROR: Binary op '<', '<=', '>', or '>='. Must have same base types.\n");
-                                                errorOccurred = TRUE;
-                                                ast->binary_expr.type = ANY;
-                                                *type = ANY;
-                                                return;
-                                        }
-                                        else if((type1 != INT) || (type2 != INT)){ /* Both are ints, but one (or both) is/are not scalar */
-                                                fprintf(errorFile, "SEMANTIC ERROR: Binary op '<', '<=', '>', or '>='. Must both be scalars.\n");
-                                                errorOccurred = TRUE;
-                                                ast->binary_expr.type = ANY;
-                                                *type = ANY;
-                                                return;
-                                        }
-                                }
-                                else if(type2 & INT){ /* type1 float type2 int */
-                                        fprintf(errorFile, "SEMANTIC ERROR: Binary op '<', '<=', '>', or '>='. Must have same base types.\n");
-                                        errorOccurred = TRUE;
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-                                }
-                                else if((type1 != FLOAT) || (type2 != FLOAT)){ /* Both are floats, but one (or both) is/are not scalar */
-                                        fprintf(errorFile, "SEMANTIC ERROR: Binary op '<', '<=', '>', or '>='. Must both be scalars.\n");
-                                        errorOccurred = TRUE;
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-                                }
-
-				/* We're good. */
-                                ast->binary_expr.type = BOOL;
-                                *type = BOOL;
-				break;
-			  case _EQ:
-			  case _NEQ: /* Comparison binary operators that accept scalars or vectors, but not mixes of the two */
-                                /* 1. Can't be bools */
-                                if(((type1 & BOOL) && (type1 != ANY)) || ((type2 & BOOL) && (type2 != ANY))){
-                                        fprintf(errorFile, "SEMANTIC ERROR: Binary op '==' or '!='. Types can't be bool.\n");
-                                        errorOccurred = TRUE;
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-                                }
-                                /* 2. Must have same base types */
-                                if((type1 == ANY) && (type2 == ANY)){ /* Both are any */
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-                                }
-                                else if(type1 == ANY){ /* type1 is any, type2 is not */
-                                        ast->binary_expr.type = (type2 & INT) ? INT : FLOAT;
-                                        *type = (type2 & INT) ? INT : FLOAT;
-                                        return;
-                                }
-                                else if(type2 == ANY){ /* type2 is any, type1 is not */
-                                        ast->binary_expr.type = (type1 & INT) ? INT : FLOAT;
-                                        *type = (type1 & INT) ? INT : FLOAT;
-                                        return;
-                                }
-                                /* Neither are ANY, so do the base type checking */
-                                if(type1 & INT){
-                                        if(!(type2 & INT)){ /* type1 int type2 float */
-                                                fprintf(errorFile, "SEMANTIC ERROR: Binary op '==' or '!='. Must have same base types.\n");
-                                                errorOccurred = TRUE;
-                                                ast->binary_expr.type = ANY;
-                                                *type = ANY;
-                                                return;
-                                        }
-                                        /* 3. If 1 is scalar, 2 needs to be scalar */
-                                        if(type1 == INT){
-                                                if(type2 != INT){
-                                                        fprintf(errorFile, "SEMANTIC ERROR: Binary op '==' or '!='. Can't mix scalars and vectors.\n");
-                                                        errorOccurred = TRUE;
-                                                        ast->binary_expr.type = ANY;
-                                                        *type = ANY;
-                                                        return;
-                                                }
-                                        }
-                                        /* 4. If 1 is vector, 2 needs to be vector */
-                                        else if(type2 == INT){
-                                                fprintf(errorFile, "SEMANTIC ERROR: Binary op '==' or '!='. Can't mix scalars and vectors.\n");
-                                                errorOccurred = TRUE;
-                                                ast->binary_expr.type = ANY;
-                                                *type = ANY;
-                                                return;
-                                        }
-                                }
-				else if(type2 & INT){ /* type1 float type2 int */
-                                        fprintf(errorFile, "SEMANTIC ERROR: Binary op '==' or '!='. Must have same base types.\n");
-                                        errorOccurred = TRUE;
-                                        ast->binary_expr.type = ANY;
-                                        *type = ANY;
-                                        return;
-                                }
-                                else{ /* type1 float type2 float */
-                                        /* 3. If 1 is scalar, 2 needs to be scalar */
-                                        if(type1 == FLOAT){
-                                                if(type2 != FLOAT){
-                                                        fprintf(errorFile, "SEMANTIC ERROR: Binary op '==' or '!='. Can't mix scalars and vectors.\n");
-                                                        errorOccurred = TRUE;
-                                                        ast->binary_expr.type = ANY;
-                                                        *type = ANY;
-                                                        return;
-                                                }
-                                        }
-                                        /* 4. If 1 is vector, 2 needs to be vector */
-                                        else if(type2 == FLOAT){
-                                                fprintf(errorFile, "SEMANTIC ERROR: Binary op '==' or '!='. Can't mix scalars and vectors.\n");
-                                                errorOccurred = TRUE;
-                                                ast->binary_expr.type = ANY;
-                                                *type = ANY;
-                                                return;
-                                        }
-                                }
+		binary = sem_binary_rule(ast->op);
+		if(binary == NULL){
+			fprintf(cs->outputFile, "sem_check_expr: Unsupported op.\n");
+			break;
+		}
 
-                                /* We're good. */
-                                ast->binary_expr.type = BOOL;
-                                *type = BOOL;
-				break;
-			  default:
-				printf("sem_check_expr: Unsupported op.\n");
-				break;
+		result = binary->types[type1][type2];
+		if(result >= NUM_TYPES){
+			if(result >= NL)
+				fprintf(cs->errorFile, sem_binary_errors[result - NB], type_strings[type1], type_strings[type2]);
+			else fprintf(cs->errorFile, sem_binary_errors[result - NB], binary->ops);
+			cs->errorOccurred = TRUE;
+			result = AN;
 		}
+		AST_SET_TYPE(cs, n, type_values[result]);
+		*type = result;
 		break;
           case BOOL_NODE:
-                ast->bool_lit.type = BOOL;
-                *type = BOOL;
+                AST_SET_TYPE(cs, n, BOOL);
+                *type = B1;
                 break;
 	  case INT_NODE:
-		ast->int_lit.type = INT;
-		*type = INT;
+		AST_SET_TYPE(cs, n, INT);
+		*type = I1;
                 break;
           case FLOAT_NODE:
-		ast->float_lit.type = FLOAT;
-                *type = FLOAT;
+		AST_SET_TYPE(cs, n, FLOAT);
+                *type = F1;
 		break;
           case VAR_NODE:
-		ste = st_lookup(ast->st, ast->var.name, GLOBAL);
+		/* Resolved once here; later passes use the entry bound */
+		ste = st_lookup(cs, cs->st_curr, ast->var.id, GLOBAL);
 		if(ste == NULL){
-			fprintf(errorFile, "SEMANTIC ERROR: Undeclared variable %s.\n", ast->var.name);
-			errorOccurred = TRUE;
-			ast->var.type = ANY;
-			*type = ANY;
+			fprintf(cs->errorFile, "SEMANTIC ERROR: Undeclared variable %s.\n", ident_name(cs, ast->var.id));
+			cs->errorOccurred = TRUE;
+			AST_SET_TYPE(cs, n, ANY);
+			*type = AN;
 		} else{
-			ast->var.type = ste->type;
-			*type = ste->type;
-		
-			/*variable indexing check*/
-			if(*type == VEC2 || *type == VEC3 || *type == VEC4){ //on a type by type basis
-				if(ast->var.ofs != -1){				
-					switch(*type){
-						case VEC2: //specific cases for each offset for vector
-							if(ast->var.ofs != 0 && ast->var.ofs != 1)
-								fprintf(errorFile, "SEMANTIC ERROR: Invalid vector index.\n");
-							break;
-						case VEC3:
-							if(ast->var.ofs != 0 && ast->var.ofs != 1 && ast->var.ofs != 2)
-								fprintf(errorFile, "SEMANTIC ERROR: Invalid vector index.\n");
-							break;
-						case VEC4:
-							if(ast->var.ofs != 0 && ast->var.ofs != 1 && ast->var.ofs != 2 && ast->var.ofs != 3)
-								fprintf(errorFile, "SEMANTIC ERROR: Invalid vector index.\n");
-							break;
-						default:
-							break;
-					}
-					*type = FLOAT;
-				}
-			}
-			else if(*type == IVEC2 || *type == IVEC3 || *type == IVEC4){
-				if(ast->var.ofs != -1){					
-					switch(*type){
-						case IVEC2:
-							if(ast->var.ofs != 0 && ast->var.ofs != 1)
-								fprintf(errorFile, "SEMANTIC ERROR: Invalid vector index.\n");
-							break;
-						case IVEC3:
-							if(ast->var.ofs != 0 && ast->var.ofs != 1 && ast->var.ofs != 2)
-								fprintf(errorFile, "SEMANTIC ERROR: Invalid vector index.\n");
-							break;
-						case IVEC4:
-							if(ast->var.ofs != 0 && ast->var.ofs != 1 && ast->var.ofs != 2 && ast->var.ofs != 3)
-								fprintf(errorFile, "SEMANTIC ERROR: Invalid vector index.\n");
-							break;
-						default:
-							break;
-					}
-					*type = INT;
-				}
-			}
-			else if(*type == BVEC2 || *type == BVEC3 || *type == BVEC4){
-				if(ast->var.ofs != -1){
-					switch(*type){
-						case BVEC2:
-							if(ast->var.ofs != 0 && ast->var.ofs != 1)
-								fprintf(errorFile, "SEMANTIC ERROR: Invalid vector index.\n");
-							break;
-						case BVEC3:
-							if(ast->var.ofs != 0 && ast->var.ofs != 1 && ast->var.ofs != 2)
-								fprintf(errorFile, "SEMANTIC ERROR: Invalid vector index.\n");
-							break;
-						case BVEC4:
-							if(ast->var.ofs != 0 && ast->var.ofs != 1 && ast->var.ofs != 2 && ast->var.ofs != 3)
-								fprintf(errorFile, "SEMANTIC ERROR: Invalid vector index.\n");
-							break;
-						default:
-							break;
-					}
-					*type = BOOL;
+			ast->var.sym = ste->sym;
+			AST_SET_TYPE(cs, n, ste->type);
+			*type = print_type_index(ste->type);
+
+			/* An element of a vector is of its base type */
+			if(SEM_SIZE(*type) > 1 && ast->op != -1){
+				if(ast->op < 0 || ast->op >= SEM_SIZE(*type)){
+					fprintf(cs->errorFile, "SEMANTIC ERROR: Invalid vector index.\n");
+					cs->errorOccurred = TRUE;
 				}
+				*type = SEM_BASE(*type);
 			}
 		}
 		break;
 	  case FUNCTION_NODE:
-		if(ast->function.args_opt == NULL){
-			fprintf(errorFile, "SEMANTIC ERROR: Function %s has zero arguments.\n", func_strings[print_func_index(ast->function.func)]);
-                        errorOccurred = TRUE;
-			*type = ANY;
+		if(ast->args.num == 0){
+			fprintf(cs->errorFile, "SEMANTIC ERROR: Function %s has zero arguments.\n", func_strings[print_func_index((func_t)ast->op)]);
+                        cs->errorOccurred = TRUE;
+			*type = AN;
 			return;
-                } else {
-			arg_count = 0;
-			sem_check_args(ast->function.args_opt, &arg_count, &type1, &type2, &type3, &type4);
-		}
-		switch(ast->function.func){
-		  case DP3: /* 2 arguments, either vec3/4s or ivec3/4s; return type is dependant on argument types */
-			if(arg_count != 2){
-				fprintf(errorFile, "SEMANTIC ERROR: DP3 function needs 2 arguments, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = ANY;
-				return;
-			}
-			else{ /* Right number of args; type check */
-				if((type1 == ANY) && (type2 == ANY)){
-                                        *type = ANY;
-					return;
-                                }
-                                else if(type1 == ANY){ /* type1 is any, type2 is not */
-					if((type2 & INT) && (type2 == IVEC3 || type2 == IVEC4)){
-						/* Good. */
-						*type = INT;
-						return;	
-					}
-					else if((type2 & FLOAT) && (type2 == VEC3 || type2 == VEC4)){
-						/* Good. */
-						*type = FLOAT;
-						return;
-					}
-					else{ /* Not good. */
-						fprintf(errorFile, "SEMANTIC ERROR: DP3 function need arguments to be ivec3s, ivec4s, vec3s, or vec4s. Argument types are: %s, %s\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)]);
-                        			errorOccurred = TRUE;
-						*type = ANY;
-						return;
-					}
-				} else if(type2 == ANY){ /* type2 is any, type1 is not */
-					if((type1 & INT) && (type1 == IVEC3 || type1 == IVEC4)){
-						/* Good. */
-						*type = INT;
-						return;	
-					}
-					else if((type1 & FLOAT) && (type1 == VEC3 || type1 == VEC4)){
-						/* Good. */
-						*type = FLOAT;
-						return;
-					}
-					else{ /* Not good. */
-						fprintf(errorFile, "SEMANTIC ERROR: DP3 function need arguments to be ivec3s, ivec4s, vec3s, or vec4s. Argument types are: %s, %s\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)]);
-                        			errorOccurred = TRUE;
-						*type = ANY;
-						return;
-					}
-				}
-				else{ /* Neither are type ANY */
-					if(type1 != type2){
-						fprintf(errorFile, "SEMANTIC ERROR: DP3 function need arguments to be ivec3s, ivec4s, vec3s, or vec4s. Argument types are: %s, %s\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)]);
-                        			errorOccurred = TRUE;
-						*type = ANY;
-						return;
-					}
-					else{
-						if((type1 & INT) && (type1 == IVEC3 || type1 == IVEC4)){
-							/* Good. */
-							*type = INT;
-							return;	
-						}
-						else if((type1 & FLOAT) && (type1 == VEC3 || type1 == VEC4)){
-							/* Good. */
-							*type = FLOAT;
-							return;
-						}
-						else{ /* Not good. */
-							fprintf(errorFile, "SEMANTIC ERROR: DP3 function need arguments to be ivec3s, ivec4s, vec3s, or vec4s. Argument types are: %s, %s\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)]);
-                        				errorOccurred = TRUE;
-							*type = ANY;
-							return;
-						}
-					} 
-				} 
-			}
-			break;
-		  case LIT:
-			if(arg_count != 1){
-				fprintf(errorFile, "SEMANTIC ERROR: LIT function needs 1 argument, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = VEC4;
-				return;
-			}
-			else{
-				if(!((type1 == VEC4) || (type1 == ANY))){
-					fprintf(errorFile, "SEMANTIC ERROR: LIT function needs argument type vec4, and has argument type %s.\n", type_strings[print_type_index(type1)]);
-                        		errorOccurred = TRUE;
-					*type = VEC4;
-					return;
-				} else{ /* Good. */
-					*type = VEC4;
-					return;
-				}
-			}
-			break;
-		  case RSQ:
-			if(arg_count != 1){
-				fprintf(errorFile, "SEMANTIC ERROR: RSQ function needs 1 argument, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = FLOAT;
-				return;
-			}
-			else{
-				if(!((type1 == INT) || (type1 == FLOAT) || (type1 == ANY))){
-					fprintf(errorFile, "SEMANTIC ERROR: RSQ function needs argument type int or float, and has argument type %s.\n", type_strings[print_type_index(type1)]);
-                        		errorOccurred = TRUE;
-					*type = FLOAT;
-					return;
-				} else{ /* Good. */
-					*type = FLOAT;
-					return;
-				}
-			}
-			break;
-		  default:
-			fprintf(outputFile, "sem_check_expr: Warning: Unexpected function type.\n");
+                }
+		arg_count = sem_check_args(types, ast, args);
+		if(ast->op < 0 || ast->op >= NUM_FUNCS){
+			fprintf(cs->outputFile, "sem_check_expr: Warning: Unexpected function type.\n");
 			break;
 		}
+		*type = sem_check_call(cs, &sem_functions[ast->op], arg_count, args);
+		AST_SET_TYPE(cs, n, type_values[*type]);
 		break;
 	  case CONSTRUCTOR_NODE:
-		if(ast->constructor.args_opt == NULL){
-			fprintf(errorFile, "SEMANTIC ERROR: Constructor for %s has zero arguments.\n", type_strings[print_type_index(ast->constructor.type)]);
-                        errorOccurred = TRUE;
-			*type = ANY;
+		type1 = print_type_index((type_t)ast->op);
+		if(ast->args.num == 0){
+			fprintf(cs->errorFile, "SEMANTIC ERROR: Constructor for %s has zero arguments.\n", type_strings[type1]);
+                        cs->errorOccurred = TRUE;
+			*type = AN;
 			return;
-                } else {
-			arg_count = 0;
-			sem_check_args(ast->constructor.args_opt, &arg_count, &type1, &type2, &type3, &type4);
-		}
-		switch(ast->constructor.type){
-		  case INT:
-			if(arg_count != 1){
-				fprintf(errorFile, "SEMANTIC ERROR: INT constructor needs 1 argument, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = INT;
-				return;
-			} else{
-				if(!((type1 == INT) || (type1 == ANY))){
-					fprintf(errorFile, "SEMANTIC ERROR: INT constructor needs argument type int, and has argument type %s.\n", type_strings[print_type_index(type1)]);
-                        		errorOccurred = TRUE;
-					*type = INT;
-					return;
-				}
-				else{ /* Good. */
-					*type = INT;
-					return;
-				}
-			}
-			break;
-		  case IVEC2:
-			if(arg_count != 2){
-				fprintf(errorFile, "SEMANTIC ERROR: IVEC2 constructor needs 2 arguments, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = IVEC2;
-				return;
-			} else{
-				if(!(((type1 == INT) || (type1 == ANY)) && ((type2 == INT) || type2 == ANY))){
-					fprintf(errorFile, "SEMANTIC ERROR: IVEC2 constructor needs arguments type int, and has arguments type %s, %s.\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)]);
-                        		errorOccurred = TRUE;
-					*type = IVEC2;
-					return;
-				} else{ /* Good. */
-					*type = IVEC2;
-					return;
-				}
-			}
-			break;
-		  case IVEC3:
-			if(arg_count != 3){
-				fprintf(errorFile, "SEMANTIC ERROR: IVEC3 constructor needs 3 arguments, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = IVEC3;
-				return;
-			} else{
-				if(!( ( (type1 == INT) || (type1 == ANY) ) && ( (type2 == INT) || (type2 == ANY) )
-				   && ( (type3 == INT) || (type3 == ANY) ) )) {
-					fprintf(errorFile, "SEMANTIC ERROR: IVEC3 constructor needs arguments type int, and has arguments type %s, %s, %s.\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)], type_strings[print_type_index(type3)]);
-                        		errorOccurred = TRUE;
-					*type = IVEC3;
-					return;
-				} else{ /* Good. */
-					*type = IVEC3;
-					return;
-				}
-			}
-			break;
-		  case IVEC4:
-			if(arg_count != 4){
-				fprintf(errorFile, "SEMANTIC ERROR: IVEC4 constructor needs 4 arguments, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = IVEC4;
-				return;
-			} else{
-				if(!( ( (type1 == INT) || (type1 == ANY) ) && ( (type2 == INT) || (type2 == ANY) )
-				   && ( (type3 == INT) || (type3 == ANY) ) && ( (type4 == INT) || (type4 == ANY) ) )) {
-					fprintf(errorFile, "SEMANTIC ERROR: IVEC4 constructor needs arguments type int, and has arguments type %s, %s, %s, %s.\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)], type_strings[print_type_index(type3)], type_strings[print_type_index(type4)]);
-                        		errorOccurred = TRUE;
-					*type = IVEC4;
-					return;
-				} else{ /* Good. */
-					*type = IVEC4;
-					return;
-				}
-			}
-			break;	
-		  case FLOAT:
-			if(arg_count != 1){
-				fprintf(errorFile, "SEMANTIC ERROR: FLOAT constructor needs 1 argument, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = FLOAT;
-				return;
-			} else{
-				if(!((type1 == FLOAT) || (type1 == ANY))){
-					fprintf(errorFile, "SEMANTIC ERROR: FLOAT constructor needs argument type float, and has argument type %s.\n", type_strings[print_type_index(type1)]);
-                        		errorOccurred = TRUE;
-					*type = FLOAT;
-					return;
-				}
-				else{ /* Good. */
-					*type = FLOAT;
-					return;
-				}
-			}
-			break;
-		  case VEC2:
-			if(arg_count != 2){
-				fprintf(errorFile, "SEMANTIC ERROR: VEC2 constructor needs 2 arguments, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = VEC2;
-				return;
-			} else{
-				if(!(((type1 == FLOAT) || (type1 == ANY)) && ((type2 == FLOAT) || type2 == ANY))){
-					fprintf(errorFile, "SEMANTIC ERROR: VEC2 constructor needs arguments type float, and has arguments type %s, %s.\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)]);
-                        		errorOccurred = TRUE;
-					*type = VEC2;
-					return;
-				} else{ /* Good. */
-					*type = VEC2;
-					return;
-				}
-			}
-			break;
-		  case VEC3:
-			if(arg_count != 3){
-				fprintf(errorFile, "SEMANTIC ERROR: VEC3 constructor needs 3 arguments, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = VEC3;
-				return;
-			} else{
-				if(!( ( (type1 == FLOAT) || (type1 == ANY) ) && ( (type2 == FLOAT) || (type2 == ANY) )
-				   && ( (type3 == FLOAT) || (type3 == ANY) ) )) {
-					fprintf(errorFile, "SEMANTIC ERROR: VEC3 constructor needs arguments type float, and has arguments type %s, %s, %s.\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)], type_strings[print_type_index(type3)]);
-                        		errorOccurred = TRUE;
-					*type = VEC3;
-					return;
-				} else{ /* Good. */
-					*type = VEC3;
-					return;
-				}
-			}
-			break;
-		  case VEC4:
-			if(arg_count != 4){
-				fprintf(errorFile, "SEMANTIC ERROR: VEC4 constructor needs 4 arguments, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = VEC4;
-				return;
-			} else{
-				if(!( ( (type1 == FLOAT) || (type1 == ANY) ) && ( (type2 == FLOAT) || (type2 == ANY) )
-				   && ( (type3 == FLOAT) || (type3 == ANY) ) && ( (type4 == FLOAT) || (type4 == ANY) ) )) {
-					fprintf(errorFile, "SEMANTIC ERROR: VEC4 constructor needs arguments type float, and has arguments type %s, %s, %s, %s.\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)], type_strings[print_type_index(type3)], type_strings[print_type_index(type4)]);
-                        		errorOccurred = TRUE;
-					*type = VEC4;
-					return;
-				} else{ /* Good. */
-					*type = VEC4;
-					return;
-				}
-			}
-			break;
-		  case BOOL:
-			if(arg_count != 1){
-				fprintf(errorFile, "SEMANTIC ERROR: BOOL constructor needs 1 argument, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = BOOL;
-				return;
-			} else{
-				if(!((type1 == BOOL) || (type1 == ANY))){
-					fprintf(errorFile, "SEMANTIC ERROR: BOOL constructor needs argument type bool, and has argument type %s.\n", type_strings[print_type_index(type1)]);
-                        		errorOccurred = TRUE;
-					*type = BOOL;
-					return;
-				}
-				else{ /* Good. */
-					*type = BOOL;
-					return;
-				}
-			}
-			break;
-		  case BVEC2:
-			if(arg_count != 2){
-				fprintf(errorFile, "SEMANTIC ERROR: BVEC2 constructor needs 2 arguments, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = BVEC2;
-				return;
-			} else{
-				if(!(((type1 == BOOL) || (type1 == ANY)) && ((type2 == BOOL) || type2 == ANY))){
-					fprintf(errorFile, "SEMANTIC ERROR: BVEC2 constructor needs arguments type bool, and has arguments type %s, %s.\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)]);
-                        		errorOccurred = TRUE;
-					*type = BVEC2;
-					return;
-				} else{ /* Good. */
-					*type = BVEC2;
-					return;
-				}
-			}
-			break;
-		  case BVEC3:
-			if(arg_count != 3){
-				fprintf(errorFile, "SEMANTIC ERROR: BVEC3 constructor needs 3 arguments, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = BVEC3;
-				return;
-			} else{
-				if(!( ( (type1 == BOOL) || (type1 == ANY) ) && ( (type2 == BOOL) || (type2 == ANY) )
-				   && ( (type3 == BOOL) || (type3 == ANY) ) )) {
-					fprintf(errorFile, "SEMANTIC ERROR: BVEC3 constructor needs arguments type bool, and has arguments type %s, %s, %s.\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)], type_strings[print_type_index(type3)]);
-                        		errorOccurred = TRUE;
-					*type = BVEC3;
-					return;
-				} else{ /* Good. */
-					*type = BVEC3;
-					return;
-				}
-			}
-			break;
-		  case BVEC4:
-			if(arg_count != 4){
-				fprintf(errorFile, "SEMANTIC ERROR: BVEC4 constructor needs 4 arguments, and has %d arguments.\n", arg_count);
-                        	errorOccurred = TRUE;
-				*type = BVEC4;
-				return;
-			} else{
-				if(!( ( (type1 == BOOL) || (type1 == ANY) ) && ( (type2 == BOOL) || (type2 == ANY) )
-				   && ( (type3 == BOOL) || (type3 == ANY) ) && ( (type4 == BOOL) || (type4 == ANY) ) )) {
-					fprintf(errorFile, "SEMANTIC ERROR: BVEC4 constructor needs arguments type bool, and has arguments type %s, %s, %s, %s.\n", type_strings[print_type_index(type1)], type_strings[print_type_index(type2)], type_strings[print_type_index(type3)], type_strings[print_type_index(type4)]);
-                        		errorOccurred = TRUE;
-					*type = BVEC4;
-					return;
-				} else{ /* Good. */
-					*type = BVEC4;
-					return;
-				}
-			}
-			break;
-		  default:
-			fprintf(outputFile, "sem_check_expr: Warning: constructor type is ANY.\n");
+                }
+		arg_count = sem_check_args(types, ast, args);
+		if(type1 == AN){
+			fprintf(cs->outputFile, "sem_check_expr: Warning: constructor type is ANY.\n");
 			break;
 		}
+		*type = sem_check_call(cs, &sem_constructors[type1], arg_count, args);
+		AST_SET_TYPE(cs, n, type_values[*type]);
 		break;
           default:
-                printf("sem_check_expr: Unsupported expression type.\n");
+                fprintf(cs->outputFile, "sem_check_expr: Unsupported expression type.\n");
                 break;
 	}
 }
 
-/* Forward declarations for sem_check_stmt */
-static void sem_check_dclns(node *);
-static void sem_check_stmts(node *);
-
-static void sem_check_stmt(node *ast){
-	type_t type1, type2;
-	struct st_entry *ste;
+static void sem_check_stmt(compile_session_t *cs, node_t n, struct ast_stack *types){
+	struct ast_node *ast = AST_NODE(cs, n);
+	int type1, type2;
+	const struct st_entry *ste;
 
-	if(ast == NULL)	return;
-	assert(ast->kind & STATEMENT_NODE);	
+	if(n == AST_NIL)	return;
+	assert(AST_IS_STMT(ast->kind));	
 
 	switch(ast->kind){
 	  case ASSIGNMENT_NODE:
-		sem_check_expr(ast->assign_stmt.var, &type1);
-		sem_check_expr(ast->assign_stmt.new_val, &type2);
+		type2 = sem_pop_type(types);
+		type1 = sem_pop_type(types);
 
 		/* Can't reassign const variables */
-		ste = st_lookup(ast->assign_stmt.var->st, ast->assign_stmt.var->var.name, GLOBAL);
+		ste = AST_SYMBOL(cs, AST_NODE(cs, ast->assign_stmt.var)->var.sym);
 		if(ste == NULL){
-			printf("sem_check_stmt: Warning: st_lookup failed on variable %s.\n", ast->assign_stmt.var->var.name);
+			fprintf(cs->outputFile, "sem_check_stmt: Warning: st_lookup failed on variable %s.\n", ident_name(cs, AST_NODE(cs, ast->assign_stmt.var)->var.id));
 		}
 		else{
 			if(ste->is_cnst){
-				fprintf(errorFile, "SEMANTIC ERROR: Can't reassign const variables. Trying to reassign const variable %s.\n", ast->assign_stmt.var->var.name);
-                        	errorOccurred = TRUE;
+				fprintf(cs->errorFile, "SEMANTIC ERROR: Can't reassign const variables. Trying to reassign const variable %s.\n", ident_name(cs, AST_NODE(cs, ast->assign_stmt.var)->var.id));
+                        	cs->errorOccurred = TRUE;
 			}
 		}
 		
 		/* Type check */
-		if(!(type1 & type2)){
-			fprintf(errorFile, "SEMANTIC ERROR: Type mismatch - trying to assign variable %s of type %s with type %s.\n", 
-					ast->assign_stmt.var->var.name, type_strings[print_type_index(type1)], type_strings[print_type_index(type2)]);
-			errorOccurred = TRUE;
+		if(!(type_values[type1] & type_values[type2])){
+			fprintf(cs->errorFile, "SEMANTIC ERROR: Type mismatch - trying to assign variable %s of type %s with type %s.\n", 
+					ident_name(cs, AST_NODE(cs, ast->assign_stmt.var)->var.id), type_strings[type1], type_strings[type2]);
+			cs->errorOccurred = TRUE;
 		}
 
 		break;
 	  case IF_STATEMENT_NODE:
-		sem_check_expr(ast->if_stmt.expr, &type1);
-		sem_check_stmt(ast->if_stmt.stmt);
-		if(ast->if_stmt.opt_stmt != NULL)
-			sem_check_stmt(ast->if_stmt.opt_stmt);
+		/* The branches are checked by now, and leave no types */
+		type1 = sem_pop_type(types);
 
 		/* Type check */
-		if((type1 != BOOL) && (type1 != ANY)){
-			fprintf(errorFile, "SEMANTIC ERROR: Conditional expression for if statement is of type %s, needs to be of type bool.\n",
-					type_strings[print_type_index(type1)]);
-			errorOccurred = TRUE;
+		if((type1 != B1) && (type1 != AN)){
+			fprintf(cs->errorFile, "SEMANTIC ERROR: Conditional expression for if statement is of type %s, needs to be of type bool.\n",
+					type_strings[type1]);
+			cs->errorOccurred = TRUE;
 		}
 		
 		break;
 	  case SCOPE_NODE:
-		sem_check_dclns(ast->scope.declarations);
-        	sem_check_stmts(ast->scope.statements);
+		/* Back out to the enclosing scope's table */
+		cs->st_curr = AST_SCOPE(cs, n)->st->parent;
 		/* Do whatever semantic checks need to be done for a scope node */
 		break;
 	  default:
-		printf("sem_check_stmt: Unsupported statement kind.\n");
+		fprintf(cs->outputFile, "sem_check_stmt: Unsupported statement kind.\n");
 		break;
 	}
 }
 
-static void sem_check_stmts(node *ast){
+static void sem_check_dcln(compile_session_t *cs, node_t n, struct ast_stack *types){
+	struct ast_node *ast = AST_NODE(cs, n);
+	struct ast_node *init;
+	int type;
+	const struct st_entry *ste, *init_ste;
 
-	if(ast == NULL) return;
-        assert(ast->kind == STATEMENTS_NODE);
-
-        sem_check_stmts(ast->statements.statements);
-        sem_check_stmt(ast->statements.statement);
-
-        /* Do whatever semantic checks need to be done for a statements node */
-}
-
-static void sem_check_dcln(node *ast){
-	type_t type;
-	struct st_entry *ste;
-
-        assert(ast != NULL);
+        assert(n != AST_NIL);
 	assert(ast->kind == DECLARATION_NODE);
 
-	if(ast->declaration.init_val != NULL){
-        	sem_check_expr(ast->declaration.init_val, &type);
+	/* A name declared twice in a scope means its first declaration,
+	 * both here and where it is used */
+	ste = st_lookup(cs, cs->st_curr, AST_SYMBOL(cs, ast->declaration.sym)->id, LOCAL);
+	ast->declaration.sym = ste->sym;
+
+	if(ast->declaration.init_val != AST_NIL){
+        	type = sem_pop_type(types);
+		init = AST_NODE(cs, ast->declaration.init_val);
 	
 		/* 
 		 * Const declarations must be initialized with a literal or uniform variable. 
 		 * Note: Parser ensures that all const variables ARE initialized, so we just
 		 * need to check that they are initialized with the correct variable/type.
 		 */
-                ste = st_lookup(ast->st, ast->declaration.var_name, LOCAL);
-                if(ste == NULL){
-                        printf("sem_check_dcln: Warning: st_lookup failed on variable %s.\n", ast->declaration.var_name);
-                }
-                else{
-                        if(ste->is_cnst){
-                                if(!((ast->declaration.init_val->kind == INT_NODE) || (ast->declaration.init_val->kind == FLOAT_NODE) || (ast->declaration.init_val->kind == BOOL_NODE))){ /* It's not a literal */
-					/* Check if uniform? */
-					if(ast->declaration.init_val->kind == VAR_NODE){
-						if( !( !strcmp(ast->declaration.init_val->var.name, "gl_Light_Half")
-						     || !strcmp(ast->declaration.init_val->var.name, "gl_Light_Ambient")
-						     || !strcmp(ast->declaration.init_val->var.name, "gl_Material_Shininess")
-						     || !strcmp(ast->declaration.init_val->var.name, "env1")
-						     || !strcmp(ast->declaration.init_val->var.name, "env2")
-						     || !strcmp(ast->declaration.init_val->var.name, "env3")
-														 )){
-							fprintf(errorFile, "SEMANTIC ERROR: Must assign const variables with literals or uniform variables. " 
-							   "Trying to assign const variable %s with a non literal or non uniform variable.\n", ast->declaration.var_name);
-                                			errorOccurred = TRUE;
-						}
-					}
-					else{
-						fprintf(errorFile, "SEMANTIC ERROR: Must assign const variables with literals or uniform variables. " 
-							   "Trying to assign const variable %s with a non literal or non uniform variable.\n", ast->declaration.var_name);
-                                		errorOccurred = TRUE;
+                if(ste->is_cnst){
+                        if(!((init->kind == INT_NODE) || (init->kind == FLOAT_NODE) || (init->kind == BOOL_NODE))){ /* It's not a literal */
+				/* Check if uniform? */
+				if(init->kind == VAR_NODE){
+					init_ste = AST_SYMBOL(cs, init->var.sym);
+					if(init_ste == NULL || init_ste->var_class != UNIFORM_CLASS){
+						fprintf(cs->errorFile, "SEMANTIC ERROR: Must assign const variables with literals or uniform variables. " 
+						   "Trying to assign const variable %s with a non literal or non uniform variable.\n", ste->var_name);
+                        			cs->errorOccurred = TRUE;
 					}
 				}
-                        }
+				else{
+					fprintf(cs->errorFile, "SEMANTIC ERROR: Must assign const variables with literals or uniform variables. " 
+						   "Trying to assign const variable %s with a non literal or non uniform variable.\n", ste->var_name);
+                        		cs->errorOccurred = TRUE;
+				}
+				}
                 }
 
 		/* Type check */
-		if(!(ste->type & type)){
-			fprintf(errorFile, "SEMANTIC ERROR: Type mismatch - trying to assign variable %s of type %s with type %s.\n",
-                                        ast->declaration.var_name, type_strings[print_type_index(ste->type)], type_strings[print_type_index(type)]);
-                        errorOccurred = TRUE;
+		if(!(ste->type & type_values[type])){
+			fprintf(cs->errorFile, "SEMANTIC ERROR: Type mismatch - trying to assign variable %s of type %s with type %s.\n",
+                                        ste->var_name, type_strings[print_type_index(ste->type)], type_strings[type]);
+                        cs->errorOccurred = TRUE;
 		}
 	}
 }
 
-static void sem_check_dclns(node *ast){
-	
-	if(ast == NULL) return;
-	assert(ast->kind == DECLARATIONS_NODE);
+static int sem_check_pre(compile_session_t *cs, node_t n, void *arg){
+
+	/* Names are looked up from the scope's own table */
+	if(AST_NODE(cs, n)->kind == SCOPE_NODE)
+		cs->st_curr = AST_SCOPE(cs, n)->st;
+
+	return 1;
+}
 
-	sem_check_dclns(ast->declarations.declarations);
-	sem_check_dcln(ast->declarations.declaration);
+static int sem_check_child(compile_session_t *cs, node_t n, unsigned int i, void *arg){
+	struct ast_node *ast = AST_NODE(cs, n);
 
-	/* Do whatever semantic checks need to be done for a declarations node */
+	/* Only the first four arguments of a call are checked */
+	return !((ast->kind == FUNCTION_NODE || ast->kind == CONSTRUCTOR_NODE) && i >= 4);
+}
+
+static void sem_check_post(compile_session_t *cs, node_t n, void *arg){
+	struct ast_stack *types = (struct ast_stack *) arg;
+	struct ast_node *ast = AST_NODE(cs, n);
+	int type = AN;
+
+	if(AST_IS_EXPR(ast->kind)){
+		sem_check_expr(cs, n, types, &type);
+		sem_push_type(types, type);
+	}
+	else if(AST_IS_STMT(ast->kind))
+		sem_check_stmt(cs, n, types);
+	else sem_check_dcln(cs, n, types);
 }
 
-int semantic_check(node *ast) {
+int semantic_check(compile_session_t *cs, node_t ast) {
+	struct ast_stack types = { NULL, 0, 0 };
+	struct ast_visitor checker = { sem_check_pre, sem_check_child, sem_check_post, &types };
 	
-	assert(ast != NULL);
-	assert(ast->kind == SCOPE_NODE);
+	assert(ast != AST_NIL);
+	assert(AST_NODE(cs, ast)->kind == SCOPE_NODE);
 
 	/* Expecting a scope, which is a statement */
-	sem_check_stmt(ast);  
+	ast_walk(cs, ast, &checker);
+	ast_stack_free(&types);
 
 	return 0;
 }
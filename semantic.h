@@ -5,6 +5,6 @@
 #include "symbol.h"
 
 
-int semantic_check(node *ast);
+int semantic_check(compile_session_t *cs, node_t ast);
 
 #endif
@@ -0,0 +1,158 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * server.c
+ *
+ * Compile server. Requests are compiled in memory with cc467_compile(),
+ * so a request costs no process spawn, no file IO and no symbol table
+ * setup for the pre-defined variables.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include "server.h"
+#include "session.h"
+#include "cc467.h"
+
+/* Write out all of iov, picking up after any short write */
+static int server_writev_full(int fd, struct iovec *iov, int cnt) {
+  ssize_t n;
+
+  while (cnt > 0) {
+    n = writev(fd, iov, cnt);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    while (cnt > 0 && (size_t) n >= iov->iov_len) {
+      n -= iov->iov_len;
+      iov++;
+      cnt--;
+    }
+    if (cnt > 0) {
+      iov->iov_base = (char *) iov->iov_base + n;
+      iov->iov_len -= n;
+    }
+  }
+  return 0;
+}
+
+static void *server_conn_thread(void *arg) {
+  struct server_request request;
+  struct server_reply reply;
+  struct iovec iov[3];
+  cc467_options options;
+  cc467_result result;
+  char *source = NULL;
+  size_t sourceMax = 0;
+  int fd = (int) (intptr_t) arg;
+  int failed;
+
+  while (server_read_full(fd, &request, sizeof request) == 0) {
+    if (request.magic != SERVER_MAGIC || request.source_len > SERVER_MAX_SOURCE) {
+      memset(&reply, 0, sizeof reply);
+      reply.magic = SERVER_MAGIC;
+      reply.status = SERVE_BAD_REQUEST;
+      server_write_full(fd, &reply, sizeof reply);
+      break;
+    }
+
+    /* The source buffer is kept across requests on a connection */
+    if (request.source_len > sourceMax) {
+      sourceMax = request.source_len;
+      source = (char *) realloc(source, sourceMax);
+    }
+    if (server_read_full(fd, source, request.source_len))
+      break;
+
+    options.dumpSource   = (request.options & SERVE_DUMP_SOURCE) != 0;
+    options.dumpAST      = (request.options & SERVE_DUMP_AST) != 0;
+    options.traceScanner = (request.options & SERVE_TRACE_SCANNER) != 0;
+    options.traceParser  = (request.options & SERVE_TRACE_PARSER) != 0;
+
+    reply.magic = SERVER_MAGIC;
+    switch (cc467_compile(source, request.source_len, &options, &result)) {
+      case 0:  reply.status = SERVE_OK; break;
+      case 1:  reply.status = SERVE_FAILED; break;
+      default: reply.status = SERVE_BAD_REQUEST; break;
+    }
+    reply.arb_len = (uint32_t) result.arb_len;
+    reply.diag_len = (uint32_t) result.diagnostics_len;
+
+    iov[0].iov_base = &reply;
+    iov[0].iov_len = sizeof reply;
+    iov[1].iov_base = result.arb;
+    iov[1].iov_len = result.arb_len;
+    iov[2].iov_base = result.diagnostics;
+    iov[2].iov_len = result.diagnostics_len;
+    failed = server_writev_full(fd, iov, 3);
+
+    cc467_result_free(&result);
+    if (failed || reply.status == SERVE_BAD_REQUEST)
+      break;
+  }
+
+  free(source);
+  close(fd);
+  return NULL;
+}
+
+int server_run(compile_session_t *cs, const char *socketPath) {
+  struct sockaddr_un addr;
+  pthread_attr_t attr;
+  pthread_t thread;
+  int listenFd, fd;
+
+  if (strlen(socketPath) >= sizeof addr.sun_path) {
+    fprintf(cs->errorFile, "Socket path %s is too long\n", socketPath);
+    return 1;
+  }
+
+  /* A client that hangs up early must not take the server down */
+  signal(SIGPIPE, SIG_IGN);
+
+  memset(&addr, 0, sizeof addr);
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, socketPath);
+
+  if ((listenFd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+    perror("socket");
+    return 1;
+  }
+  unlink(socketPath);
+  if (bind(listenFd, (struct sockaddr *) &addr, sizeof addr) < 0 || listen(listenFd, 128) < 0) {
+    fprintf(cs->errorFile, "Unable to listen on %s: %s\n", socketPath, strerror(errno));
+    close(listenFd);
+    return 1;
+  }
+
+  fprintf(cs->outputFile, "Serving on %s\n", socketPath);
+  fflush(cs->outputFile);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+  for (;;) {
+    if ((fd = accept(listenFd, NULL, NULL)) < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      perror("accept");
+      break;
+    }
+
+    if (pthread_create(&thread, &attr, server_conn_thread, (void *) (intptr_t) fd))
+      close(fd);
+  }
+
+  pthread_attr_destroy(&attr);
+  close(listenFd);
+  unlink(socketPath);
+  return 1;
+}
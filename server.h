@@ -0,0 +1,102 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * server.h
+ *
+ * Compile server: a long-running compiler467 that accepts compile
+ * requests over a Unix domain socket, and the wire protocol shared with
+ * the cc467client program.
+ *
+ * A connection carries any number of requests, one after the other:
+ *
+ *   client: struct server_request, then source_len bytes of source
+ *   server: struct server_reply, then arb_len bytes of ARB program,
+ *           then diag_len bytes of diagnostics (errors, dumps, traces)
+ *
+ * All fields are in host byte order.
+ **********************************************************************/
+
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define SERVER_MAGIC          0x43343637u /* "C467" */
+#define SERVER_DEFAULT_SOCKET "/tmp/compiler467.sock"
+#define SERVER_MAX_SOURCE     (64u << 20)
+
+/* Option bits of a request, the -D and -T flags of the command line */
+enum {
+  SERVE_DUMP_SOURCE   = (1 << 0),
+  SERVE_DUMP_AST      = (1 << 1),
+  SERVE_TRACE_SCANNER = (1 << 2),
+  SERVE_TRACE_PARSER  = (1 << 3)
+};
+
+/* Reply status */
+enum {
+  SERVE_OK = 0,         /* compiled without errors */
+  SERVE_FAILED,         /* compile errors, see the diagnostics */
+  SERVE_BAD_REQUEST     /* malformed request; the server hangs up */
+};
+
+struct server_request {
+  uint32_t magic;
+  uint32_t options;
+  uint32_t source_len;
+};
+
+struct server_reply {
+  uint32_t magic;
+  uint32_t status;
+  uint32_t arb_len;
+  uint32_t diag_len;
+};
+
+/* Read exactly len bytes. Returns 0 on success. */
+static inline int server_read_full(int fd, void *buf, size_t len) {
+  char *p = (char *) buf;
+  ssize_t n;
+
+  while (len > 0) {
+    n = read(fd, p, len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+/* Write exactly len bytes. Returns 0 on success. */
+static inline int server_write_full(int fd, const void *buf, size_t len) {
+  const char *p = (const char *) buf;
+  ssize_t n;
+
+  while (len > 0) {
+    n = write(fd, p, len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+/*
+ * Serve compile requests on socketPath until killed. Each connection is
+ * handled by its own thread; cs supplies the files for the server's own
+ * messages. Returns nonzero if the socket can't be set up.
+ */
+int server_run(compile_session_t *cs, const char *socketPath);
+
+#endif /* _SERVER_H_ */
@@ -0,0 +1,343 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * session.c
+ *
+ * CSC467 Project Compiler Session State
+ *
+ * This file contains the setup and teardown of a compile session, the
+ * object that replaces the global variables that were previously used
+ * for communication among the various compiler modules.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "session.h"
+#include "semantic.h"
+
+/* Scanner and parser interface */
+extern int  yyparse(compile_session_t *cs);
+extern void scanner_restart(compile_session_t *cs);
+extern void scanner_free(compile_session_t *cs);
+
+void session_init(compile_session_t *cs){
+  memset(cs, 0, sizeof *cs);
+
+  /* FILE defaults */
+  cs->inputFile         = DEFAULT_INPUT_FILE;
+  cs->outputFile        = DEFAULT_OUTPUT_FILE;
+  cs->errorFile         = DEFAULT_ERROR_FILE;
+  cs->dumpFile          = DEFAULT_DUMP_FILE;
+  cs->traceFile         = DEFAULT_TRACE_FILE;
+  cs->runInputFile      = DEFAULT_RUN_INPUT_FILE;
+  cs->assemblyFile      = DEFAULT_ASSEMBLY_FILE;
+  cs->assemblyFileName  = "frag.txt";
+  cs->cacheDir          = NULL;
+  cs->cacheMaxSize      = 0;
+
+  /* Control flags */
+  cs->errorOccurred     = FALSE;
+  cs->suppressExecution = FALSE;
+
+  cs->traceScanner      = FALSE;
+  cs->traceParser       = FALSE;
+  cs->traceExecution    = FALSE;
+  cs->traceStats        = FALSE;
+
+  cs->dumpSource        = FALSE;
+  cs->dumpAST           = FALSE;
+  cs->dumpSymbols       = FALSE;
+  cs->dumpInstructions  = FALSE;
+
+  /* Scanner/Parser state */
+  cs->yyline            = 1;
+  cs->st_curr           = NULL;
+}
+
+void session_copy_options(compile_session_t *dst, const compile_session_t *src){
+  dst->suppressExecution = src->suppressExecution;
+
+  dst->traceScanner      = src->traceScanner;
+  dst->traceParser       = src->traceParser;
+  dst->traceExecution    = src->traceExecution;
+  dst->traceStats        = src->traceStats;
+
+  dst->dumpSource        = src->dumpSource;
+  dst->dumpAST           = src->dumpAST;
+  dst->dumpSymbols       = src->dumpSymbols;
+  dst->dumpInstructions  = src->dumpInstructions;
+
+  dst->cacheDir          = src->cacheDir;
+  dst->cacheMaxSize      = src->cacheMaxSize;
+}
+
+void session_close(compile_session_t *cs){
+  if (cs->inputFile != DEFAULT_INPUT_FILE)
+    fclose (cs->inputFile);
+  if (cs->errorFile != DEFAULT_ERROR_FILE)
+    fclose (cs->errorFile);
+  if (cs->dumpFile != DEFAULT_DUMP_FILE)
+    fclose (cs->dumpFile);
+  if (cs->traceFile != DEFAULT_TRACE_FILE)
+    fclose (cs->traceFile);
+  if (cs->outputFile != DEFAULT_OUTPUT_FILE)
+    fclose (cs->outputFile);
+  if (cs->runInputFile != DEFAULT_RUN_INPUT_FILE)
+    fclose (cs->runInputFile);
+  if (cs->assemblyFile != DEFAULT_ASSEMBLY_FILE)
+    fclose (cs->assemblyFile);
+  session_free_source(cs);
+  session_free_program(cs);
+}
+
+/***********************************************************************
+ * Source text
+ *
+ * The scanner scans the source in place, which needs it to end in two
+ * NULs. A regular file is mapped over an anonymous mapping two bytes
+ * longer than it, so the NULs come from the zero fill; the mapping is
+ * private because flex writes into the buffer as it goes.
+ **********************************************************************/
+static int map_source(compile_session_t *cs, int fd, size_t len) {
+  size_t mapLen = len + 2;
+  char *base;
+
+  base = (char *) mmap(NULL, mapLen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED)
+    return -1;
+  if (len > 0 &&
+      mmap(base, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+    munmap(base, mapLen);
+    return -1;
+  }
+
+  cs->source = base;
+  cs->sourceLen = len;
+  cs->sourceMapLen = mapLen;
+  return 0;
+}
+
+int session_read_source(compile_session_t *cs) {
+  struct stat st;
+  size_t cap, n;
+  int fd;
+
+  session_free_source(cs);
+
+  fd = fileno(cs->inputFile);
+  if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+      lseek(fd, 0, SEEK_CUR) == 0 &&
+      map_source(cs, fd, (size_t) st.st_size) == 0)
+    return 0;
+
+  /* Not a plain file: read it all in */
+  cap = 4096;
+  cs->source = (char *) malloc(cap);
+  cs->sourceLen = 0;
+  while ((n = fread(cs->source + cs->sourceLen, 1, cap - cs->sourceLen - 2, cs->inputFile)) > 0) {
+    cs->sourceLen += n;
+    if (cs->sourceLen + 2 == cap) {
+      cap *= 2;
+      cs->source = (char *) realloc(cs->source, cap);
+    }
+  }
+  cs->source[cs->sourceLen] = cs->source[cs->sourceLen + 1] = '\0';
+
+  if (ferror(cs->inputFile)) {
+    fprintf(cs->errorFile, "Unable to read the source\n");
+    return 1;
+  }
+  return 0;
+}
+
+void session_set_source(compile_session_t *cs, const char *text, size_t len) {
+  session_free_source(cs);
+
+  cs->source = (char *) malloc(len + 2);
+  memcpy(cs->source, text, len);
+  cs->source[len] = cs->source[len + 1] = '\0';
+  cs->sourceLen = len;
+}
+
+void session_free_source(compile_session_t *cs) {
+  if (cs->sourceMapLen)
+    munmap(cs->source, cs->sourceMapLen);
+  else
+    free(cs->source);
+  cs->source = NULL;
+  cs->sourceLen = 0;
+  cs->sourceMapLen = 0;
+}
+
+/* Drop the AST, names and symbol tables of the compile in one go */
+static void session_release(compile_session_t *cs){
+  cs->stats.astBytes = cs->ast.num_nodes * (sizeof(struct ast_node) + sizeof(unsigned short)) +
+                       cs->ast.num_items * sizeof(node_t) + cs->ast.num_scopes * sizeof(struct ast_scope);
+  cs->stats.arenaBytes = cs->arena.used;
+  ast_free(cs);
+  cs->st_curr = NULL;
+  intern_reset(cs);
+  arena_release(&cs->arena);
+}
+
+int session_compile(compile_session_t *cs){
+  int parsed;
+
+  cs->errorOccurred = FALSE;
+  cs->code.len = 0;
+  stats_start(cs);
+
+  if (cs->source == NULL && session_read_source(cs))
+    return 1;
+
+  if (cs->dumpSource)
+    sourceDump(cs);
+
+  /* Parser -- allocates the AST, storing the reference in the session's
+   * "ast", and builds the AST there. The scanner and parser keep all
+   * their state in the session, so sessions are parsed concurrently. */
+  stats_phase(cs, PHASE_PARSE);
+  scanner_restart(cs);
+  parsed = (yyparse(cs) == 0);
+  scanner_free(cs);
+  stats_phase(cs, PHASE_OTHER);
+
+  if (!parsed) {
+    session_release(cs);
+    stats_report(cs);
+    return 1;
+  }
+
+  stats_phase(cs, PHASE_SEMANTIC);
+  semantic_check(cs, cs->ast.root);
+  stats_phase(cs, PHASE_OTHER);
+
+  if (cs->dumpAST)
+    ast_print(cs, cs->ast.root);
+
+  stats_phase(cs, PHASE_CODEGEN);
+  genCode(cs, cs->ast.root);
+  session_write_program(cs);
+  stats_phase(cs, PHASE_OTHER);
+
+  session_release(cs);
+  stats_report(cs);
+
+  return cs->errorOccurred ? 1 : 0;
+}
+
+/***********************************************************************
+ * Generated program
+ *
+ * A named assembly file is replaced atomically: the program goes to a
+ * temporary file next to it in one write(), which is then renamed over
+ * it, so a reader never sees half a program.
+ **********************************************************************/
+static int write_all(int fd, const char *text, size_t len) {
+  ssize_t n;
+
+  while (len > 0) {
+    if ((n = write(fd, text, len)) < 0)
+      return 1;
+    text += n;
+    len -= n;
+  }
+  return 0;
+}
+
+int session_write_program(compile_session_t *cs) {
+  char *tmpName;
+  int fd, failed;
+
+  if (cs->assemblyFileName == NULL) {
+    if (cs->assemblyFile == NULL)
+      return 0;
+    return fwrite(cs->code.text, 1, cs->code.len, cs->assemblyFile) != cs->code.len;
+  }
+
+  tmpName = (char *) malloc(strlen(cs->assemblyFileName) + 8);
+  sprintf(tmpName, "%s.XXXXXX", cs->assemblyFileName);
+  if ((fd = mkstemp(tmpName)) < 0) {
+    fprintf(cs->errorFile, "Unable to open file %s\n", cs->assemblyFileName);
+    free(tmpName);
+    return 1;
+  }
+
+  failed = fchmod(fd, 0644) < 0 || write_all(fd, cs->code.text, cs->code.len);
+  failed |= close(fd) < 0;
+  if (!failed)
+    failed = rename(tmpName, cs->assemblyFileName) < 0;
+  if (failed) {
+    fprintf(cs->errorFile, "Unable to write file %s\n", cs->assemblyFileName);
+    unlink(tmpName);
+  }
+
+  free(tmpName);
+  return failed;
+}
+
+void session_free_program(compile_session_t *cs) {
+  free(cs->code.text);
+  cs->code.text = NULL;
+  cs->code.len = 0;
+  cs->code.size = 0;
+}
+
+/***********************************************************************
+ * Utility for opening files 
+ **********************************************************************/
+FILE *fileOpen (compile_session_t *cs, const char *fileName, const char *fileMode, FILE *defaultFile) {
+  FILE * fTemp;
+
+  if ((fTemp = fopen (fileName, fileMode)) != NULL)
+    return fTemp;
+  else {
+    fprintf (cs->errorFile, "Unable to open file %s\n", fileName);
+    return defaultFile;
+  }
+}
+
+/***********************************************************************
+ * Dump source file, with line numbers.
+ **********************************************************************/
+void sourceDump (compile_session_t *cs) {
+  const char *p = cs->source, *end = cs->source + cs->sourceLen, *eol;
+  int i = 0;
+
+  while (p < end) {
+    i += 1;
+    if ((eol = (const char *) memchr(p, '\n', end - p)) == NULL)
+      eol = end - 1;
+    fprintf(cs->dumpFile, "%3d: ", i);
+    fwrite(p, 1, eol + 1 - p, cs->dumpFile);
+    p = eol + 1;
+  }
+}
+
+/***********************************************************************
+ * Quote a source line under a diagnostic. During scanning flex keeps a
+ * NUL just past the current token, so the quote ends there.
+ **********************************************************************/
+void sourceQuote (compile_session_t *cs, int line) {
+  const char *p = cs->source, *end = cs->source + cs->sourceLen, *eol;
+  int i;
+
+  if (p == NULL)
+    return;
+  for (i = 1; i < line && p < end; i++) {
+    if ((p = (const char *) memchr(p, '\n', end - p)) == NULL)
+      return;
+    p++;
+  }
+  if (p >= end)
+    return;
+
+  for (eol = p; eol < end && *eol != '\n' && *eol != '\0'; eol++)
+    ;
+  fprintf(cs->errorFile, "%3d: %.*s\n", line, (int) (eol - p), p);
+}
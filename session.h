@@ -0,0 +1,143 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * session.h
+ *
+ * A compile session owns every piece of state needed to compile one
+ * source program: IO files, control flags, and the working state of the
+ * scanner, parser, AST printer, semantic checker and code generator.
+ * Every compiler phase takes the session it is working on, so separate
+ * sessions never share mutable state.
+ **********************************************************************/
+
+#ifndef _SESSION_H_
+#define _SESSION_H_
+
+#include <stdio.h>
+
+#include "common.h"
+#include "ast.h"
+#include "symbol.h"
+#include "codegen.h"
+#include "stats.h"
+#include "arena.h"
+
+/***********************************************************************
+ * Default values for various files. Note assumption that default files
+ * are not closed at the end of compilation.
+ **********************************************************************/
+#define DEFAULT_INPUT_FILE     stdin
+#define DEFAULT_OUTPUT_FILE    stdout
+#define DEFAULT_ERROR_FILE     stderr
+#define DEFAULT_DUMP_FILE      stdout
+#define DEFAULT_TRACE_FILE     stdout
+#define DEFAULT_RUN_INPUT_FILE stdin
+#define DEFAULT_ASSEMBLY_FILE  stdout
+
+struct compile_session {
+  /* Sinks for compiler output and sources for compiler input. */
+  FILE *inputFile;
+  FILE *outputFile;
+  FILE *errorFile;
+  FILE *dumpFile;
+  FILE *traceFile;
+  FILE *runInputFile;
+  FILE *assemblyFile;
+
+  /* File the ARB program is written to, replaced as a whole once the
+   * source parses. NULL writes it to assemblyFile instead, or nowhere if
+   * that is NULL too. */
+  const char *assemblyFileName;
+
+  /* Compile cache directory (NULL for none) and its size limit in bytes,
+   * see cache.h */
+  const char *cacheDir;
+  long cacheMaxSize;
+
+  /* Control flags, used to cause various optional compiler actions. */
+  int errorOccurred;
+  int suppressExecution;
+
+  int traceScanner;
+  int traceParser;
+  int traceExecution;
+  int traceStats;       /* STATS_TEXT and/or STATS_JSON */
+
+  int dumpSource;
+  int dumpAST;
+  int dumpSymbols;
+  int dumpInstructions;
+
+  /* Source text, mapped or read in once and shared by the scanner, the
+   * source dump and diagnostics. It ends in the two NULs flex needs to
+   * scan it in place. */
+  char *source;
+  size_t sourceLen;
+  size_t sourceMapLen;  /* length of the mapping, 0 if malloc'd */
+
+  /* Scanner/Parser state */
+  void *scanner;        /* the scanner's own state, see scanner_restart() */
+  int yyline;
+  struct interner idents;
+  struct ast_tree ast;
+  symbol_table_t *st_curr;  /* while parsing, and the scope a pass is in */
+
+  /* The interned names and the symbol tables, all released together at
+   * the end of session_compile() */
+  struct arena arena;
+
+  /* The program the code generator generates */
+  struct code_buffer code;
+
+  /* Phase timing and counters */
+  struct compile_stats stats;
+};
+
+/* Reset a session to the default files and flags */
+void session_init(compile_session_t *cs);
+
+/* Copy the control flags (not the files or working state) of src */
+void session_copy_options(compile_session_t *dst, const compile_session_t *src);
+
+/* Close any non-default files the session has opened */
+void session_close(compile_session_t *cs);
+
+/*
+ * Load the source from inputFile: regular files are mmap'd, anything
+ * else (stdin, pipes, memory streams) is read in. Returns 0 on success.
+ */
+int session_read_source(compile_session_t *cs);
+
+/* Use a copy of the len bytes at text as the source */
+void session_set_source(compile_session_t *cs, const char *text, size_t len);
+
+/* Release the source */
+void session_free_source(compile_session_t *cs);
+
+/*
+ * Write the generated program to assemblyFileName or assemblyFile, in a
+ * single write. Returns 0 on success.
+ */
+int session_write_program(compile_session_t *cs);
+
+/* Release the generated program */
+void session_free_program(compile_session_t *cs);
+
+/*
+ * Run every phase of the compiler over the session's source, reading it
+ * from inputFile first if it isn't loaded yet. Returns 0
+ * if the program compiled without errors. Safe to call concurrently on
+ * different sessions.
+ */
+int session_compile(compile_session_t *cs);
+
+/* Utility for opening files, reporting failure to the session */
+FILE *fileOpen(compile_session_t *cs, const char *fileName, const char *fileMode, FILE *defaultFile);
+
+/* Dump source file, with line numbers. */
+void sourceDump(compile_session_t *cs);
+
+/* Quote the given source line under a diagnostic */
+void sourceQuote(compile_session_t *cs, int line);
+
+#endif /* _SESSION_H_ */
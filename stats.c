@@ -0,0 +1,131 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * stats.c
+ *
+ * Per-phase timing and counters of a compile, see stats.h.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "stats.h"
+#include "session.h"
+
+static const char *phase_names[NUM_PHASES] = {
+  "scan",
+  "parse",
+  "semantic",
+  "codegen",
+  "other"
+};
+
+double stats_now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void stats_start(compile_session_t *cs) {
+  struct compile_stats *s = &cs->stats;
+
+  memset(s, 0, sizeof *s);
+  s->phase = PHASE_OTHER;
+  if (cs->traceStats)
+    s->start = s->mark = stats_now();
+}
+
+void stats_phase(compile_session_t *cs, phase_t phase) {
+  struct compile_stats *s = &cs->stats;
+  double now;
+
+  if (cs->traceStats) {
+    now = stats_now();
+    s->time[s->phase] += now - s->mark;
+    s->mark = now;
+  }
+  s->phase = phase;
+}
+
+static void report_text(compile_session_t *cs) {
+  struct compile_stats *s = &cs->stats;
+  FILE *out = cs->traceFile;
+  const char *sep;
+  int i;
+
+  fprintf(out, "Phase        Time (ms)  Counters\n");
+  for (i = 0; i < NUM_PHASES; i++) {
+    fprintf(out, "%-10s %11.3f", phase_names[i], s->time[i] * 1e3);
+    sep = "  ";
+    switch (i) {
+      case PHASE_SCAN:
+        fprintf(out, "%stokens %ld", sep, s->tokens);
+        sep = ", ";
+        break;
+      case PHASE_PARSE:
+        fprintf(out, "%snodes %ld, AST bytes %ld, arena bytes %ld", sep, s->nodes, s->astBytes, s->arenaBytes);
+        sep = ", ";
+        break;
+      case PHASE_CODEGEN:
+        fprintf(out, "%sinstructions %ld, temps %ld, peak live temps %ld",
+                sep, s->instructions, s->temps, s->peakTemps);
+        sep = ", ";
+        break;
+      default:
+        break;
+    }
+    if (s->lookups[i])
+      fprintf(out, "%slookups %ld, compares %ld", sep, s->lookups[i], s->compares[i]);
+    fprintf(out, "\n");
+  }
+  fprintf(out, "%-10s %11.3f\n", "total", s->total * 1e3);
+}
+
+static void report_json(compile_session_t *cs) {
+  struct compile_stats *s = &cs->stats;
+  FILE *out = cs->traceFile;
+  int i;
+
+  fprintf(out, "{");
+  for (i = 0; i < NUM_PHASES; i++) {
+    fprintf(out, "\"%s\": {\"ms\": %.3f", phase_names[i], s->time[i] * 1e3);
+    switch (i) {
+      case PHASE_SCAN:
+        fprintf(out, ", \"tokens\": %ld", s->tokens);
+        break;
+      case PHASE_PARSE:
+        fprintf(out, ", \"nodes\": %ld, \"ast_bytes\": %ld, \"arena_bytes\": %ld",
+                s->nodes, s->astBytes, s->arenaBytes);
+        break;
+      case PHASE_CODEGEN:
+        fprintf(out, ", \"instructions\": %ld, \"temps\": %ld, \"peak_live_temps\": %ld",
+                s->instructions, s->temps, s->peakTemps);
+        break;
+      default:
+        break;
+    }
+    fprintf(out, ", \"lookups\": %ld, \"compares\": %ld}, ", s->lookups[i], s->compares[i]);
+  }
+  fprintf(out, "\"total_ms\": %.3f, \"errors\": %s}\n", s->total * 1e3,
+          cs->errorOccurred ? "true" : "false");
+}
+
+void stats_report(compile_session_t *cs) {
+  struct compile_stats *s = &cs->stats;
+
+  if (!cs->traceStats)
+    return;
+
+  stats_phase(cs, PHASE_OTHER);
+  s->total = s->mark - s->start;
+
+  /* Scanning happened inside parsing */
+  s->time[PHASE_PARSE] -= s->time[PHASE_SCAN];
+
+  if (cs->traceStats & STATS_TEXT)
+    report_text(cs);
+  if (cs->traceStats & STATS_JSON)
+    report_json(cs);
+}
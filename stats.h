@@ -0,0 +1,67 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * stats.h
+ *
+ * Per-phase timing and counters of a compile, reported with -Ts (text)
+ * or -Tj (JSON) to the trace file. The counters are always kept; the
+ * clock is only read when a report was asked for.
+ **********************************************************************/
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <stdio.h>
+
+#include "common.h"
+
+/* Compiler phases. Scanning is timed inside parsing and reported apart
+ * from it; "other" is the source and AST dumps. */
+typedef enum {
+  PHASE_SCAN = 0,
+  PHASE_PARSE,
+  PHASE_SEMANTIC,
+  PHASE_CODEGEN,
+  PHASE_OTHER,
+  NUM_PHASES
+} phase_t;
+
+/* -T trace report formats */
+enum {
+  STATS_TEXT = (1 << 0),
+  STATS_JSON = (1 << 1)
+};
+
+struct compile_stats {
+  phase_t phase;                  /* phase being run */
+  double  start;                  /* when the compile started */
+  double  mark;                   /* when the phase started */
+  double  time[NUM_PHASES];       /* seconds */
+  double  total;
+
+  long    tokens;                 /* tokens returned by the scanner */
+  long    nodes;                  /* nodes made by ast_allocate() */
+  long    astBytes;               /* nodes, types and lists of the AST */
+  long    arenaBytes;             /* bytes taken from the session's arena */
+  long    lookups[NUM_PHASES];    /* st_lookup() calls */
+  long    compares[NUM_PHASES];   /* names compared by st_lookup() */
+  long    instructions;           /* ARB instructions emitted */
+  long    temps;                  /* get_tempreg() requests */
+  long    liveTemps;              /* temps currently handed out */
+  long    peakTemps;              /* most temps live at once */
+};
+
+/* Monotonic clock, in seconds */
+double stats_now(void);
+
+/* Clear the counters and start timing the compile */
+void stats_start(compile_session_t *cs);
+
+/* Switch to another phase, charging the time since the last switch to
+ * the one being left */
+void stats_phase(compile_session_t *cs, phase_t phase);
+
+/* Stop timing and write the report(s) asked for to the trace file */
+void stats_report(compile_session_t *cs);
+
+#endif /* _STATS_H_ */
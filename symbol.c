@@ -4,49 +4,164 @@
 
 #include "common.h"
 #include "symbol.h"
+#include "session.h"
 
-symbol_table_t *st_new(){
+/* Where a search for id starts. IDs are handed out in order, and
+ * multiplying by an odd number keeps a run of them apart. */
+#define ST_HASH(id) ((unsigned int) (id) * 2654435761u)
+
+symbol_table_t *st_new(compile_session_t *cs){
 	symbol_table_t *st;
 
-        st = (symbol_table_t *) malloc(sizeof(struct symbol_table));
-        if(st == NULL) return NULL;
+        st = (symbol_table_t *) arena_alloc(&cs->arena, sizeof(struct symbol_table));
 
-	st->parent = st_curr;
-        memset(st->entries, 0, MAX_ST_ENTRIES * sizeof(struct st_entry));
+	st->parent = cs->st_curr;
+	st->slots = NULL;
+	st->num_slots = 0;
         st->num_entries = 0;
 
 	return st;
 }
 
-void st_insert(char *var_name, type_t type, int is_cnst){
-	/* Make sure var_name doesn't already exist */
-	if(st_lookup(st_curr, var_name, LOCAL)){
-		fprintf(errorFile, "SEMANTIC ERROR: Variable %s declared more than once in the current scope.\n", var_name);
-		errorOccurred = TRUE;
-	}
+/* Outgrown slots stay in the arena until it is released, like the
+ * interner's */
+static void st_grow(compile_session_t *cs, symbol_table_t *st){
+	struct st_entry **old = st->slots;
+	unsigned int num_old = st->num_slots;
+	unsigned int i, j;
+
+	st->num_slots = num_old ? 2 * num_old : 8;
+	st->slots = (struct st_entry **) arena_alloc(&cs->arena, st->num_slots * sizeof(struct st_entry *));
+	memset(st->slots, 0, st->num_slots * sizeof(struct st_entry *));
 
-	st_curr->entries[st_curr->num_entries].var_name = strdup(var_name);
-	st_curr->entries[st_curr->num_entries].type = type;
-	st_curr->entries[st_curr->num_entries].is_cnst = is_cnst;
-	st_curr->num_entries++;
-	if(st_curr->num_entries >= MAX_ST_ENTRIES){
-		/* TODO: Deal with this properly? */
-		printf("st_insert: Warning: symbol table full\n");
+	for(i = 0; i < num_old; i++){
+		if(old[i] == NULL)
+			continue;
+		j = ST_HASH(old[i]->id) & (st->num_slots - 1);
+		while(st->slots[j])
+			j = (j + 1) & (st->num_slots - 1);
+		st->slots[j] = old[i];
 	}
 }
 
-struct st_entry *st_lookup(symbol_table_t *st, char *var_name, scope_t scope){
+/* pre-defined variables, in the order of their IDs. Each is symbol
+ * number ID + 1 in every compile, see AST_SYMBOL(). */
+static const struct st_entry builtin_entries[NUM_BUILTIN_VARS] = {
+		//result class variables
+		{ "gl_FragColor", 0, VEC4, FALSE, RESULT_CLASS, "result.color", 1 },
+		{ "gl_FragDepth", 1, BOOL, FALSE, RESULT_CLASS, "result.depth", 2 },
+		{ "gl_FragCoord", 2, VEC4, FALSE, RESULT_CLASS, "fragment.position", 3 },
+
+		//attribute class variables
+		{ "gl_TexCoord", 3, VEC4, FALSE, ATTRIBUTE_CLASS, "fragment.texcoord", 4 },
+		{ "gl_Color", 4, VEC4, FALSE, ATTRIBUTE_CLASS, "fragment.color", 5 },
+		{ "gl_Secondary", 5, VEC4, FALSE, ATTRIBUTE_CLASS, "fragment.color.secondary", 6 },
+		{ "gl_FogFragCoord", 6, VEC4, FALSE, ATTRIBUTE_CLASS, "fragment.fogcoord", 7 },
+
+		//uniform class variables
+		{ "gl_Light_Half", 7, VEC4, TRUE, UNIFORM_CLASS, "state.light[0].half", 8 },
+		{ "gl_Light_Ambient", 8, VEC4, TRUE, UNIFORM_CLASS, "state.lightmodel.ambient", 9 },
+		{ "gl_Material_Shininess", 9, VEC4, TRUE, UNIFORM_CLASS, "state.material.shininess", 10 },
+		{ "env1", 10, VEC4, TRUE, UNIFORM_CLASS, "program.env[1]", 11 },
+		{ "env2", 11, VEC4, TRUE, UNIFORM_CLASS, "program.env[2]", 12 },
+		{ "env3", 12, VEC4, TRUE, UNIFORM_CLASS, "program.env[3]", 13 }
+};
+
+/*
+ * Perfect hash of the pre-defined names: (length + 4th char + last char)
+ * mod 32 is different for each of them. builtin_slots maps it to the
+ * index in builtin_entries, -1 for none. Recheck both when adding a name.
+ */
+#define BUILTIN_SLOTS 32
+#define BUILTIN_MIN_LEN 4
+#define BUILTIN_MAX_LEN 21
+
+static const signed char builtin_slots[BUILTIN_SLOTS] = {
+	-1, -1, -1,  3,  0, -1, 10, -1,	/* gl_TexCoord, gl_FragColor, env1 */
+	11, -1, 12, -1, -1, -1, -1, -1,	/* env2, env3 */
+	 8, -1, -1, -1, -1,  9,  2, -1,	/* gl_Light_Ambient, gl_Material_Shininess, gl_FragCoord */
+	 5,  6,  1, -1, -1,  4, -1,  7	/* gl_Secondary, gl_FogFragCoord, gl_FragDepth, gl_Color, gl_Light_Half */
+};
+
+int st_builtin_index(const char *name, size_t len){
 	int i;
 
+	if(len < BUILTIN_MIN_LEN || len > BUILTIN_MAX_LEN)
+		return -1;
+
+	i = builtin_slots[(len + (unsigned char) name[3] + (unsigned char) name[len - 1]) % BUILTIN_SLOTS];
+	if(i < 0 || strncmp(builtin_entries[i].var_name, name, len) || builtin_entries[i].var_name[len])
+		return -1;
+	return i;
+}
+
+const struct st_entry *st_builtin(ident_t id){
+	if(id < 0 || id >= NUM_BUILTIN_VARS)
+		return NULL;
+	return &builtin_entries[id];
+}
+
+struct st_entry *st_insert(compile_session_t *cs, ident_t id, type_t type, int is_cnst){
+	symbol_table_t *st = cs->st_curr;
+	struct st_entry *ste;
+	int again;
+	unsigned int i;
+
+	/* Make sure id doesn't already exist. The outermost scope also
+	 * shares its names with the pre-defined variables. */
+	again = st_lookup(cs, st, id, LOCAL) != NULL;
+	if(again || (st->parent == NULL && st_lookup(cs, NULL, id, LOCAL))){
+		fprintf(cs->errorFile, "SEMANTIC ERROR: Variable %s declared more than once in the current scope.\n", ident_name(cs, id));
+		cs->errorOccurred = TRUE;
+	}
+
+	ste = (struct st_entry *) arena_alloc(&cs->arena, sizeof(struct st_entry));
+	ste->var_name = ident_name(cs, id);
+	ste->id = id;
+	ste->type = type;
+	ste->is_cnst = is_cnst;
+	ste->var_class = NOT_BUILTIN;
+	/* Declared variables keep their own names in ARB */
+	ste->binding = ste->var_name;
+	ste->sym = 0;
+
+	/* A second declaration gets its own entry, but lookups find the
+	 * first */
+	if(!again){
+		if(2 * (st->num_entries + 1) > st->num_slots)
+			st_grow(cs, st);
+		i = ST_HASH(id) & (st->num_slots - 1);
+		while(st->slots[i])
+			i = (i + 1) & (st->num_slots - 1);
+		st->slots[i] = ste;
+		st->num_entries++;
+	}
+
+	return ste;
+}
+
+const struct st_entry *st_lookup(compile_session_t *cs, symbol_table_t *st, ident_t id, scope_t scope){
+	const struct st_entry *ste;
+	unsigned int i;
+
+	cs->stats.lookups[cs->stats.phase]++;
+
 	while(st != NULL){
-		for(i = 0; i < st->num_entries; i++){
-			if(!strcmp(st->entries[i].var_name, var_name))
-				return &st->entries[i];
-		}	
+		if(st->num_slots){
+			i = ST_HASH(id) & (st->num_slots - 1);
+			while((ste = st->slots[i]) != NULL){
+				cs->stats.compares[cs->stats.phase]++;
+				if(ste->id == id)
+					return ste;
+				i = (i + 1) & (st->num_slots - 1);
+			}
+		}
 		/* For local scope, don't search any of the symbol table's parents */
-		if(scope == LOCAL) break;
+		if(scope == LOCAL) return NULL;
 		st = st->parent;
 	}
 
-	return NULL;
+	/* The pre-defined variables are always searched last */
+	cs->stats.compares[cs->stats.phase]++;
+	return st_builtin(id);
 }
@@ -1,32 +1,71 @@
 #ifndef _SYMBOL_H
 #define _SYMBOL_H
 
+#include <stddef.h>
+
 #include "common.h"
+#include "intern.h"
 
-#define MAX_ST_ENTRIES 50 /* This is probably enough? */
+/* Class of a pre-defined variable */
+typedef enum {
+	NOT_BUILTIN = 0,
+	RESULT_CLASS,
+	ATTRIBUTE_CLASS,
+	UNIFORM_CLASS
+} var_class_t;
 
 struct st_entry{
-	char *var_name;
+	const char *var_name;	/* interned, see ident_name() */
+	ident_t id;
 	type_t type;
 	int is_cnst;
+	var_class_t var_class;	/* NOT_BUILTIN for declared variables */
+	const char *binding;	/* ARB name: the binding of a pre-defined variable,
+				 * a declared variable's own name */
+	unsigned int sym;	/* number in the compile's symbols, see AST_SYMBOL() */
 };
 
+/*
+ * A scope's variables, hashed on their IDs with open addressing. The
+ * slots are allocated in the session's arena and doubled whenever they
+ * are half full, so a scope can declare any number of variables.
+ */
 struct symbol_table{
 	struct symbol_table *parent;
-	struct st_entry entries[MAX_ST_ENTRIES];
-	int num_entries;
+	struct st_entry **slots;	/* NULL for an empty slot */
+	unsigned int num_slots;		/* a power of two, 0 until the first insert */
+	unsigned int num_entries;
 };
 
 /* 
  * Attach a new symbol table to our "cactus" of symbol tables: 
- *	To be called at beginning of scope.
+ *	To be called at beginning of scope. The table is allocated in
+ *	the session's arena.
+ */
+symbol_table_t *st_new(compile_session_t *cs);
+
+/*
+ * The pre-defined variables are in one read-only table, built at
+ * compile time and shared by every compile. It is searched after the
+ * outermost scope, whose parent is NULL. The ID of a pre-defined
+ * variable is its index in the table.
  */
-symbol_table_t *st_new();
+#define NUM_BUILTIN_VARS 13
+
+/* The index of the pre-defined variable spelt by the len characters at
+ * name, or -1. Takes constant time. */
+int st_builtin_index(const char *name, size_t len);
+
+/* The pre-defined variable id, or NULL. Its entry is shared by every
+ * compile, so it is read-only. */
+const struct st_entry *st_builtin(ident_t id);
 
-/* Insert a new entry into st_curr */
-void st_insert(char *var_name, type_t type, int is_cnst);
+/* Insert a new entry into the session's st_curr, returning it. A name
+ * declared twice keeps its first entry for lookups. */
+struct st_entry *st_insert(compile_session_t *cs, ident_t id, type_t type, int is_cnst);
 
-/* Lookup an entry */
-struct st_entry *st_lookup(symbol_table_t *st, char *var_name, scope_t scope);
+/* Lookup an entry, counting the lookup in the session's stats. A NULL
+ * st is the pre-defined variables. */
+const struct st_entry *st_lookup(compile_session_t *cs, symbol_table_t *st, ident_t id, scope_t scope);
 
 #endif /* _SYMBOL_H */
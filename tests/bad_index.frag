@@ -0,0 +1,7 @@
+{
+  vec4 a = gl_Color;
+  vec2 b = vec2(1.0, 2.0);
+  a[5] = 1.0;
+  gl_FragColor[7] = a[4];
+  gl_FragColor[0] = b[2];
+}
@@ -0,0 +1,7 @@
+{
+  vec4 a = gl_Color + vec4(1.0, 2.0, 3.0, 4.0, 5.0, 6.0);
+  float x = dp3(a, a, a) + rsq(1.0, 2.0, 3.0, 4.0, 5.0);
+  vec3 b = vec3(x, x);
+  gl_FragColor = a * lit(a);
+  gl_FragColor[0] = x + b[0];
+}
@@ -0,0 +1,4 @@
+{
+  float x = ((gl_Color[0] * gl_Color[2]) + ((gl_Color[0] * gl_Color[1]) + ((gl_Color[0] * gl_Color[0]) + ((gl_Color[0] * gl_Color[2]) + ((gl_Color[0] * gl_Color[1]) + ((gl_Color[0] * gl_Color[0]) + ((gl_Color[0] * gl_Color[2]) + ((gl_Color[0] * gl_Color[1]) + ((gl_Color[0] * gl_Color[0]) + ((gl_Color[0] * gl_Color[2]) + ((gl_Color[0] * gl_Color[1]) + ((gl_Color[0] * gl_Color[0]) + ((gl_Color[0] * gl_Color[2]) + ((gl_Color[0] * gl_Color[1]) + ((gl_Color[0] * gl_Color[0]) + ((gl_Color[0] * gl_Color[2]) + ((gl_Color[0] * gl_Color[1]) + ((gl_Color[0] * gl_Color[0]) + ((gl_Color[0] * gl_Color[2]) + ((gl_Color[0] * gl_Color[1]) + ((gl_Color[0] * gl_Color[0]) + ((gl_Color[0] * gl_Color[2]) + ((gl_Color[0] * gl_Color[1]) + ((gl_Color[0] * gl_Color[0]) + ((gl_Color[0] * gl_Color[2]) + ((gl_Color[0] * gl_Color[1]) + ((gl_Color[0] * gl_Color[0]) + ((gl_Color[0] * gl_Color[2]) + ((gl_Color[0] * gl_Color[1]) + ((gl_Color[0] * gl_Color[0]) + gl_Color[3]))))))))))))))))))))))))))))));
+  gl_FragColor = vec4(x, x, x, x);
+}
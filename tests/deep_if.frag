@@ -0,0 +1,55 @@
+{
+  vec4 c = gl_Color;
+  if (c[0] > 0.0) {
+    if (c[0] > 1.0) {
+      if (c[0] > 2.0) {
+        if (c[0] > 3.0) {
+          if (c[0] > 4.0) {
+            if (c[0] > 5.0) {
+              if (c[0] > 6.0) {
+                if (c[0] > 7.0) {
+                  if (c[0] > 8.0) {
+                    if (c[0] > 9.0) {
+                      if (c[0] > 10.0) {
+                        if (c[0] > 11.0) {
+                          if (c[0] > 12.0) {
+                            if (c[0] > 13.0) {
+                              if (c[0] > 14.0) {
+                                if (c[0] > 15.0) {
+                                  if (c[0] > 16.0) {
+                                    if (c[0] > 17.0) {
+                                      if (c[0] > 18.0) {
+                                        if (c[0] > 19.0) {
+                                          if (c[0] > 20.0) {
+                                            if (c[0] > 21.0) {
+                                              if (c[0] > 22.0) {
+                                                if (c[0] > 23.0) {
+                                                  if (c[0] > 24.0) {
+                                                    c[1] = c[1] + 1.0;
+                                                  } else c[2] = c[2] + 1.0;
+                                                } else c[2] = c[2] + 1.0;
+                                              } else c[2] = c[2] + 1.0;
+                                            } else c[2] = c[2] + 1.0;
+                                          } else c[2] = c[2] + 1.0;
+                                        } else c[2] = c[2] + 1.0;
+                                      } else c[2] = c[2] + 1.0;
+                                    } else c[2] = c[2] + 1.0;
+                                  } else c[2] = c[2] + 1.0;
+                                } else c[2] = c[2] + 1.0;
+                              } else c[2] = c[2] + 1.0;
+                            } else c[2] = c[2] + 1.0;
+                          } else c[2] = c[2] + 1.0;
+                        } else c[2] = c[2] + 1.0;
+                      } else c[2] = c[2] + 1.0;
+                    } else c[2] = c[2] + 1.0;
+                  } else c[2] = c[2] + 1.0;
+                } else c[2] = c[2] + 1.0;
+              } else c[2] = c[2] + 1.0;
+            } else c[2] = c[2] + 1.0;
+          } else c[2] = c[2] + 1.0;
+        } else c[2] = c[2] + 1.0;
+      } else c[2] = c[2] + 1.0;
+    } else c[2] = c[2] + 1.0;
+  } else c[2] = c[2] + 1.0;
+  gl_FragColor = c;
+}
@@ -0,0 +1,179 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * literal_test.c
+ *
+ * Tests of the float literal conversions in literal.c: a table of edge
+ * literals and the floats they must become, a table of floats and the
+ * text they must be written as, and a sweep checking that written
+ * floats convert back to themselves and that parsed literals agree
+ * with strtof().
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../literal.h"
+
+struct parse_case {
+	const char *text;
+	int status;
+	unsigned int bits;	/* when status is LITERAL_OK */
+};
+
+static const struct parse_case parse_cases[] = {
+	{ "0.0", LITERAL_OK, 0x00000000 },
+	{ ".5", LITERAL_OK, 0x3f000000 },
+	{ "0.1", LITERAL_OK, 0x3dcccccd },
+	{ "3.14159265358979323846264338327950288", LITERAL_OK, 0x40490fdb },
+	/* 0x1p-149, the smallest denormal, exactly and as 1e-45 */
+	{ "0.00000000000000000000000000000000000000000000140129846432481707092372958328991613128026194187651577175706828388979108268586060148663818836212158203125",
+	  LITERAL_OK, 0x00000001 },
+	{ "0.000000000000000000000000000000000000000000001", LITERAL_OK, 0x00000001 },
+	/* 0x1p-150, halfway to it, rounds to even; anything above rounds up */
+	{ "0.000000000000000000000000000000000000000000000700649232162408535461864791644958065640130970938257885878534141944895541342930300743319094181060791015625",
+	  LITERAL_OK, 0x00000000 },
+	{ "0.0000000000000000000000000000000000000000000007006492321624085354618647916449580656401309709382578858785341419448955413429303007433190941810607910156251",
+	  LITERAL_OK, 0x00000001 },
+	/* The largest denormal and the smallest normal float */
+	{ "0.00000000000000000000000000000000000001175494210692441075487029444849287348827052428745893333857174530571588870475618904265502351336181163787841796875",
+	  LITERAL_OK, 0x007fffff },
+	{ "0.000000000000000000000000000000000000011754943508222875079687365372222456778186655567720875215087517062784172594547271728515625",
+	  LITERAL_OK, 0x00800000 },
+	/* Halfway between 1 and the next float, and either side of it */
+	{ "1.000000059604644775390625", LITERAL_OK, 0x3f800000 },
+	{ "1.0000000596046447753906250000000001", LITERAL_OK, 0x3f800001 },
+	{ "1.0000000596046447753906249999999999", LITERAL_OK, 0x3f800000 },
+	{ "1.000000178813934326171875", LITERAL_OK, 0x3f800002 },
+	/* Short enough to be converted through a double, whose nearest
+	 * double is the point halfway between two floats, but above it */
+	{ "8.000000476837159", LITERAL_OK, 0x41000001 },
+	{ "8.000000476837158", LITERAL_OK, 0x41000000 },
+	/* FLT_MAX, and halfway from it to 2^128 */
+	{ "340282346638528859811704183484516925440.0", LITERAL_OK, 0x7f7fffff },
+	{ "340282356779733661637539395458142568448.0", LITERAL_RANGE, 0 },
+	{ "1000000000000000000000000000000000000000.0", LITERAL_RANGE, 0 },
+	{ "1000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+	  "0000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+	  "0000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+	  "0000000000.0", LITERAL_HUGE, 0 },
+};
+
+struct format_case {
+	unsigned int bits;
+	const char *text;
+};
+
+static const struct format_case format_cases[] = {
+	{ 0x00000000, "0.0" },
+	{ 0x80000000, "-0.0" },
+	{ 0x3f800000, "1.0" },
+	{ 0xbf800000, "-1.0" },
+	{ 0x3dcccccd, "0.1" },
+	{ 0x3f800001, "1.0000001" },
+	{ 0x00000001, "1.0e-45" },
+	{ 0x80000001, "-1.0e-45" },
+	{ 0x007fffff, "1.1754942e-38" },
+	{ 0x00800000, "1.1754944e-38" },
+	{ 0x7f7fffff, "3.4028235e+38" },
+};
+
+#define NUM_CASES(t) (sizeof(t) / sizeof((t)[0]))
+
+static float from_bits(unsigned int bits){
+	float value;
+
+	memcpy(&value, &bits, sizeof value);
+	return value;
+}
+
+static unsigned int to_bits(float value){
+	unsigned int bits;
+
+	memcpy(&bits, &value, sizeof bits);
+	return bits;
+}
+
+/* Whether the text written for value converts back to it, through
+ * literal_parse_float() when it is a literal the scanner could read */
+static int round_trips(float value){
+	char buf[LITERAL_FLOAT_LEN];
+	float back;
+
+	literal_format_float(buf, value);
+	if(to_bits(strtof(buf, NULL)) != to_bits(value)){
+		printf("FAIL: %08x written as %s\n", to_bits(value), buf);
+		return 0;
+	}
+	if(buf[0] != '-' && strchr(buf, 'e') == NULL &&
+	   (literal_parse_float(buf, &back) != LITERAL_OK || to_bits(back) != to_bits(value))){
+		printf("FAIL: %08x written as %s doesn't parse back\n", to_bits(value), buf);
+		return 0;
+	}
+	return 1;
+}
+
+static unsigned int seed = 467;
+
+static unsigned int next_random(void){
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+/* A random literal of digits.digits, some long enough to need strtod() */
+static void random_literal(char *buf){
+	int i = 0, n;
+
+	for(n = next_random() % 12; n >= 0; n--)
+		buf[i++] = '0' + next_random() % 10;
+	buf[i++] = '.';
+	for(n = next_random() % 30; n >= 0; n--)
+		buf[i++] = '0' + next_random() % 10;
+	buf[i] = '\0';
+}
+
+int main(void){
+	char buf[LITERAL_FLOAT_LEN + 64];
+	unsigned int i, bits, failed = 0;
+	float value;
+	int status;
+
+	for(i = 0; i < NUM_CASES(parse_cases); i++){
+		value = 0;
+		status = literal_parse_float(parse_cases[i].text, &value);
+		if(status != parse_cases[i].status ||
+		   (status == LITERAL_OK && to_bits(value) != parse_cases[i].bits)){
+			printf("FAIL: %.40s... parsed as %08x, status %d\n",
+			       parse_cases[i].text, to_bits(value), status);
+			failed++;
+		}
+	}
+
+	for(i = 0; i < NUM_CASES(format_cases); i++){
+		literal_format_float(buf, from_bits(format_cases[i].bits));
+		if(strcmp(buf, format_cases[i].text)){
+			printf("FAIL: %08x written as %s, not %s\n",
+			       format_cases[i].bits, buf, format_cases[i].text);
+			failed++;
+		}
+		failed += !round_trips(from_bits(format_cases[i].bits));
+	}
+
+	/* Every 4099th finite float, of either sign */
+	for(bits = 0; bits < 0x7f800000; bits += 4099)
+		failed += !round_trips(from_bits(bits)) + !round_trips(from_bits(bits | 0x80000000));
+
+	for(i = 0; i < 100000; i++){
+		random_literal(buf);
+		if(literal_parse_float(buf, &value) != LITERAL_OK ||
+		   to_bits(value) != to_bits(strtof(buf, NULL))){
+			printf("FAIL: %s parsed as %08x, strtof() gives %08x\n",
+			       buf, to_bits(value), to_bits(strtof(buf, NULL)));
+			failed++;
+		}
+	}
+
+	printf("literal_test: %u failures\n", failed);
+	return failed != 0;
+}
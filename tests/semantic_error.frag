@@ -0,0 +1,6 @@
+{
+  float x = 1.0;
+  bool b = x;
+  y = 2.0;
+  gl_FragColor = vec4(x, x, x, x);
+}
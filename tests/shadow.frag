@@ -0,0 +1,8 @@
+{
+  vec4 a = gl_Color;
+  {
+    vec4 a = env1;
+    gl_FragColor = a;
+  }
+  gl_FragColor = gl_FragColor + a;
+}
@@ -0,0 +1,14 @@
+{
+  const float k = 2.0;
+  vec4 a_1 = gl_Color;
+  vec4 a = gl_Color;
+  {
+    const float k = 3.0;
+    vec4 a = env1;
+    if (gl_Color[0] > 0.0) a[0] = k;
+    gl_FragColor = a;
+  }
+  a[1] = k;
+  gl_FragColor = gl_FragColor + a;
+  gl_FragColor = gl_FragColor + a_1;
+}
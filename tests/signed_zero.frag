@@ -0,0 +1,5 @@
+{
+  gl_FragColor = gl_Color;
+  gl_FragColor[0] = gl_Color[0] / (-1.0 * 0.0);
+  gl_FragColor[1] = gl_Color[1] / 0.0;
+}
@@ -0,0 +1,135 @@
+/***********************************************************************
+ * **YOUR GROUP INFO SHOULD GO HERE**
+ *
+ * stress.c
+ *
+ * Thread stress test of libcompiler467: compiles each source file given
+ * once on its own for reference, then from several threads at once,
+ * and checks that every compile returns what the reference did. The
+ * scanner and parser traces and the AST dump are on, so their output is
+ * compared too:
+ *
+ *   stress threads parses file...
+ *
+ * runs parses compiles in each of threads threads, taking the files in
+ * turn.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "../cc467.h"
+
+struct source {
+  char *text;
+  size_t len;
+  int status;                /* of the reference compile */
+  cc467_result ref;
+};
+
+struct stress_ctx {
+  struct source *sources;
+  int numSources;
+  int parses;
+  int mismatches;
+};
+
+static const cc467_options traced = { 0, 1, 1, 1 };
+
+/* The contents of the named file, NULL if it can't be read */
+static char *read_file(const char *fileName, size_t *len) {
+  FILE *f;
+  char *text;
+  long size;
+
+  if ((f = fopen(fileName, "rb")) == NULL)
+    return NULL;
+  fseek(f, 0, SEEK_END);
+  size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if (size < 0) {
+    fclose(f);
+    return NULL;
+  }
+  text = (char *) malloc(size + 1);
+  if (fread(text, 1, size, f) != (size_t) size) {
+    free(text);
+    fclose(f);
+    return NULL;
+  }
+  text[size] = '\0';
+  fclose(f);
+  *len = (size_t) size;
+  return text;
+}
+
+static int same_result(const struct source *s, int status, const cc467_result *res) {
+  return status == s->status && res->arb_len == s->ref.arb_len &&
+         res->diagnostics_len == s->ref.diagnostics_len &&
+         !memcmp(res->arb, s->ref.arb, res->arb_len) &&
+         !memcmp(res->diagnostics, s->ref.diagnostics, res->diagnostics_len);
+}
+
+static void *stress_worker(void *arg) {
+  struct stress_ctx *ctx = (struct stress_ctx *) arg;
+  struct source *s;
+  cc467_result res;
+  int i, status;
+
+  for (i = 0; i < ctx->parses; i++) {
+    s = &ctx->sources[i % ctx->numSources];
+    status = cc467_compile(s->text, s->len, &traced, &res);
+    if (!same_result(s, status, &res))
+      __sync_fetch_and_add(&ctx->mismatches, 1);
+    cc467_result_free(&res);
+  }
+
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  struct stress_ctx ctx;
+  pthread_t *threads;
+  int numThreads, i;
+
+  if (argc < 4 || (numThreads = atoi(argv[1])) < 1 || atoi(argv[2]) < 1) {
+    fprintf(stderr, "usage: stress threads parses file...\n");
+    return 1;
+  }
+
+  ctx.numSources = argc - 3;
+  ctx.parses = atoi(argv[2]);
+  ctx.mismatches = 0;
+  ctx.sources = (struct source *) calloc(ctx.numSources, sizeof(struct source));
+  for (i = 0; i < ctx.numSources; i++) {
+    if ((ctx.sources[i].text = read_file(argv[i + 3], &ctx.sources[i].len)) == NULL) {
+      fprintf(stderr, "stress: cannot read %s\n", argv[i + 3]);
+      return 1;
+    }
+    ctx.sources[i].status = cc467_compile(ctx.sources[i].text, ctx.sources[i].len,
+                                          &traced, &ctx.sources[i].ref);
+    if (ctx.sources[i].status < 0) {
+      fprintf(stderr, "stress: cannot compile %s\n", argv[i + 3]);
+      return 1;
+    }
+  }
+
+  threads = (pthread_t *) malloc(numThreads * sizeof(pthread_t));
+  for (i = 0; i < numThreads; i++)
+    pthread_create(&threads[i], NULL, stress_worker, &ctx);
+  for (i = 0; i < numThreads; i++)
+    pthread_join(threads[i], NULL);
+
+  printf("stress: %d threads x %d parses of %d files: %d mismatches\n",
+         numThreads, ctx.parses, ctx.numSources, ctx.mismatches);
+
+  for (i = 0; i < ctx.numSources; i++) {
+    cc467_result_free(&ctx.sources[i].ref);
+    free(ctx.sources[i].text);
+  }
+  free(ctx.sources);
+  free(threads);
+  return ctx.mismatches != 0;
+}
@@ -0,0 +1,5 @@
+{
+  float x = 1.0;
+  x = x +;
+  gl_FragColor = vec4(x, x, x, x);
+}
@@ -0,0 +1,5 @@
+{
+  gl_FragColor = gl_Color;
+}
+/* never closed
+